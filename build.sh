@@ -1 +1 @@
-clang++ -std=c++17 -o dsharp dsharp.cpp
+clang++ -std=c++17 -pthread -o dsharp dsharp.cpp
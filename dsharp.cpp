@@ -1,25 +1,52 @@
 #include <iostream>
 #include <optional>
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 #include <string>
 #include <variant>
 #include <vector>
 #include <sstream>
-#include <fstream>
 #include <stdarg.h>
 #include <limits>
-#include <forward_list>
 #include <unordered_map>
+#include <string_view>
+#include <chrono>
+#include <array>
+#include <charconv>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <unordered_set>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#include <elf.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <cstddef>
 
 //
 //
 // TODOS:
-// - HandleUTF8
-//		Tokenizer currently only really supports ASCII.
 // - HandleStringData
-//		Identifier and string literal Tokens currently point to the source code.
-// - TypeEquality
-//		Implement proper equality checks for `Type`s.
+//		String literal Tokens currently point to the source code.
 // - CalculateNumericSize
 //		Calculate floating point literals required size to determine int type.
 // - ImplementParseTypeSignature
@@ -36,6 +63,9 @@
 using PID = size_t;
 using Size = size_t;
 using Address = uint16_t;
+using Symbol_ID = uint32_t;
+using File_ID = uint16_t;
+using Type_ID = uint32_t;
 
 namespace Runtime_Type {
 	using Boolean = bool;
@@ -101,6 +131,79 @@ std::string debug_str(const std::optional<T>& option) {
 	return s.str();
 }
 
+// Sentinel returned for malformed UTF-8. It lies outside the Unicode range
+// so it can't be confused with a real codepoint.
+//
+constexpr char32_t Invalid_Codepoint = 0x110000;
+
+// Decodes the UTF-8 sequence at `p`. Returns its length in bytes, 0 if it's
+// malformed (bad lead or continuation byte, overlong, surrogate or out of
+// range), or -1 if it's a valid prefix that `end` cuts short.
+//
+int decode_utf8(const char *p, const char *end, char32_t *out) {
+	unsigned char lead = p[0];
+	if (lead < 0x80) {
+		*out = lead;
+		return 1;
+	}
+
+	int size;
+	char32_t c, min;
+	if ((lead & 0xE0) == 0xC0) {
+		size = 2; c = lead & 0x1F; min = 0x80;
+	} else if ((lead & 0xF0) == 0xE0) {
+		size = 3; c = lead & 0x0F; min = 0x800;
+	} else if ((lead & 0xF8) == 0xF0) {
+		size = 4; c = lead & 0x07; min = 0x10000;
+	} else {
+		return 0;
+	}
+
+	for (int i = 1; i < size; i++) {
+		if (p + i >= end) return -1;
+
+		unsigned char b = p[i];
+		if ((b & 0xC0) != 0x80) return 0;
+		c = (c << 6) | (b & 0x3F);
+	}
+
+	if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+		return 0;
+	}
+
+	*out = c;
+	return size;
+}
+
+// Writes `c` as UTF-8 followed by a terminator. `out` needs 5 bytes.
+//
+size_t encode_utf8(char32_t c, char *out) {
+	size_t size;
+
+	if (c < 0x80) {
+		out[0] = static_cast<char>(c);
+		size = 1;
+	} else if (c < 0x800) {
+		out[0] = static_cast<char>(0xC0 | (c >> 6));
+		out[1] = static_cast<char>(0x80 | (c & 0x3F));
+		size = 2;
+	} else if (c < 0x10000) {
+		out[0] = static_cast<char>(0xE0 | (c >> 12));
+		out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+		out[2] = static_cast<char>(0x80 | (c & 0x3F));
+		size = 3;
+	} else {
+		out[0] = static_cast<char>(0xF0 | (c >> 18));
+		out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+		out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+		out[3] = static_cast<char>(0x80 | (c & 0x3F));
+		size = 4;
+	}
+
+	out[size] = '\0';
+	return size;
+}
+
 Size minimum_required_size_for_literal(int64_t value) {
 	if (value <= std::numeric_limits<Runtime_Type::Integer8>::max() && value >= std::numeric_limits<Runtime_Type::Integer8>::min()) return sizeof(Runtime_Type::Integer8);
 	if (value <= std::numeric_limits<Runtime_Type::Integer16>::max() && value >= std::numeric_limits<Runtime_Type::Integer16>::min()) return sizeof(Runtime_Type::Integer16);
@@ -160,6 +263,10 @@ struct String {
 		return std::string { chars, size };
 	}
 
+	std::string_view str_view() const {
+		return std::string_view { chars, size };
+	}
+
 	bool operator==(const String& other) const {
 		return size == other.size && memcmp(chars, other.chars, size) == 0;
 	}
@@ -183,15 +290,14 @@ struct Array {
 	T *elems;
 };
 
+// A byte offset into a file registered with `source_files`. Line and
+// column are only worked out when something is printed.
+//
 struct Code_Location {
-	size_t l0, c0;
-	const char *file;
+	uint32_t offset;
+	File_ID file;
 
-	std::string debug_str() const {
-		std::stringstream s;
-		s << file << ':' << l0 + 1 << ':' << c0 + 1;
-		return s.str();
-	}
+	std::string debug_str() const;
 };
 
 //
@@ -200,129 +306,137 @@ struct Code_Location {
 //
 //
 
-template<typename Ok, typename Err = std::string>
-class Result {
-	std::variant<Ok, Err> repr;
+// Everything known about a failure. Diagnostics are only ever built on the
+// error path and live in the `diagnostics` arena, so a `Result` carries a
+// single pointer to one and succeeding never allocates. The message is
+// formatted when the diagnostic is made (its arguments are often
+// temporaries) but the location is only resolved to a line and column when
+// it's printed.
+//
+struct Diagnostic {
+	const char *format; // identifies the kind of error
+	const char *message;
+	bool has_location;
+	Code_Location location;
+
+	// `file` names where a diagnostic without a location came from.
+	void print(FILE *stream, const char *file = nullptr) const;
+};
+
+// What `error` and `try_` return to turn any `Result` into a failure.
+//
+struct Failure {
+	Diagnostic *diagnostic;
+};
+
+// Either a value or the diagnostic explaining why there isn't one. A null
+// `diagnostic` means success, so a `Result<AST *>` is two words. Results
+// are move-only; `try_` moves the value out.
+//
+template<typename Ok>
+class [[nodiscard]] Result {
+	Diagnostic *diagnostic;
+	union {
+		Ok value;
+	};
 
 public:
-	Result(const Ok& ok) {
-		repr = ok;
+	Result(const Ok &ok) : diagnostic(nullptr) {
+		new (&value) Ok(ok);
+	}
+
+	Result(Ok &&ok) : diagnostic(nullptr) {
+		new (&value) Ok(std::move(ok));
+	}
+
+	Result(Failure failure) : diagnostic(failure.diagnostic) { }
+
+	Result(Result &&other) : diagnostic(other.diagnostic) {
+		if (!diagnostic) new (&value) Ok(std::move(other.value));
 	}
 
-	Result(const Err& err) {
-		repr = err;
+	Result(const Result &) = delete;
+	Result &operator=(const Result &) = delete;
+
+	~Result() {
+		if (!diagnostic) value.~Ok();
 	}
 
 	Ok unwrap() {
-		if (std::holds_alternative<Err>(repr)) {
-			std::cerr << std::get<Err>(repr);
+		if (diagnostic) {
+			diagnostic->print(stderr);
 			exit(EXIT_FAILURE);
 		}
-		return std::get<Ok>(repr);
+		return std::move(value);
+	}
+
+	bool is_ok() const {
+		return !diagnostic;
 	}
 
-	bool is_ok() {
-		return std::holds_alternative<Ok>(repr);
+	bool is_err() const {
+		return diagnostic;
 	}
 
-	bool is_err() {
-		return std::holds_alternative<Err>(repr);
+	Ok &ok() {
+		return value;
 	}
 
-	const Ok& ok() {
-		return std::get<Ok>(repr);
+	Ok take() {
+		return std::move(value);
 	}
 
-	const Err& err() {
-		return std::get<std::string>(repr);
+	Diagnostic *err() const {
+		return diagnostic;
 	}
 };
 
-template<typename Err>
-class Result<void, Err> {
-	bool _is_ok;
-	Err _err;
+template<>
+class [[nodiscard]] Result<void> {
+	Diagnostic *diagnostic;
 
 public:
-	Result() : _is_ok(true) { }
+	Result() : diagnostic(nullptr) { }
 
-	Result(const Err& err) : _is_ok(false) {
-		_err = err;
-	}
+	Result(Failure failure) : diagnostic(failure.diagnostic) { }
 
 	void unwrap() {
-		if (!_is_ok) {
-			std::cerr << _err;
+		if (diagnostic) {
+			diagnostic->print(stderr);
 			exit(EXIT_FAILURE);
 		}
 	}
 
-	bool is_ok() {
-		return _is_ok;
+	bool is_ok() const {
+		return !diagnostic;
 	}
 
-	bool is_err() {
-		return !_is_ok;
+	bool is_err() const {
+		return diagnostic;
 	}
 
-	const Err& err() {
-		return _err;
+	void ok() { }
+
+	void take() { }
+
+	Diagnostic *err() const {
+		return diagnostic;
 	}
 };
 
+static_assert(sizeof(Result<void *>) == 2 * sizeof(void *), "`Result` of a pointer should be two words!");
+
 #define try_(expression) ({\
 	auto result = expression;\
-	if (result.is_err()) return { std::move(result.err()) };\
-	result.ok();\
-})
-
-#define error(...) ({\
-	auto result = error_impl(__VA_ARGS__);\
-	assert(result.is_err());\
-	return { std::move(result.err()) };\
+	if (result.is_err()) return Failure { result.err() };\
+	result.take();\
 })
 
-Result<void> error_impl(const char *err, va_list args) {
-	std::stringstream s;
-
-	char *message;
-	vasprintf(&message, err, args);
-
-	s << Color::Red << "Error: " << message << Color::Reset << std::endl;
-
-	free(message);
-	va_end(args);
-
-	return { s.str() };
-}
-
-Result<void> error_impl(const char *err, ...) {
-	va_list args;
-	va_start(args, err);
-
-	return error_impl(err, args);
-}
-
-Result<void> error_impl(Code_Location location, const char *err, va_list args) {
-	std::stringstream s;
-
-	char *message;
-	vasprintf(&message, err, args);
-
-	s << Color::Red << "Error @ " << location.debug_str() << ": " << message << Color::Reset << std::endl;
-
-	free(message);
-	va_end(args);
-
-	return { s.str() };
-}
-
-Result<void> error_impl(Code_Location location, const char *err, ...) {
-	va_list args;
-	va_start(args, err);
+#define error(...) return Failure { error_impl(__VA_ARGS__) }
 
-	return error_impl(location, err, args);
-}
+Diagnostic *error_impl(const char *err, ...);
+Diagnostic *error_impl(Code_Location location, const char *err, ...);
+Diagnostic *error_impl(Code_Location location, const char *err, va_list args);
 
 #define verify(condition, ...) if (!(condition)) error(__VA_ARGS__)
 
@@ -368,6 +482,344 @@ void todo_impl(const char *file, size_t line, const char *fmt, ...) {
 	todo_impl(file, line, fmt, args);
 }
 
+//
+//
+// Arena Allocation
+//
+//
+
+struct Arena {
+	static constexpr size_t Default_Block_Size = 64 * 1024;
+
+	struct Block {
+		Block *next;
+		size_t size;
+		size_t used;
+
+		char *data() {
+			return reinterpret_cast<char *>(this + 1);
+		}
+	};
+
+	// Objects with non-trivial destructors get a `Finalizer` allocated in
+	// front of them so `release()` can tear them down in one pass.
+	//
+	struct Finalizer {
+		Finalizer *next;
+		void (*destroy)(void *object);
+		void *object;
+	};
+
+	Block *blocks = nullptr;
+	Finalizer *finalizers = nullptr;
+	size_t bytes_used = 0;
+	size_t bytes_reserved = 0;
+	size_t block_count = 0;
+	size_t allocation_count = 0;
+
+	Arena() = default;
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+
+	~Arena() {
+		release();
+	}
+
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		internal_verify(alignment <= alignof(std::max_align_t), "Unsupported alignment in arena allocation: %zu!", alignment);
+
+		size_t offset = blocks ? (blocks->used + alignment - 1) & ~(alignment - 1) : 0;
+		if (!blocks || offset + size > blocks->size) {
+			size_t block_size = std::max(Default_Block_Size, size);
+			
+			Block *block = reinterpret_cast<Block *>(malloc(sizeof(Block) + block_size));
+			internal_verify(block, "Failed to allocate arena block of %zu bytes!", block_size);
+			block->next = blocks;
+			block->size = block_size;
+			block->used = 0;
+
+			blocks = block;
+			bytes_reserved += block_size;
+			block_count++;
+			offset = 0;
+		}
+
+		void *memory = blocks->data() + offset;
+		bytes_used += offset + size - blocks->used;
+		blocks->used = offset + size;
+		allocation_count++;
+
+		return memory;
+	}
+
+	template<typename T, typename ...Args>
+	T *make(Args&&... args) {
+		if constexpr (std::is_trivially_destructible<T>::value) {
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		} else {
+			Finalizer *finalizer = reinterpret_cast<Finalizer *>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+			T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+			finalizer->next = finalizers;
+			finalizer->destroy = [](void *object) { reinterpret_cast<T *>(object)->~T(); };
+			finalizer->object = object;
+			finalizers = finalizer;
+
+			return object;
+		}
+	}
+
+	// Destroys every object and gives all blocks back in one go. Pointers into
+	// the arena are invalid afterwards.
+	//
+	void release() {
+		for (Finalizer *f = finalizers; f; f = f->next) {
+			f->destroy(f->object);
+		}
+		finalizers = nullptr;
+
+		while (blocks) {
+			Block *next = blocks->next;
+			::free(blocks);
+			blocks = next;
+		}
+
+		bytes_used = 0;
+		bytes_reserved = 0;
+		block_count = 0;
+		allocation_count = 0;
+	}
+
+	void print_stats(FILE *out, const char *name) const {
+		fprintf(out, "%s: %zu bytes used / %zu bytes reserved in %zu block(s), %zu allocation(s)\n",
+			name,
+			bytes_used,
+			bytes_reserved,
+			block_count,
+			allocation_count
+		);
+	}
+};
+
+//
+//
+// Diagnostics
+//
+//
+
+// Each thread reports into its own arena, so raising an error never locks.
+// Every thread's arena is also listed in `diagnostic_arenas`, so that a
+// process that runs for a long time can free them all once it knows none
+// of their diagnostics are in use.
+//
+struct Diagnostic_Arenas {
+	std::mutex lock;
+	std::vector<Arena *> arenas;
+};
+
+Diagnostic_Arenas diagnostic_arenas;
+
+struct Thread_Diagnostics {
+	Arena arena;
+
+	Thread_Diagnostics() {
+		std::lock_guard<std::mutex> guard { diagnostic_arenas.lock };
+		diagnostic_arenas.arenas.push_back(&arena);
+	}
+
+	~Thread_Diagnostics() {
+		std::lock_guard<std::mutex> guard { diagnostic_arenas.lock };
+		auto &arenas = diagnostic_arenas.arenas;
+		arenas.erase(std::find(arenas.begin(), arenas.end(), &arena));
+	}
+};
+
+thread_local Thread_Diagnostics diagnostics;
+
+// Frees every diagnostic any thread has raised. Only call it while no other
+// thread can be raising one and nothing still points at one.
+//
+void release_diagnostics() {
+	std::lock_guard<std::mutex> guard { diagnostic_arenas.lock };
+	for (Arena *arena : diagnostic_arenas.arenas) {
+		arena->release();
+	}
+}
+
+Diagnostic *make_diagnostic(bool has_location, Code_Location location, const char *err, va_list args) {
+	va_list sizing;
+	va_copy(sizing, args);
+	int size = vsnprintf(nullptr, 0, err, sizing);
+	va_end(sizing);
+
+	char *message = reinterpret_cast<char *>(diagnostics.arena.allocate(std::max(size, 0) + 1, 1));
+	vsnprintf(message, std::max(size, 0) + 1, err, args);
+
+	Diagnostic *diagnostic = diagnostics.arena.make<Diagnostic>();
+	diagnostic->format = err;
+	diagnostic->message = message;
+	diagnostic->has_location = has_location;
+	diagnostic->location = location;
+
+	return diagnostic;
+}
+
+Diagnostic *error_impl(const char *err, ...) {
+	va_list args;
+	va_start(args, err);
+	Diagnostic *diagnostic = make_diagnostic(false, Code_Location {}, err, args);
+	va_end(args);
+
+	return diagnostic;
+}
+
+Diagnostic *error_impl(Code_Location location, const char *err, ...) {
+	va_list args;
+	va_start(args, err);
+	Diagnostic *diagnostic = make_diagnostic(true, location, err, args);
+	va_end(args);
+
+	return diagnostic;
+}
+
+// For callers that take their own format arguments. `args` is left for
+// the caller to `va_end`.
+//
+Diagnostic *error_impl(Code_Location location, const char *err, va_list args) {
+	return make_diagnostic(true, location, err, args);
+}
+
+void Diagnostic::print(FILE *stream, const char *file) const {
+	if (has_location) {
+		fprintf(stream, "%sError @ %s: %s%s\n", Color::Red, location.debug_str().c_str(), message, Color::Reset);
+	} else if (file) {
+		fprintf(stream, "%sError @ %s: %s%s\n", Color::Red, file, message, Color::Reset);
+	} else {
+		fprintf(stream, "%sError: %s%s\n", Color::Red, message, Color::Reset);
+	}
+}
+
+//
+//
+// Interning
+//
+//
+
+// Append-only array whose elements never move, for the tables shared by
+// every compile job. Any thread may append, and indexing never locks: a
+// reader can only have learned an index from whoever appended it, which
+// already orders the element's write before the read.
+//
+template<typename T, size_t Page_Size = 4096, size_t Max_Pages = 4096>
+struct Paged_Array {
+	std::atomic<T *> pages[Max_Pages] = {};
+	std::atomic<size_t> next { 0 };
+
+	Paged_Array() = default;
+	Paged_Array(const Paged_Array &) = delete;
+	Paged_Array &operator=(const Paged_Array &) = delete;
+
+	~Paged_Array() {
+		for (auto &page : pages) {
+			delete[] page.load(std::memory_order_relaxed);
+		}
+	}
+
+	size_t push(T value) {
+		size_t index = next.fetch_add(1, std::memory_order_relaxed);
+		internal_verify(index < Page_Size * Max_Pages, "Paged_Array is full!");
+
+		std::atomic<T *> &slot = pages[index / Page_Size];
+		T *page = slot.load(std::memory_order_acquire);
+		if (!page) {
+			T *fresh = new T[Page_Size];
+			if (slot.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+				page = fresh;
+			} else {
+				delete[] fresh;
+			}
+		}
+
+		page[index % Page_Size] = std::move(value);
+		return index;
+	}
+
+	T &operator[](size_t index) const {
+		return pages[index / Page_Size].load(std::memory_order_acquire)[index % Page_Size];
+	}
+
+	size_t size() const {
+		return next.load(std::memory_order_acquire);
+	}
+};
+
+// Every distinct identifier is stored exactly once and handed a dense
+// `Symbol_ID`, so later passes compare and hash plain integers.
+//
+struct Interner {
+	static constexpr size_t Shard_Count = 16;
+
+	// Lookups are split across shards by hash so jobs interning at the same
+	// time rarely wait on each other.
+	//
+	struct Shard {
+		std::mutex lock;
+		std::unordered_map<std::string_view, Symbol_ID> ids;
+		Arena storage;
+	};
+
+	Shard shards[Shard_Count];
+	Paged_Array<String> strings;
+
+	Symbol_ID intern(String s) {
+		// Identifiers repeat constantly within a file, so each thread keeps
+		// the ids it has already seen and only takes a shard lock for new
+		// ones. The keys point into shard storage, which never moves.
+		static thread_local std::unordered_map<std::string_view, Symbol_ID> seen;
+
+		std::string_view key { s.chars, s.size };
+		auto cached = seen.find(key);
+		if (cached != seen.end()) {
+			return cached->second;
+		}
+
+		Symbol_ID id = intern_shared(key);
+		seen.emplace(get(id).str_view(), id);
+		return id;
+	}
+
+	String get(Symbol_ID id) const {
+		internal_verify(id < strings.size(), "Invalid symbol id: %u!", id);
+		return strings[id];
+	}
+
+private:
+	Symbol_ID intern_shared(std::string_view key) {
+		size_t hash = std::hash<std::string_view> {}(key);
+		Shard &shard = shards[hash % Shard_Count];
+
+		std::lock_guard<std::mutex> guard(shard.lock);
+
+		auto it = shard.ids.find(key);
+		if (it != shard.ids.end()) {
+			return it->second;
+		}
+
+		String s { key.size(), const_cast<char *>(key.data()) };
+
+		char *chars = reinterpret_cast<char *>(shard.storage.allocate(s.size, 1));
+		memcpy(chars, s.chars, s.size);
+
+		size_t id = strings.push(String { s.size, chars });
+		internal_verify(id < std::numeric_limits<Symbol_ID>::max(), "Too many distinct symbols!");
+		shard.ids.emplace(std::string_view { chars, s.size }, static_cast<Symbol_ID>(id));
+
+		return static_cast<Symbol_ID>(id);
+	}
+};
+
+Interner interner;
+
 //
 //
 // Type
@@ -382,6 +834,7 @@ enum class Type_Kind {
 	Integer,
 	Floating_Point,
 	String,
+	Function,
 };
 
 std::string debug_str(Type_Kind kind) {
@@ -409,6 +862,9 @@ std::string debug_str(Type_Kind kind) {
 		case Type_Kind::String: {
 			s = "String";
 		} break;
+		case Type_Kind::Function: {
+			s = "Function";
+		} break;
 
 		default:
 			s = std::to_string(static_cast<int>(kind));
@@ -422,8 +878,15 @@ struct Primitive_Type_Data {
 	Size size;
 };
 
+struct Function_Type_Data {
+	const Type_ID *parameters; // in `Type_Table::storage`
+	uint32_t parameter_count;
+	Type_ID return_type;
+};
+
 union Type_Data {
 	Primitive_Type_Data primitive;
+	Function_Type_Data function;
 };
 
 struct Type {
@@ -546,13 +1009,141 @@ struct Type {
 	}
 };
 
+// Every distinct type exists exactly once in `type_table` and is referred
+// to by its dense `Type_ID`, so two types are equal exactly when their IDs
+// are. The primitive types are interned up front at fixed IDs; compound
+// types (functions so far) are hash-consed on their structure.
+//
+constexpr Type_ID Untyped = std::numeric_limits<Type_ID>::max();
+
+struct Type_Table {
+	static constexpr Type_ID No_Type   = 0;
+	static constexpr Type_ID Null      = 1;
+	static constexpr Type_ID Boolean   = 2;
+	static constexpr Type_ID Character = 3;
+	static constexpr Type_ID String    = 4;
+	static constexpr Type_ID Integer8  = 5;
+	static constexpr Type_ID Integer16 = 6;
+	static constexpr Type_ID Integer32 = 7;
+	static constexpr Type_ID Integer64 = 8;
+	static constexpr Type_ID Float32   = 9;
+	static constexpr Type_ID Float64   = 10;
+
+	Paged_Array<Type> types;
+
+	// Guards interning compound types. Reading `types` never locks.
+	std::mutex lock;
+	std::unordered_map<std::string, Type_ID> compound_ids;
+	Arena storage;
+
+	Type_Table() {
+		types.push(Type { Type_Kind::No_Type });
+		types.push(Type { Type_Kind::Null });
+		types.push(Type::Boolean());
+		types.push(Type::Character());
+		types.push(Type::String());
+		types.push(Type::Integer(1));
+		types.push(Type::Integer(2));
+		types.push(Type::Integer(4));
+		types.push(Type::Integer(8));
+		types.push(Type::Floating_Point(4));
+		types.push(Type::Floating_Point(8));
+	}
+
+	const Type &operator[](Type_ID id) const {
+		internal_verify(id < types.size(), "Invalid type id: %u!", id);
+		return types[id];
+	}
+
+	Type_ID integer(Size size) const {
+		switch (size) {
+			case 1: return Integer8;
+			case 2: return Integer16;
+			case 4: return Integer32;
+			case 8: return Integer64;
+		}
+		internal_error("Invalid integer size: %zu!", size);
+		return Untyped;
+	}
+
+	Type_ID floating_point(Size size) const {
+		switch (size) {
+			case 4: return Float32;
+			case 8: return Float64;
+		}
+		internal_error("Invalid floating point size: %zu!", size);
+		return Untyped;
+	}
+
+	Type_ID function(const Type_ID *parameter_types, size_t parameter_count, Type_ID return_type) {
+		std::string key;
+		key.push_back(static_cast<char>(Type_Kind::Function));
+		key.append(reinterpret_cast<const char *>(&return_type), sizeof(return_type));
+		key.append(reinterpret_cast<const char *>(parameter_types), parameter_count * sizeof(Type_ID));
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		auto it = compound_ids.find(key);
+		if (it != compound_ids.end()) return it->second;
+
+		Type_ID *parameters = reinterpret_cast<Type_ID *>(storage.allocate(parameter_count * sizeof(Type_ID), alignof(Type_ID)));
+		std::copy(parameter_types, parameter_types + parameter_count, parameters);
+
+		Type type = { Type_Kind::Function };
+		type.data.function.parameters = parameters;
+		type.data.function.parameter_count = static_cast<uint32_t>(parameter_count);
+		type.data.function.return_type = return_type;
+
+		Type_ID id = static_cast<Type_ID>(types.push(type));
+		compound_ids.emplace(std::move(key), id);
+
+		return id;
+	}
+
+	Array<const Type_ID> parameters_of(Type_ID function_type) const {
+		const Type &type = (*this)[function_type];
+		internal_verify(type.kind == Type_Kind::Function, "`%s` isn't a function type!", type.debug_str().c_str());
+		return Array<const Type_ID> { type.data.function.parameter_count, type.data.function.parameters };
+	}
+
+	std::string debug_str(Type_ID id) const {
+		if (id == Untyped) return "None";
+		return "Some(" + str(id, false) + ")";
+	}
+
+	std::string display_str(Type_ID id) const {
+		return str(id, true);
+	}
+
+private:
+	std::string str(Type_ID id, bool display) const {
+		const Type &type = (*this)[id];
+		if (type.kind != Type_Kind::Function) {
+			return display ? type.display_str() : type.debug_str();
+		}
+
+		std::string s = display ? "fn(" : "Function(";
+		Array<const Type_ID> parameter_types = parameters_of(id);
+		for (size_t i = 0; i < parameter_types.count; i++) {
+			if (i > 0) s += ", ";
+			s += str(parameter_types.elems[i], display);
+		}
+		s += ") -> ";
+		s += str(type.data.function.return_type, display);
+
+		return s;
+	}
+};
+
+Type_Table type_table;
+
 //
 //
 // AST
 //
 //
 
-enum class AST_Kind {
+enum class AST_Kind : uint8_t {
 	Symbol_Identifier,
 
 	Literal_Null,
@@ -576,6 +1167,7 @@ enum class AST_Kind {
 	Binary_Or,
 	Binary_EQ,
 	Binary_NE,
+	Binary_Call,
 
 	Block,
 	Block_Comma,
@@ -610,6 +1202,7 @@ std::string debug_str(AST_Kind kind) {
 		CASE(Binary_Or);
 		CASE(Binary_EQ);
 		CASE(Binary_NE);
+		CASE(Binary_Call);
 		CASE(Block);
 		CASE(Block_Comma);
 		CASE(Variable_Instantiation);
@@ -626,32 +1219,36 @@ std::string debug_str(AST_Kind kind) {
 
 struct AST {
 	AST_Kind kind;
-	std::optional<Type> type;
+	Type_ID type = Untyped;
 	Code_Location location;
 
-	virtual ~AST() {}
-
-	void debug_print(size_t indentation = 0) const;
+	void debug_print(FILE *out, size_t indentation = 0) const;
 
 protected:
-	void print_base_members(size_t indentation) const {
-		printf("%*skind: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", debug_str(kind).c_str());
-		printf("%*stype: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", debug_str(type).c_str());
-		printf("%*slocation: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", location.debug_str().c_str());
+	void print_base_members(FILE *out, size_t indentation) const {
+		fprintf(out, "%*skind: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", debug_str(kind).c_str());
+		fprintf(out, "%*stype: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", type_table.debug_str(type).c_str());
+		fprintf(out, "%*slocation: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", location.debug_str().c_str());
 	}
 
-	void print_member(const char *name, size_t indentation, AST *member) const {
-		printf("%*s%s: ", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", name);
-		member->debug_print(indentation + 1);
+	void print_member(FILE *out, const char *name, size_t indentation, AST *member) const {
+		fprintf(out, "%*s%s: ", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", name);
+		member->debug_print(out, indentation + 1);
 	}
 
-	void print_unary(const struct AST_Unary *unary, size_t indentation) const;
-	void print_binary(const struct AST_Binary *binary, size_t indentation) const;
-	void print_block(const struct AST_Block *block, size_t indentation) const;
+	void print_unary(FILE *out, const struct AST_Unary *unary, size_t indentation) const;
+	void print_binary(FILE *out, const struct AST_Binary *binary, size_t indentation) const;
+	void print_block(FILE *out, const struct AST_Block *block, size_t indentation) const;
 };
 
 struct AST_Symbol : AST {
-	String symbol;
+	Symbol_ID symbol;
+
+	// Filled in by the typechecker: where a variable lives in its function's
+	// frame, or which function a name refers to.
+	//
+	uint32_t slot = 0;
+	PID pid = 0;
 };
 
 struct AST_Literal : AST {
@@ -701,109 +1298,242 @@ struct AST_Function_Declaration : AST {
 	//
 	AST *return_type_signature; // optional
 	AST_Block *body;
+	PID pid = 0; // set by the typechecker
 };
 
-void AST::debug_print(size_t indentation) const {
-	#define CASE_UNARY(kind) case AST_Kind::kind: {\
-		const AST_Unary *self = dynamic_cast<const AST_Unary *>(this);\
-		internal_verify(self, "Failed to cast to `const AST_Unary *`");\
-		printf("`%s`:\n", debug_str(AST_Kind::kind).c_str());\
-		print_unary(self, indentation);\
-	} break
-	
-	#define CASE_BINARY(kind) case AST_Kind::kind: {\
-		const AST_Binary *self = dynamic_cast<const AST_Binary *>(this);\
-		internal_verify(self, "Faield to cast to `const AST_Binary *`");\
-		printf("`%s`:\n", debug_str(AST_Kind::kind).c_str());\
-		print_binary(self, indentation);\
-	} break
+// The concrete node type behind every `AST_Kind`, in declaration order.
+//
+#define AST_KIND_TYPES(X) \
+	X(Symbol_Identifier,           AST_Symbol) \
+	X(Literal_Null,                AST_Literal) \
+	X(Literal_Boolean,             AST_Literal) \
+	X(Literal_Character,           AST_Literal) \
+	X(Literal_Integer,             AST_Literal) \
+	X(Literal_Floating_Point,      AST_Literal) \
+	X(Literal_String,              AST_Literal) \
+	X(Unary_Not,                   AST_Unary) \
+	X(Unary_Negate,                AST_Unary) \
+	X(Binary_Variable_Declaration, AST_Binary) \
+	X(Binary_Assignment,           AST_Binary) \
+	X(Binary_While,                AST_Binary) \
+	X(Binary_Add,                  AST_Binary) \
+	X(Binary_Subtract,             AST_Binary) \
+	X(Binary_Multiply,             AST_Binary) \
+	X(Binary_Divide,               AST_Binary) \
+	X(Binary_And,                  AST_Binary) \
+	X(Binary_Or,                   AST_Binary) \
+	X(Binary_EQ,                   AST_Binary) \
+	X(Binary_NE,                   AST_Binary) \
+	X(Binary_Call,                 AST_Binary) \
+	X(Block,                       AST_Block) \
+	X(Block_Comma,                 AST_Block) \
+	X(Variable_Instantiation,      AST_Variable_Instantiation) \
+	X(Constant_Instantiation,      AST_Variable_Instantiation) \
+	X(Function_Declaration,        AST_Function_Declaration) \
+	X(If,                          AST_If)
+
+constexpr AST_Kind AST_Kinds[] = {
+	#define X(kind, type) AST_Kind::kind,
+	AST_KIND_TYPES(X)
+	#undef X
+};
+
+constexpr size_t AST_Kind_Count = sizeof(AST_Kinds) / sizeof(AST_Kinds[0]);
+
+constexpr bool ast_kind_table_is_ordered() {
+	for (size_t i = 0; i < AST_Kind_Count; i++) {
+		if (static_cast<size_t>(AST_Kinds[i]) != i) return false;
+	}
+	return static_cast<size_t>(AST_Kind::If) + 1 == AST_Kind_Count;
+}
+
+static_assert(ast_kind_table_is_ordered(), "`AST_KIND_TYPES` must list every `AST_Kind` in declaration order!");
+
+// Whether a node of `kind` is a `T`.
+//
+template<typename T>
+constexpr bool ast_is(AST_Kind kind) {
+	if (std::is_same<T, AST>::value) return true;
+
+	switch (kind) {
+		#define X(kind, type) case AST_Kind::kind: return std::is_same<T, type>::value;
+		AST_KIND_TYPES(X)
+		#undef X
+	}
+
+	return false;
+}
+
+// Downcasts on the strength of `kind` alone. Only checked in debug builds, so
+// callers must already know the kind matches; use `ast_cast_if` otherwise.
+//
+template<typename T>
+T *ast_cast(AST *node) {
+#ifndef NDEBUG
+	internal_verify(ast_is<T>(node->kind), "Bad AST cast of `%s` node!", debug_str(node->kind).c_str());
+#endif
+	return static_cast<T *>(node);
+}
+
+template<typename T>
+const T *ast_cast(const AST *node) {
+#ifndef NDEBUG
+	internal_verify(ast_is<T>(node->kind), "Bad AST cast of `%s` node!", debug_str(node->kind).c_str());
+#endif
+	return static_cast<const T *>(node);
+}
+
+template<typename T>
+T *ast_cast_if(AST *node) {
+	return ast_is<T>(node->kind) ? static_cast<T *>(node) : nullptr;
+}
+
+// Calls `visitor` with `node` downcast to its concrete type. Dispatch is a
+// single indexed call through a table built from `AST_KIND_TYPES`, so a pass
+// written as an overload set (or a generic lambda) never switches on kinds
+// itself. Every overload must return the same type.
+//
+template<typename Visitor>
+decltype(auto) visit(AST *node, Visitor &&visitor) {
+	using Visitor_Type = std::remove_reference_t<Visitor>;
+	using Return_Type = decltype(visitor(static_cast<AST_Symbol *>(node)));
+	using Thunk = Return_Type (*)(AST *, Visitor_Type &);
+
+	static constexpr Thunk Table[] = {
+		#define X(kind, type) [](AST *n, Visitor_Type &v) -> Return_Type { return v(static_cast<type *>(n)); },
+		AST_KIND_TYPES(X)
+		#undef X
+	};
+
+	return Table[static_cast<size_t>(node->kind)](node, visitor);
+}
+
+// Calls `f` on each of `node`'s children in source order. Type signatures
+// are skipped; they're names, not code.
+//
+template<typename F>
+void for_each_child(AST *node, F &&f) {
+	struct Children {
+		F &f;
+
+		void operator()(AST_Symbol *) {}
+		void operator()(AST_Literal *) {}
+		void operator()(AST_Unary *node) { f(node->sub); }
+		void operator()(AST_Binary *node) { f(node->lhs); f(node->rhs); }
+
+		void operator()(AST_Block *node) {
+			for (AST *child : node->nodes) f(child);
+		}
+
+		void operator()(AST_Variable_Instantiation *node) {
+			f(node->symbol);
+			f(node->initializer);
+		}
+
+		void operator()(AST_Function_Declaration *node) {
+			f(node->parameters);
+			f(node->body);
+		}
+
+		void operator()(AST_If *node) {
+			f(node->condition);
+			f(node->then_block);
+			if (node->else_block) f(node->else_block);
+		}
+	};
+
+	visit(node, Children { f });
+}
+
+void AST::debug_print(FILE *out, size_t indentation) const {
+	#define CASE_UNARY(kind) case AST_Kind::kind: {\
+		const AST_Unary *self = ast_cast<AST_Unary>(this);\
+		fprintf(out, "`%s`:\n", debug_str(AST_Kind::kind).c_str());\
+		print_unary(out, self, indentation);\
+	} break
+	
+	#define CASE_BINARY(kind) case AST_Kind::kind: {\
+		const AST_Binary *self = ast_cast<AST_Binary>(this);\
+		fprintf(out, "`%s`:\n", debug_str(AST_Kind::kind).c_str());\
+		print_binary(out, self, indentation);\
+	} break
 
 	#define CASE_BLOCK(kind) case AST_Kind::kind: {\
-		const AST_Block *self = dynamic_cast<const AST_Block *>(this);\
-		internal_verify(self, "Failed to cast to `const AST_Block *`");\
-		printf("`%s`:\n", debug_str(AST_Kind::kind).c_str());\
-		print_block(self, indentation);\
+		const AST_Block *self = ast_cast<AST_Block>(this);\
+		fprintf(out, "`%s`:\n", debug_str(AST_Kind::kind).c_str());\
+		print_block(out, self, indentation);\
 	} break
 
 	switch (kind) {
 		case AST_Kind::Symbol_Identifier: {
-			const AST_Symbol *self = dynamic_cast<const AST_Symbol *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Symbol *`");
+			const AST_Symbol *self = ast_cast<AST_Symbol>(this);
 
-			printf("`Symbol_Identifier`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Symbol_Identifier`:\n");
+			print_base_members(out, indentation);
 
-			printf("%*sid: `%.*s`\n",
+			String symbol = interner.get(self->symbol);
+			fprintf(out, "%*sid: `%.*s`\n",
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
-				static_cast<int>(self->symbol.size), self->symbol.chars
+				static_cast<int>(symbol.size), symbol.chars
 			);
 		} break;
 		case AST_Kind::Literal_Null: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
-
-			printf("`Literal_Null`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_Null`:\n");
+			print_base_members(out, indentation);
 		} break;
 		case AST_Kind::Literal_Boolean: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
+			const AST_Literal *self = ast_cast<AST_Literal>(this);
 
-			printf("`Literal_Boolean`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_Boolean`:\n");
+			print_base_members(out, indentation);
 
-			printf("%*svalue: %s\n",
+			fprintf(out, "%*svalue: %s\n",
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
 				self->as.boolean ? "true" : "false"
 			);
 		} break;
 		case AST_Kind::Literal_Character: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
+			const AST_Literal *self = ast_cast<AST_Literal>(this);
 
-			printf("`Literal_Character`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_Character`:\n");
+			print_base_members(out, indentation);
 
-			// @TOOD:
-			// :HandleUTF8
-			//
-			printf("%*svalue: %c\n",
+			char utf8[5];
+			encode_utf8(self->as.character, utf8);
+			fprintf(out, "%*svalue: %s\n",
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
-				self->as.character
+				utf8
 			);
 		} break;
 		case AST_Kind::Literal_Integer: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
+			const AST_Literal *self = ast_cast<AST_Literal>(this);
 
-			printf("`Literal_Integer`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_Integer`:\n");
+			print_base_members(out, indentation);
 
-			printf("%*svalue: %lld\n", 
+			fprintf(out, "%*svalue: %lld\n", 
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
 				self->as.integer
 			);
 		} break;
 		case AST_Kind::Literal_Floating_Point: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
+			const AST_Literal *self = ast_cast<AST_Literal>(this);
 
-			printf("`Literal_Floating_Point`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_Floating_Point`:\n");
+			print_base_members(out, indentation);
 
-			printf("%*svalue: %f\n", 
+			fprintf(out, "%*svalue: %f\n", 
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
 				self->as.floating_point
 			);
 		} break;
 		case AST_Kind::Literal_String: {
-			const AST_Literal *self = dynamic_cast<const AST_Literal *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal *`");
+			const AST_Literal *self = ast_cast<AST_Literal>(this);
 
-			printf("`Literal_String`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`Literal_String`:\n");
+			print_base_members(out, indentation);
 
-			printf("%*svalue: %.*s\n",
+			fprintf(out, "%*svalue: %.*s\n",
 				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
 				static_cast<int>(self->as.string.size), self->as.string.chars
 			);
@@ -823,43 +1553,41 @@ void AST::debug_print(size_t indentation) const {
 		CASE_BINARY(Binary_Or);
 		CASE_BINARY(Binary_EQ);
 		CASE_BINARY(Binary_NE);
+		CASE_BINARY(Binary_Call);
 
 		CASE_BLOCK(Block);
 		CASE_BLOCK(Block_Comma);
 
 		case AST_Kind::Variable_Instantiation:
 		case AST_Kind::Constant_Instantiation: {
-			const AST_Variable_Instantiation *self = dynamic_cast<const AST_Variable_Instantiation *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Literal_Instantiation *`");
+			const AST_Variable_Instantiation *self = ast_cast<AST_Variable_Instantiation>(this);
 
-			printf("`%s`:\n", debug_str(kind).c_str());
-			print_base_members(indentation);
+			fprintf(out, "`%s`:\n", debug_str(kind).c_str());
+			print_base_members(out, indentation);
 
-			print_member("symbol", indentation, self->symbol);
-			if (self->specified_type_signature) print_member("type", indentation, self->specified_type_signature);
-			print_member("initializer", indentation, self->initializer);
+			print_member(out, "symbol", indentation, self->symbol);
+			if (self->specified_type_signature) print_member(out, "type", indentation, self->specified_type_signature);
+			print_member(out, "initializer", indentation, self->initializer);
 		} break;
 		case AST_Kind::Function_Declaration: {
-			const AST_Function_Declaration *self = dynamic_cast<const AST_Function_Declaration *>(this);
-			internal_verify(self, "Failed to cast to `const AST_Function_Declaration *`");
+			const AST_Function_Declaration *self = ast_cast<AST_Function_Declaration>(this);
 
-			printf("`%s`:\n", debug_str(kind).c_str());
-			print_base_members(indentation);
+			fprintf(out, "`%s`:\n", debug_str(kind).c_str());
+			print_base_members(out, indentation);
 
-			print_member("parameters", indentation, self->parameters);
-			if (self->return_type_signature) print_member("return", indentation, self->return_type_signature);
-			print_member("body", indentation, self->body);
+			print_member(out, "parameters", indentation, self->parameters);
+			if (self->return_type_signature) print_member(out, "return", indentation, self->return_type_signature);
+			print_member(out, "body", indentation, self->body);
 		} break;
 		case AST_Kind::If: {
-			const AST_If *self = dynamic_cast<const AST_If *>(this);
-			internal_verify(self, "Failed to cast to `const AST_If *`");
+			const AST_If *self = ast_cast<AST_If>(this);
 
-			printf("`if`:\n");
-			print_base_members(indentation);
+			fprintf(out, "`if`:\n");
+			print_base_members(out, indentation);
 
-			print_member("condition", indentation, self->condition);
-			print_member("then", indentation, self->then_block);
-			if (self->else_block) print_member("else", indentation, self->else_block);
+			print_member(out, "condition", indentation, self->condition);
+			print_member(out, "then", indentation, self->then_block);
+			if (self->else_block) print_member(out, "else", indentation, self->else_block);
 		} break;
 		
 		default:
@@ -871,1849 +1599,8519 @@ void AST::debug_print(size_t indentation) const {
 	#undef CASE_BLOCK
 }
 
-void AST::print_unary(const AST_Unary *unary, size_t indentation) const {
-	print_base_members(indentation);
-	print_member("sub", indentation, unary->sub);
+void AST::print_unary(FILE *out, const AST_Unary *unary, size_t indentation) const {
+	print_base_members(out, indentation);
+	print_member(out, "sub", indentation, unary->sub);
 }
 
-void AST::print_binary(const AST_Binary *binary, size_t indentation) const {
-	print_base_members(indentation);
-	print_member("lhs", indentation, binary->lhs);
-	print_member("rhs", indentation, binary->rhs);
+void AST::print_binary(FILE *out, const AST_Binary *binary, size_t indentation) const {
+	print_base_members(out, indentation);
+	print_member(out, "lhs", indentation, binary->lhs);
+	print_member(out, "rhs", indentation, binary->rhs);
 }
 
-void AST::print_block(const AST_Block *block, size_t indentation) const {
-	print_base_members(indentation);
+void AST::print_block(FILE *out, const AST_Block *block, size_t indentation) const {
+	print_base_members(out, indentation);
 
 	for (size_t i = 0; i < block->nodes.size(); i++) {
-		printf("%*s%zu: ", 
+		fprintf(out, "%*s%zu: ", 
 			static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
 			i
 		);
-		block->nodes[i]->debug_print(indentation + 1);
+		block->nodes[i]->debug_print(out, indentation + 1);
 	}
 }
 
 //
 //
-// Parser
+// Flat AST
 //
 //
 
-enum class Token_Precedence {
-	None,
-	Assignment, // = += -= *= /= &= etc.
-	Colon,      // :
-	Cast,       // as
-	Range,      // .. ...
-	Or,         // ||
-	And,        // &&
-	BitOr,      // |
-	Xor,        // ^
-	BitAnd,     // &
-	Equality,   // == !=
-	Comparison, // < > <= >=
-	Shift,      // << >>
-	Term,       // + -
-	Factor,     // * / %
-	Unary,      // ! ~
-	Call,       // . () []
-	Primary,
-};
+using AST_Index = uint32_t;
 
-std::string debug_str(Token_Precedence precedence) {
-	#define CASE(precedence) case Token_Precedence::precedence: return #precedence
+constexpr AST_Index AST_None = UINT32_MAX;
 
-	switch (precedence) {
-		CASE(None);
-		CASE(Assignment);
-		CASE(Colon);
-		CASE(Cast);
-		CASE(Range);
-		CASE(Or);         
-		CASE(And);        
-		CASE(BitOr);      
-		CASE(Xor);        
-		CASE(BitAnd);     
-		CASE(Equality);   
-		CASE(Comparison); 
-		CASE(Shift);      
-		CASE(Term);       
-		CASE(Factor);     
-		CASE(Unary);      
-		CASE(Call);       
-		CASE(Primary);
+// Compact, pointer-free form of an AST. Every node is a fixed 16 byte record
+// in `nodes` addressed by its index, with its type and location held in
+// parallel arrays so passes that don't need them never touch them. A block's
+// children are the range `[operands[0], operands[0] + operands[1])` of
+// `children`, and string literals are ranges of `strings`, so the whole tree
+// can be copied or written out as a handful of flat arrays.
+//
+// Operand layout per kind:
+//   Symbol_Identifier              symbol id
+//   Literal_*                      value bits (low, high) or string (offset, size)
+//   Unary_*                        sub
+//   Binary_*                       lhs, rhs (a call's rhs is its argument Block_Comma)
+//   Block, Block_Comma             first child, child count
+//   Variable/Constant_Instantiation symbol, type signature, initializer
+//   Function_Declaration           parameters, return type signature, body
+//   If                             condition, then, else
+//
+struct Flat_AST {
+	struct Node {
+		AST_Kind kind;
+		uint32_t operands[3];
+	};
 
-		default:
-			return std::to_string(static_cast<int>(precedence));
+	static_assert(sizeof(Node) == 16, "Flat AST nodes should stay 16 bytes!");
+
+	std::vector<Node> nodes;
+	std::vector<Type_ID> types;
+	std::vector<Code_Location> locations;
+	std::vector<AST_Index> children;
+	std::vector<char> strings;
+	AST_Index root = AST_None;
+
+	size_t count() const {
+		return nodes.size();
 	}
 
-	#undef CASE
-}
+	const Node &operator[](AST_Index index) const {
+		return nodes[index];
+	}
 
-Token_Precedence operator+(Token_Precedence p, int step) {
-	auto q = static_cast<int>(p) + step;
-	q = std::clamp(q, static_cast<int>(Token_Precedence::None), static_cast<int>(Token_Precedence::Primary));
-	return static_cast<Token_Precedence>(q);
-}
+	Array<const AST_Index> children_of(AST_Index block) const {
+		const Node &node = nodes[block];
+		return Array<const AST_Index> { node.operands[1], children.data() + node.operands[0] };
+	}
 
-enum class Token_Kind {
-	Eof,
+	uint64_t literal_bits(AST_Index index) const {
+		const Node &node = nodes[index];
+		return static_cast<uint64_t>(node.operands[0]) | (static_cast<uint64_t>(node.operands[1]) << 32);
+	}
 
-	// literals
-	Literal_Null,
-	Literal_Boolean,
-	Literal_Character,
-	Literal_Integer,
-	Literal_Floating_Point,
-	Literal_String,
+	String literal_string(AST_Index index) const {
+		const Node &node = nodes[index];
+		return String { node.operands[1], const_cast<char *>(strings.data()) + node.operands[0] };
+	}
 
-	// symbols
-	Symbol_Identifier,
+	size_t bytes() const {
+		return nodes.size() * sizeof(Node)
+			+ types.size() * sizeof(Type_ID)
+			+ locations.size() * sizeof(Code_Location)
+			+ children.size() * sizeof(AST_Index)
+			+ strings.size();
+	}
 
-	// delimeters
-	Delimeter_Newline,
-	Delimeter_Semicolon,
-	Delimeter_Comma,
-	Delimeter_Left_Parenthesis,
-	Delimeter_Right_Parenthesis,
-	Delimeter_Left_Curly,
-	Delimeter_Right_Curly,
+	void print_stats(FILE *out, const char *name) const {
+		fprintf(out, "%s: %zu node(s), %zu child index(es), %zu bytes\n",
+			name,
+			nodes.size(),
+			children.size(),
+			bytes()
+		);
+	}
 
-	// punctuation
-	Punctuation_Bang,
-	Punctuation_Bang_Equal,
-	Punctuation_Equal,
-	Punctuation_Equal_Equal,
-	Punctuation_Colon,
-	Punctuation_Plus,
-	Punctuation_Dash,
-	Punctuation_Star,
-	Punctuation_Slash,
-	Punctuation_Ampersand_Ampersand,
-	Punctuation_Pipe_Pipe,
-	Punctuation_Right_Thin_Arrow,
+	void debug_print(FILE *out, AST_Index index, size_t indentation = 0) const;
 
-	// keywords
-	Keyword_If,
-	Keyword_Else,
-	Keyword_While,
-	Keyword_Fn,
+	void debug_print(FILE *out) const {
+		debug_print(out, root);
+	}
+
+private:
+	void print_base_members(FILE *out, AST_Index index, size_t indentation) const;
+	void print_member(FILE *out, const char *name, size_t indentation, AST_Index member) const;
 };
 
-std::string debug_str(Token_Kind kind) {
-	#define CASE(kind) case Token_Kind::kind: return #kind
+struct Flattener {
+	Flat_AST *flat;
 
-	switch (kind) {
-		CASE(Eof);
+	AST_Index push(const AST *node, uint32_t a = AST_None, uint32_t b = AST_None, uint32_t c = AST_None) {
+		internal_verify(flat->nodes.size() < AST_None, "Too many AST nodes to flatten!");
 
-		// literals
-		CASE(Literal_Null);
-		CASE(Literal_Boolean);
-		CASE(Literal_Character);
-		CASE(Literal_Integer);
-		CASE(Literal_Floating_Point);
-		CASE(Literal_String);
+		AST_Index index = static_cast<AST_Index>(flat->nodes.size());
+		flat->nodes.push_back(Flat_AST::Node { node->kind, { a, b, c } });
+		flat->types.push_back(node->type);
+		flat->locations.push_back(node->location);
+		return index;
+	}
 
-		// symbols
-		CASE(Symbol_Identifier);
+	AST_Index push_bits(const AST *node, uint64_t bits) {
+		return push(node, static_cast<uint32_t>(bits), static_cast<uint32_t>(bits >> 32), 0);
+	}
 
-		// delimeters
-		CASE(Delimeter_Newline);
-		CASE(Delimeter_Semicolon);
-		CASE(Delimeter_Comma);
-		CASE(Delimeter_Left_Parenthesis);
-		CASE(Delimeter_Right_Parenthesis);
-		CASE(Delimeter_Left_Curly);
-		CASE(Delimeter_Right_Curly);
+	AST_Index flatten_optional(const AST *node) {
+		return node ? flatten(node) : AST_None;
+	}
 
-		// punctuation
-		CASE(Punctuation_Bang);
-		CASE(Punctuation_Bang_Equal);
-		CASE(Punctuation_Equal);
-		CASE(Punctuation_Equal_Equal);
-		CASE(Punctuation_Colon);
-		CASE(Punctuation_Plus);
-		CASE(Punctuation_Dash);
-		CASE(Punctuation_Star);
-		CASE(Punctuation_Slash);
-		CASE(Punctuation_Ampersand_Ampersand);
-		CASE(Punctuation_Pipe_Pipe);
-		CASE(Punctuation_Right_Thin_Arrow);
+	AST_Index flatten(const AST *node) {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier:
+				return push(node, ast_cast<AST_Symbol>(node)->symbol);
+
+			case AST_Kind::Literal_Null:
+				return push_bits(node, 0);
+			case AST_Kind::Literal_Boolean:
+				return push_bits(node, ast_cast<AST_Literal>(node)->as.boolean);
+			case AST_Kind::Literal_Character:
+				return push_bits(node, ast_cast<AST_Literal>(node)->as.character);
+			case AST_Kind::Literal_Integer:
+				return push_bits(node, static_cast<uint64_t>(ast_cast<AST_Literal>(node)->as.integer));
+			case AST_Kind::Literal_Floating_Point: {
+				uint64_t bits;
+				memcpy(&bits, &ast_cast<AST_Literal>(node)->as.floating_point, sizeof(bits));
+				return push_bits(node, bits);
+			}
+			case AST_Kind::Literal_String: {
+				String string = ast_cast<AST_Literal>(node)->as.string;
+				uint32_t offset = static_cast<uint32_t>(flat->strings.size());
+				flat->strings.insert(flat->strings.end(), string.chars, string.chars + string.size);
+				return push(node, offset, static_cast<uint32_t>(string.size), 0);
+			}
 
-		// keywords
-		CASE(Keyword_If);
-		CASE(Keyword_Else);
-		CASE(Keyword_While);
-		CASE(Keyword_Fn);
+			case AST_Kind::Unary_Not:
+			case AST_Kind::Unary_Negate:
+				return push(node, flatten(ast_cast<AST_Unary>(node)->sub));
+
+			case AST_Kind::Binary_Variable_Declaration:
+			case AST_Kind::Binary_Assignment:
+			case AST_Kind::Binary_While:
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide:
+			case AST_Kind::Binary_And:
+			case AST_Kind::Binary_Or:
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE:
+			case AST_Kind::Binary_Call: {
+				const AST_Binary *binary = ast_cast<AST_Binary>(node);
+				AST_Index lhs = flatten(binary->lhs);
+				AST_Index rhs = flatten(binary->rhs);
+				return push(node, lhs, rhs);
+			}
 
-		default:
-			return std::to_string(static_cast<int>(kind));
+			case AST_Kind::Block:
+			case AST_Kind::Block_Comma: {
+				// Children are flattened first so that their own child ranges
+				// are laid down before this block claims a contiguous one.
+				const AST_Block *block = ast_cast<AST_Block>(node);
+
+				std::vector<AST_Index> nodes;
+				nodes.reserve(block->nodes.size());
+				for (const AST *child : block->nodes) {
+					nodes.push_back(flatten(child));
+				}
+
+				uint32_t first = static_cast<uint32_t>(flat->children.size());
+				flat->children.insert(flat->children.end(), nodes.begin(), nodes.end());
+				return push(node, first, static_cast<uint32_t>(nodes.size()));
+			}
+
+			case AST_Kind::Variable_Instantiation:
+			case AST_Kind::Constant_Instantiation: {
+				const AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+				internal_verify(!inst->specified_type_signature, "Can't flatten type signatures yet!");
+				AST_Index symbol = flatten(inst->symbol);
+				AST_Index initializer = flatten(inst->initializer);
+				return push(node, symbol, AST_None, initializer);
+			}
+
+			case AST_Kind::Function_Declaration: {
+				const AST_Function_Declaration *decl = ast_cast<AST_Function_Declaration>(node);
+				AST_Index parameters = flatten(decl->parameters);
+				AST_Index return_type = flatten_optional(decl->return_type_signature);
+				AST_Index body = flatten(decl->body);
+				return push(node, parameters, return_type, body);
+			}
+
+			case AST_Kind::If: {
+				const AST_If *if_ = ast_cast<AST_If>(node);
+				AST_Index condition = flatten(if_->condition);
+				AST_Index then_block = flatten(if_->then_block);
+				AST_Index else_block = flatten_optional(if_->else_block);
+				return push(node, condition, then_block, else_block);
+			}
+		}
+
+		internal_error("Unhandled AST_Kind: %s!", debug_str(node->kind).c_str());
+		return AST_None;
 	}
+};
 
-	#undef CASE
+Flat_AST flatten(const AST *root) {
+	Flat_AST flat;
+	Flattener flattener { &flat };
+	flat.root = flattener.flatten(root);
+	return flat;
 }
 
-union Token_Data {
-	bool boolean;
-	char32_t character;
-	int64_t integer;
-	double floating_point;
-	String string;
-};
+// Rebuilds the pointer tree for `index` in `arena`. String literals point
+// into `flat`, so it must outlive the result.
+//
+AST *unflatten(Arena &arena, const Flat_AST &flat, AST_Index index) {
+	if (index == AST_None) return nullptr;
 
-struct Token {
-	Token_Kind kind;
-	Token_Data data;
-	Code_Location location;
+	const Flat_AST::Node &node = flat[index];
 
-	Token_Precedence precedence() const {
-		#define CASE(kind, prec) case Token_Kind::kind: return Token_Precedence::prec
+	auto init = [&](AST *ast) {
+		ast->kind = node.kind;
+		ast->type = flat.types[index];
+		ast->location = flat.locations[index];
+		return ast;
+	};
 
-		switch (kind) {
-			CASE(Eof, None);
+	switch (node.kind) {
+		case AST_Kind::Symbol_Identifier: {
+			AST_Symbol *symbol = arena.make<AST_Symbol>();
+			symbol->symbol = node.operands[0];
+			return init(symbol);
+		}
 
-			// literals
-			CASE(Literal_Null, None);
-			CASE(Literal_Boolean, None);
-			CASE(Literal_Character, None);
-			CASE(Literal_Integer, None);
-			CASE(Literal_Floating_Point, None);
-			CASE(Literal_String, None);
+		case AST_Kind::Literal_Null:
+		case AST_Kind::Literal_Boolean:
+		case AST_Kind::Literal_Character:
+		case AST_Kind::Literal_Integer:
+		case AST_Kind::Literal_Floating_Point:
+		case AST_Kind::Literal_String: {
+			AST_Literal *literal = arena.make<AST_Literal>();
+			uint64_t bits = flat.literal_bits(index);
+			switch (node.kind) {
+				case AST_Kind::Literal_Boolean:   literal->as.boolean = bits != 0; break;
+				case AST_Kind::Literal_Character: literal->as.character = static_cast<char32_t>(bits); break;
+				case AST_Kind::Literal_Integer:   literal->as.integer = static_cast<int64_t>(bits); break;
+				case AST_Kind::Literal_Floating_Point:
+					memcpy(&literal->as.floating_point, &bits, sizeof(bits));
+					break;
+				case AST_Kind::Literal_String:    literal->as.string = flat.literal_string(index); break;
+				default: break;
+			}
+			return init(literal);
+		}
 
-			// symbols
-			CASE(Symbol_Identifier, None);
+		case AST_Kind::Unary_Not:
+		case AST_Kind::Unary_Negate: {
+			AST_Unary *unary = arena.make<AST_Unary>();
+			unary->sub = unflatten(arena, flat, node.operands[0]);
+			return init(unary);
+		}
 
-			// delimeters
-			CASE(Delimeter_Newline, None);
-			CASE(Delimeter_Semicolon, None);
-			CASE(Delimeter_Comma, None);
-			CASE(Delimeter_Left_Parenthesis, Call);
-			CASE(Delimeter_Right_Parenthesis, None);
-			CASE(Delimeter_Left_Curly, None);
-			CASE(Delimeter_Right_Curly, None);
+		case AST_Kind::Binary_Variable_Declaration:
+		case AST_Kind::Binary_Assignment:
+		case AST_Kind::Binary_While:
+		case AST_Kind::Binary_Add:
+		case AST_Kind::Binary_Subtract:
+		case AST_Kind::Binary_Multiply:
+		case AST_Kind::Binary_Divide:
+		case AST_Kind::Binary_And:
+		case AST_Kind::Binary_Or:
+		case AST_Kind::Binary_EQ:
+		case AST_Kind::Binary_NE:
+		case AST_Kind::Binary_Call: {
+			AST_Binary *binary = arena.make<AST_Binary>();
+			binary->lhs = unflatten(arena, flat, node.operands[0]);
+			binary->rhs = unflatten(arena, flat, node.operands[1]);
+			return init(binary);
+		}
 
+		case AST_Kind::Block:
+		case AST_Kind::Block_Comma: {
+			AST_Block *block = arena.make<AST_Block>();
+			Array<const AST_Index> children = flat.children_of(index);
+			block->nodes.reserve(children.count);
+			for (size_t i = 0; i < children.count; i++) {
+				block->nodes.push_back(unflatten(arena, flat, children.elems[i]));
+			}
+			return init(block);
+		}
+
+		case AST_Kind::Variable_Instantiation:
+		case AST_Kind::Constant_Instantiation: {
+			AST_Variable_Instantiation *inst = arena.make<AST_Variable_Instantiation>();
+			inst->symbol = ast_cast<AST_Symbol>(unflatten(arena, flat, node.operands[0]));
+			inst->specified_type_signature = nullptr;
+			inst->initializer = unflatten(arena, flat, node.operands[2]);
+			return init(inst);
+		}
+
+		case AST_Kind::Function_Declaration: {
+			AST_Function_Declaration *decl = arena.make<AST_Function_Declaration>();
+			decl->parameters = ast_cast<AST_Block>(unflatten(arena, flat, node.operands[0]));
+			decl->return_type_signature = unflatten(arena, flat, node.operands[1]);
+			decl->body = ast_cast<AST_Block>(unflatten(arena, flat, node.operands[2]));
+			return init(decl);
+		}
+
+		case AST_Kind::If: {
+			AST_If *if_ = arena.make<AST_If>();
+			if_->condition = unflatten(arena, flat, node.operands[0]);
+			if_->then_block = unflatten(arena, flat, node.operands[1]);
+			if_->else_block = unflatten(arena, flat, node.operands[2]);
+			return init(if_);
+		}
+	}
+
+	internal_error("Unhandled AST_Kind: %s!", debug_str(node.kind).c_str());
+	return nullptr;
+}
+
+void Flat_AST::print_base_members(FILE *out, AST_Index index, size_t indentation) const {
+	fprintf(out, "%*skind: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", debug_str(nodes[index].kind).c_str());
+	fprintf(out, "%*stype: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", type_table.debug_str(types[index]).c_str());
+	fprintf(out, "%*slocation: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", locations[index].debug_str().c_str());
+}
+
+void Flat_AST::print_member(FILE *out, const char *name, size_t indentation, AST_Index member) const {
+	fprintf(out, "%*s%s: ", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", name);
+	debug_print(out, member, indentation + 1);
+}
+
+// Mirrors `AST::debug_print` exactly so the two forms can be diffed.
+//
+void Flat_AST::debug_print(FILE *out, AST_Index index, size_t indentation) const {
+	const Node &node = nodes[index];
+
+	fprintf(out, "`%s`:\n", node.kind == AST_Kind::If ? "if" : debug_str(node.kind).c_str());
+	print_base_members(out, index, indentation);
+
+	switch (node.kind) {
+		case AST_Kind::Symbol_Identifier: {
+			String symbol = interner.get(node.operands[0]);
+			fprintf(out, "%*sid: `%.*s`\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				static_cast<int>(symbol.size), symbol.chars
+			);
+		} break;
+		case AST_Kind::Literal_Null:
+			break;
+		case AST_Kind::Literal_Boolean: {
+			fprintf(out, "%*svalue: %s\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				literal_bits(index) ? "true" : "false"
+			);
+		} break;
+		case AST_Kind::Literal_Character: {
+			char utf8[5];
+			encode_utf8(static_cast<char32_t>(literal_bits(index)), utf8);
+			fprintf(out, "%*svalue: %s\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				utf8
+			);
+		} break;
+		case AST_Kind::Literal_Integer: {
+			fprintf(out, "%*svalue: %lld\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				static_cast<long long>(literal_bits(index))
+			);
+		} break;
+		case AST_Kind::Literal_Floating_Point: {
+			uint64_t bits = literal_bits(index);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			fprintf(out, "%*svalue: %f\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				value
+			);
+		} break;
+		case AST_Kind::Literal_String: {
+			String string = literal_string(index);
+			fprintf(out, "%*svalue: %.*s\n",
+				static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+				static_cast<int>(string.size), string.chars
+			);
+		} break;
+
+		case AST_Kind::Unary_Not:
+		case AST_Kind::Unary_Negate:
+			print_member(out, "sub", indentation, node.operands[0]);
+			break;
+
+		case AST_Kind::Binary_Variable_Declaration:
+		case AST_Kind::Binary_Assignment:
+		case AST_Kind::Binary_While:
+		case AST_Kind::Binary_Add:
+		case AST_Kind::Binary_Subtract:
+		case AST_Kind::Binary_Multiply:
+		case AST_Kind::Binary_Divide:
+		case AST_Kind::Binary_And:
+		case AST_Kind::Binary_Or:
+		case AST_Kind::Binary_EQ:
+		case AST_Kind::Binary_NE:
+		case AST_Kind::Binary_Call:
+			print_member(out, "lhs", indentation, node.operands[0]);
+			print_member(out, "rhs", indentation, node.operands[1]);
+			break;
+
+		case AST_Kind::Block:
+		case AST_Kind::Block_Comma: {
+			Array<const AST_Index> children = children_of(index);
+			for (size_t i = 0; i < children.count; i++) {
+				fprintf(out, "%*s%zu: ",
+					static_cast<int>(Print_Indentation_Size * (indentation + 1)), "",
+					i
+				);
+				debug_print(out, children.elems[i], indentation + 1);
+			}
+		} break;
+
+		case AST_Kind::Variable_Instantiation:
+		case AST_Kind::Constant_Instantiation:
+			print_member(out, "symbol", indentation, node.operands[0]);
+			if (node.operands[1] != AST_None) print_member(out, "type", indentation, node.operands[1]);
+			print_member(out, "initializer", indentation, node.operands[2]);
+			break;
+
+		case AST_Kind::Function_Declaration:
+			print_member(out, "parameters", indentation, node.operands[0]);
+			if (node.operands[1] != AST_None) print_member(out, "return", indentation, node.operands[1]);
+			print_member(out, "body", indentation, node.operands[2]);
+			break;
+
+		case AST_Kind::If:
+			print_member(out, "condition", indentation, node.operands[0]);
+			print_member(out, "then", indentation, node.operands[1]);
+			if (node.operands[2] != AST_None) print_member(out, "else", indentation, node.operands[2]);
+			break;
+	}
+}
+
+//
+//
+// Scanning
+//
+//
+
+// Bulk character-class scanners used by the `Tokenizer`. Each one takes the
+// half-open range `[p, end)` and returns a pointer to the first byte that
+// doesn't belong to the run (or `end`). The vectorized versions only ever
+// load full blocks inside the range and finish the tail with the scalar
+// loop, so they never read past the end of the source.
+//
+struct Scanner {
+	const char *name;
+	const char *(*skip_whitespace)(const char *p, const char *end);
+	const char *(*skip_identifier)(const char *p, const char *end);
+	const char *(*find_newline)(const char *p, const char *end);
+	const char *(*find_string_end)(const char *p, const char *end);
+	const char *(*skip_ascii)(const char *p, const char *end);
+};
+
+inline bool is_horizontal_whitespace(unsigned char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r' && c != '\n');
+}
+
+inline bool is_identifier_byte(unsigned char c) {
+	return c == '_' || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+namespace Scalar_Scanner {
+	const char *skip_whitespace(const char *p, const char *end) {
+		while (p < end && is_horizontal_whitespace(*p)) p++;
+		return p;
+	}
+
+	const char *skip_identifier(const char *p, const char *end) {
+		while (p < end && is_identifier_byte(*p)) p++;
+		return p;
+	}
+
+	const char *find_newline(const char *p, const char *end) {
+		while (p < end && *p != '\n') p++;
+		return p;
+	}
+
+	const char *find_string_end(const char *p, const char *end) {
+		while (p < end && *p != '\"' && *p != '\0') p++;
+		return p;
+	}
+
+	const char *skip_ascii(const char *p, const char *end) {
+		while (p < end && !(*p & 0x80)) p++;
+		return p;
+	}
+}
+
+#if defined(__x86_64__)
+
+namespace SSE2_Scanner {
+	constexpr size_t Width = 16;
+
+	inline __m128i load(const char *p) {
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+	}
+
+	// lanes where `lo <= v <= hi` as unsigned bytes
+	inline __m128i in_range(__m128i v, char lo, char hi) {
+		__m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+		return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(hi - lo)), offset);
+	}
+
+	inline __m128i whitespace_mask(__m128i v) {
+		__m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+		__m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+		return _mm_or_si128(space, _mm_andnot_si128(newline, in_range(v, '\t', '\r')));
+	}
+
+	inline __m128i identifier_mask(__m128i v) {
+		__m128i alpha = in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+		__m128i digit = in_range(v, '0', '9');
+		__m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+		return _mm_or_si128(_mm_or_si128(alpha, digit), underscore);
+	}
+
+	const char *skip_whitespace(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			unsigned stop = ~_mm_movemask_epi8(whitespace_mask(load(p))) & 0xFFFF;
+			if (stop) return p + __builtin_ctz(stop);
+		}
+		return Scalar_Scanner::skip_whitespace(p, end);
+	}
+
+	const char *skip_identifier(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			unsigned stop = ~_mm_movemask_epi8(identifier_mask(load(p))) & 0xFFFF;
+			if (stop) return p + __builtin_ctz(stop);
+		}
+		return Scalar_Scanner::skip_identifier(p, end);
+	}
+
+	const char *find_newline(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			unsigned hit = _mm_movemask_epi8(_mm_cmpeq_epi8(load(p), _mm_set1_epi8('\n')));
+			if (hit) return p + __builtin_ctz(hit);
+		}
+		return Scalar_Scanner::find_newline(p, end);
+	}
+
+	const char *find_string_end(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			__m128i v = load(p);
+			__m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('\"'));
+			__m128i nul = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+			unsigned hit = _mm_movemask_epi8(_mm_or_si128(quote, nul));
+			if (hit) return p + __builtin_ctz(hit);
+		}
+		return Scalar_Scanner::find_string_end(p, end);
+	}
+
+	const char *skip_ascii(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			unsigned high = _mm_movemask_epi8(load(p));
+			if (high) return p + __builtin_ctz(high);
+		}
+		return Scalar_Scanner::skip_ascii(p, end);
+	}
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+namespace AVX2_Scanner {
+	constexpr size_t Width = 32;
+
+	AVX2_TARGET inline __m256i load(const char *p) {
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+	}
+
+	AVX2_TARGET inline __m256i in_range(__m256i v, char lo, char hi) {
+		__m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+		return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(hi - lo)), offset);
+	}
+
+	AVX2_TARGET inline __m256i whitespace_mask(__m256i v) {
+		__m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+		__m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+		return _mm256_or_si256(space, _mm256_andnot_si256(newline, in_range(v, '\t', '\r')));
+	}
+
+	AVX2_TARGET inline __m256i identifier_mask(__m256i v) {
+		__m256i alpha = in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+		__m256i digit = in_range(v, '0', '9');
+		__m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+		return _mm256_or_si256(_mm256_or_si256(alpha, digit), underscore);
+	}
+
+	AVX2_TARGET const char *skip_whitespace(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(whitespace_mask(load(p))));
+			if (stop) return p + __builtin_ctz(stop);
+		}
+		return SSE2_Scanner::skip_whitespace(p, end);
+	}
+
+	AVX2_TARGET const char *skip_identifier(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(identifier_mask(load(p))));
+			if (stop) return p + __builtin_ctz(stop);
+		}
+		return SSE2_Scanner::skip_identifier(p, end);
+	}
+
+	AVX2_TARGET const char *find_newline(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			uint32_t hit = _mm256_movemask_epi8(_mm256_cmpeq_epi8(load(p), _mm256_set1_epi8('\n')));
+			if (hit) return p + __builtin_ctz(hit);
+		}
+		return SSE2_Scanner::find_newline(p, end);
+	}
+
+	AVX2_TARGET const char *find_string_end(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			__m256i v = load(p);
+			__m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\"'));
+			__m256i nul = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+			uint32_t hit = _mm256_movemask_epi8(_mm256_or_si256(quote, nul));
+			if (hit) return p + __builtin_ctz(hit);
+		}
+		return SSE2_Scanner::find_string_end(p, end);
+	}
+
+	AVX2_TARGET const char *skip_ascii(const char *p, const char *end) {
+		for (; p + Width <= end; p += Width) {
+			uint32_t high = _mm256_movemask_epi8(load(p));
+			if (high) return p + __builtin_ctz(high);
+		}
+		return SSE2_Scanner::skip_ascii(p, end);
+	}
+}
+
+#undef AVX2_TARGET
+
+#endif
+
+constexpr Scanner Scalar_Scanner_Impl = {
+	"scalar",
+	Scalar_Scanner::skip_whitespace,
+	Scalar_Scanner::skip_identifier,
+	Scalar_Scanner::find_newline,
+	Scalar_Scanner::find_string_end,
+	Scalar_Scanner::skip_ascii,
+};
+
+#if defined(__x86_64__)
+constexpr Scanner SSE2_Scanner_Impl = {
+	"sse2",
+	SSE2_Scanner::skip_whitespace,
+	SSE2_Scanner::skip_identifier,
+	SSE2_Scanner::find_newline,
+	SSE2_Scanner::find_string_end,
+	SSE2_Scanner::skip_ascii,
+};
+
+constexpr Scanner AVX2_Scanner_Impl = {
+	"avx2",
+	AVX2_Scanner::skip_whitespace,
+	AVX2_Scanner::skip_identifier,
+	AVX2_Scanner::find_newline,
+	AVX2_Scanner::find_string_end,
+	AVX2_Scanner::skip_ascii,
+};
+#endif
+
+// Every scanner this machine can run, slowest first.
+//
+std::vector<const Scanner *> available_scanners() {
+	std::vector<const Scanner *> scanners = { &Scalar_Scanner_Impl };
+
+#if defined(__x86_64__)
+	scanners.push_back(&SSE2_Scanner_Impl);
+
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		scanners.push_back(&AVX2_Scanner_Impl);
+	}
+#endif
+
+	return scanners;
+}
+
+const Scanner *scanner = available_scanners().back();
+
+// Whether `[p, end)` is well-formed UTF-8. Whole blocks of ASCII are skipped
+// by the scanner without decoding anything.
+//
+bool is_valid_utf8(const char *p, const char *end) {
+	while (true) {
+		p = scanner->skip_ascii(p, end);
+		if (p == end) return true;
+
+		char32_t c;
+		int size = decode_utf8(p, end, &c);
+		if (size <= 0) return false;
+		p += size;
+	}
+}
+
+// Identifiers are ASCII letters, digits and `_` plus every non-ASCII
+// codepoint. Stops at the first byte that can't continue the identifier;
+// a multi-byte sequence cut short by `end` counts as continuing it so a
+// streaming caller refills and tries again.
+//
+const char *skip_identifier_utf8(const char *p, const char *end) {
+	while (true) {
+		p = scanner->skip_identifier(p, end);
+		if (p == end || !(*p & 0x80)) return p;
+
+		char32_t c;
+		int size = decode_utf8(p, end, &c);
+		if (size < 0) return end;
+		if (size == 0) return p;
+		p += size;
+	}
+}
+
+//
+//
+// Source Files
+//
+//
+
+// Every file the compiler has seen, indexed by `File_ID`. Line starts are
+// only worked out the first time something asks for a line number, which
+// for a successful compile without debug output is never. Streamed input
+// has no text to go back to, so its line starts are recorded as the stream
+// is read instead.
+//
+struct Source_File {
+	std::string name;
+	String text;
+	std::mutex lock; // guards building `line_starts`
+	std::atomic<bool> lines_ready;
+	std::vector<uint32_t> line_starts;
+};
+
+struct Line_Column {
+	size_t line;
+	size_t coloumn;
+};
+
+// Files are registered from whichever job opens them. A stream's chunks
+// are only ever reported by the job reading it.
+//
+struct Source_Files {
+	Paged_Array<Source_File *, 1024, 64> files;
+
+	File_ID add(const char *name, String text, bool lines_ready = false) {
+		Source_File *file = new Source_File;
+		file->name = name;
+		file->text = text;
+		file->lines_ready = lines_ready;
+		file->line_starts.push_back(0);
+
+		size_t id = files.push(file);
+		internal_verify(id < std::numeric_limits<File_ID>::max(), "Too many source files!");
+
+		return static_cast<File_ID>(id);
+	}
+
+	// Streams report each chunk as it's read. `offset` is the chunk's
+	// position in the whole input.
+	//
+	File_ID add_stream(const char *name) {
+		return add(name, String { 0, nullptr }, true);
+	}
+
+	void add_chunk(File_ID id, const char *chunk, size_t size, size_t offset) {
+		record_line_starts(*files[id], chunk, chunk + size, offset);
+	}
+
+	// Called before the text goes away so it can still be resolved against.
+	//
+	void forget_text(File_ID id) {
+		Source_File &file = *files[id];
+		build_line_starts(file);
+		file.text = String { 0, nullptr };
+	}
+
+	// Swaps in the edited text of a file. Line starts are worked out again
+	// on demand. Nothing may be resolving locations in the file meanwhile.
+	//
+	void replace_text(File_ID id, String text) {
+		Source_File &file = *files[id];
+		file.text = text;
+		file.line_starts.assign(1, 0);
+		file.lines_ready.store(false, std::memory_order_release);
+	}
+
+	// Hands the ID of a file nothing refers to any more to another one, so
+	// a long-running process doesn't run out of IDs.
+	//
+	void reuse(File_ID id, const char *name) {
+		Source_File &file = *files[id];
+		file.name = name;
+		replace_text(id, String { 0, nullptr });
+	}
+
+	const char *name(File_ID id) const {
+		return files[id]->name.c_str();
+	}
+
+	Line_Column resolve(Code_Location location) {
+		Source_File &file = *files[location.file];
+		build_line_starts(file);
+
+		auto after = std::upper_bound(file.line_starts.begin(), file.line_starts.end(), location.offset);
+		size_t line = (after - file.line_starts.begin()) - 1;
+
+		return Line_Column { line, location.offset - file.line_starts[line] };
+	}
+
+private:
+	static void record_line_starts(Source_File &file, const char *p, const char *end, size_t offset) {
+		const char *start = p;
+		while ((p = scanner->find_newline(p, end)) < end) {
+			p++;
+			file.line_starts.push_back(static_cast<uint32_t>(offset + (p - start)));
+		}
+	}
+
+	static void build_line_starts(Source_File &file) {
+		if (file.lines_ready.load(std::memory_order_acquire)) return;
+
+		std::lock_guard<std::mutex> guard(file.lock);
+		if (file.lines_ready.load(std::memory_order_relaxed)) return;
+		record_line_starts(file, file.text.chars, file.text.chars + file.text.size, 0);
+		file.lines_ready.store(true, std::memory_order_release);
+	}
+};
+
+Source_Files source_files;
+
+std::string Code_Location::debug_str() const {
+	Line_Column position = source_files.resolve(*this);
+
+	std::stringstream s;
+	s << source_files.name(file) << ':' << position.line + 1 << ':' << position.coloumn + 1;
+	return s.str();
+}
+
+//
+//
+// Parser
+//
+//
+
+enum class Token_Precedence {
+	None,
+	Assignment, // = += -= *= /= &= etc.
+	Colon,      // :
+	Cast,       // as
+	Range,      // .. ...
+	Or,         // ||
+	And,        // &&
+	BitOr,      // |
+	Xor,        // ^
+	BitAnd,     // &
+	Equality,   // == !=
+	Comparison, // < > <= >=
+	Shift,      // << >>
+	Term,       // + -
+	Factor,     // * / %
+	Unary,      // ! ~
+	Call,       // . () []
+	Primary,
+};
+
+std::string debug_str(Token_Precedence precedence) {
+	#define CASE(precedence) case Token_Precedence::precedence: return #precedence
+
+	switch (precedence) {
+		CASE(None);
+		CASE(Assignment);
+		CASE(Colon);
+		CASE(Cast);
+		CASE(Range);
+		CASE(Or);         
+		CASE(And);        
+		CASE(BitOr);      
+		CASE(Xor);        
+		CASE(BitAnd);     
+		CASE(Equality);   
+		CASE(Comparison); 
+		CASE(Shift);      
+		CASE(Term);       
+		CASE(Factor);     
+		CASE(Unary);      
+		CASE(Call);       
+		CASE(Primary);
+
+		default:
+			return std::to_string(static_cast<int>(precedence));
+	}
+
+	#undef CASE
+}
+
+Token_Precedence operator+(Token_Precedence p, int step) {
+	auto q = static_cast<int>(p) + step;
+	q = std::clamp(q, static_cast<int>(Token_Precedence::None), static_cast<int>(Token_Precedence::Primary));
+	return static_cast<Token_Precedence>(q);
+}
+
+enum class Token_Kind : uint8_t {
+	Eof,
+
+	// literals
+	Literal_Null,
+	Literal_Boolean,
+	Literal_Character,
+	Literal_Integer,
+	Literal_Floating_Point,
+	Literal_String,
+
+	// symbols
+	Symbol_Identifier,
+
+	// delimeters
+	Delimeter_Newline,
+	Delimeter_Semicolon,
+	Delimeter_Comma,
+	Delimeter_Left_Parenthesis,
+	Delimeter_Right_Parenthesis,
+	Delimeter_Left_Curly,
+	Delimeter_Right_Curly,
+
+	// punctuation
+	Punctuation_Bang,
+	Punctuation_Bang_Equal,
+	Punctuation_Equal,
+	Punctuation_Equal_Equal,
+	Punctuation_Colon,
+	Punctuation_Plus,
+	Punctuation_Dash,
+	Punctuation_Star,
+	Punctuation_Slash,
+	Punctuation_Ampersand_Ampersand,
+	Punctuation_Pipe_Pipe,
+	Punctuation_Right_Thin_Arrow,
+
+	// keywords
+	Keyword_If,
+	Keyword_Else,
+	Keyword_While,
+	Keyword_Fn,
+};
+
+std::string debug_str(Token_Kind kind) {
+	#define CASE(kind) case Token_Kind::kind: return #kind
+
+	switch (kind) {
+		CASE(Eof);
+
+		// literals
+		CASE(Literal_Null);
+		CASE(Literal_Boolean);
+		CASE(Literal_Character);
+		CASE(Literal_Integer);
+		CASE(Literal_Floating_Point);
+		CASE(Literal_String);
+
+		// symbols
+		CASE(Symbol_Identifier);
+
+		// delimeters
+		CASE(Delimeter_Newline);
+		CASE(Delimeter_Semicolon);
+		CASE(Delimeter_Comma);
+		CASE(Delimeter_Left_Parenthesis);
+		CASE(Delimeter_Right_Parenthesis);
+		CASE(Delimeter_Left_Curly);
+		CASE(Delimeter_Right_Curly);
+
+		// punctuation
+		CASE(Punctuation_Bang);
+		CASE(Punctuation_Bang_Equal);
+		CASE(Punctuation_Equal);
+		CASE(Punctuation_Equal_Equal);
+		CASE(Punctuation_Colon);
+		CASE(Punctuation_Plus);
+		CASE(Punctuation_Dash);
+		CASE(Punctuation_Star);
+		CASE(Punctuation_Slash);
+		CASE(Punctuation_Ampersand_Ampersand);
+		CASE(Punctuation_Pipe_Pipe);
+		CASE(Punctuation_Right_Thin_Arrow);
+
+		// keywords
+		CASE(Keyword_If);
+		CASE(Keyword_Else);
+		CASE(Keyword_While);
+		CASE(Keyword_Fn);
+
+		default:
+			return std::to_string(static_cast<int>(kind));
+	}
+
+	#undef CASE
+}
+
+union Token_Data {
+	bool boolean;
+	char32_t character;
+	int64_t integer;
+	double floating_point;
+	String string;
+	Symbol_ID symbol;
+};
+
+struct Token {
+	Token_Kind kind;
+	Token_Data data;
+	Code_Location location;
+
+	Token_Precedence precedence() const {
+		#define CASE(kind, prec) case Token_Kind::kind: return Token_Precedence::prec
+
+		switch (kind) {
+			CASE(Eof, None);
+
+			// literals
+			CASE(Literal_Null, None);
+			CASE(Literal_Boolean, None);
+			CASE(Literal_Character, None);
+			CASE(Literal_Integer, None);
+			CASE(Literal_Floating_Point, None);
+			CASE(Literal_String, None);
+
+			// symbols
+			CASE(Symbol_Identifier, None);
+
+			// delimeters
+			CASE(Delimeter_Newline, None);
+			CASE(Delimeter_Semicolon, None);
+			CASE(Delimeter_Comma, None);
+			CASE(Delimeter_Left_Parenthesis, Call);
+			CASE(Delimeter_Right_Parenthesis, None);
+			CASE(Delimeter_Left_Curly, None);
+			CASE(Delimeter_Right_Curly, None);
+
+			// punctuation
+			CASE(Punctuation_Bang, Unary);
+			CASE(Punctuation_Bang_Equal, Equality);
+			CASE(Punctuation_Equal, Assignment);
+			CASE(Punctuation_Equal_Equal, Equality);
+			CASE(Punctuation_Colon, Colon);
+			CASE(Punctuation_Plus, Term);
+			CASE(Punctuation_Dash, Term);
+			CASE(Punctuation_Star, Factor);
+			CASE(Punctuation_Slash, Factor);
+			CASE(Punctuation_Ampersand_Ampersand, And);
+			CASE(Punctuation_Pipe_Pipe, Or);
+
+			// keywords
+			CASE(Keyword_If, None);
+			CASE(Keyword_Else, None);
+			CASE(Keyword_While, None);
+			CASE(Keyword_Fn, None);
+
+			default:
+				internal_error("Unhandled Token_Kind: %s!", debug_str(kind).c_str());
+		}
+
+		#undef CASE
+	}
+
+	void debug_print(int indentation = 0) const {
+		printf("%*sToken::%s:\n", static_cast<int>(Print_Indentation_Size * indentation), "", debug_str(kind).c_str());
+
+		// @TODO:
+		// print data
+		//
+		switch (kind) {
+			case Token_Kind::Literal_Boolean:
+				printf("%*sdata: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.boolean ? "true" : "false");
+				break;
+			case Token_Kind::Literal_Character: {
+				char utf8[5];
+				encode_utf8(data.character, utf8);
+				printf("%*sdata: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", utf8);
+			} break;
+			case Token_Kind::Literal_Integer:
+				printf("%*sdata: %lld\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.integer);
+				break;
+			case Token_Kind::Literal_Floating_Point:
+				printf("%*sdata: '%f'\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.floating_point);
+				break;
+			case Token_Kind::Literal_String:
+				printf("%*sdata: \"%.*s\"\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", static_cast<int>(data.string.size), data.string.chars);
+				break;
+			case Token_Kind::Symbol_Identifier: {
+				String symbol = interner.get(data.symbol);
+				printf("%*sdata: \"%.*s\"\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", static_cast<int>(symbol.size), symbol.chars);
+			} break;
+
+			default:
+				break;
+		}
+
+		printf("%*slocation: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", location.debug_str().c_str());
+	}
+
+	std::string display_str() const {
+		#define CASE(kind, display) case Token_Kind::kind: return display
+
+		switch (kind) {
+			CASE(Eof, "EOF");
+
+			// literals
+			CASE(Literal_Null, "null");
+			CASE(Literal_Boolean, data.boolean ? "true" : "false");
+			CASE(Literal_Character, std::to_string(data.character));
+			CASE(Literal_Integer, std::to_string(data.integer));
+			CASE(Literal_Floating_Point, std::to_string(data.floating_point));
+			CASE(Literal_String, data.string.str());
+		
+			// symbols
+			CASE(Symbol_Identifier, interner.get(data.symbol).str());
+		
+			// delimeters
+			CASE(Delimeter_Newline, "new-line");
+			CASE(Delimeter_Semicolon, ";");
+			CASE(Delimeter_Comma, ",");
+			CASE(Delimeter_Left_Parenthesis, "(");
+			CASE(Delimeter_Right_Parenthesis, ")");
+			CASE(Delimeter_Left_Curly, "{");
+			CASE(Delimeter_Right_Curly, "}");
+		
 			// punctuation
-			CASE(Punctuation_Bang, Unary);
-			CASE(Punctuation_Bang_Equal, Equality);
-			CASE(Punctuation_Equal, Assignment);
-			CASE(Punctuation_Equal_Equal, Equality);
-			CASE(Punctuation_Colon, Colon);
-			CASE(Punctuation_Plus, Term);
-			CASE(Punctuation_Dash, Term);
-			CASE(Punctuation_Star, Factor);
-			CASE(Punctuation_Slash, Factor);
-			CASE(Punctuation_Ampersand_Ampersand, And);
-			CASE(Punctuation_Pipe_Pipe, Or);
+			CASE(Punctuation_Bang, "!");
+			CASE(Punctuation_Bang_Equal, "!=");
+			CASE(Punctuation_Equal, "=");
+			CASE(Punctuation_Equal_Equal, "==");
+			CASE(Punctuation_Colon, ":");
+			CASE(Punctuation_Plus, "+");
+			CASE(Punctuation_Dash, "-");
+			CASE(Punctuation_Star, "*");
+			CASE(Punctuation_Slash, "/");
+			CASE(Punctuation_Ampersand_Ampersand, "&&");
+			CASE(Punctuation_Pipe_Pipe, "||");
+			CASE(Punctuation_Right_Thin_Arrow, "->");
+		
+			// keywords
+			CASE(Keyword_If, "if");
+			CASE(Keyword_Else, "else");
+			CASE(Keyword_While, "while");
+			CASE(Keyword_Fn, "fn");
+
+			default:
+				internal_error("Unhandled Token_Kind: %s!\n", debug_str(kind).c_str());
+		}
+
+		#undef CASE
+	}
+};
+
+struct Keyword {
+	const char *text;
+	size_t size;
+	Token_Kind kind;
+	bool boolean; // payload for `Literal_Boolean`
+
+	constexpr Keyword(const char *text, Token_Kind kind, bool boolean = false) :
+		text(text),
+		size(std::char_traits<char>::length(text)),
+		kind(kind),
+		boolean(boolean)
+	{
+	}
+};
+
+constexpr Keyword Keywords[] = {
+	{ "null",  Token_Kind::Literal_Null },
+	{ "true",  Token_Kind::Literal_Boolean, true },
+	{ "false", Token_Kind::Literal_Boolean, false },
+	{ "if",    Token_Kind::Keyword_If },
+	{ "else",  Token_Kind::Keyword_Else },
+	{ "while", Token_Kind::Keyword_While },
+	{ "fn",    Token_Kind::Keyword_Fn },
+};
+
+constexpr size_t Keyword_Count = sizeof(Keywords) / sizeof(Keywords[0]);
+
+// Perfect hash over `Keywords` keyed on an identifier's length and its first
+// and last bytes. The seed is searched for at compile time so adding a
+// keyword only ever means adding a row above; if no seed separates the set
+// the `static_assert` below fires and `Keyword_Table_Bits` needs bumping.
+//
+constexpr size_t Keyword_Table_Bits = 5;
+constexpr size_t Keyword_Table_Size = 1 << Keyword_Table_Bits;
+
+constexpr uint32_t keyword_hash(uint32_t seed, size_t size, unsigned char first, unsigned char last) {
+	uint32_t h = seed ^ 0x811C9DC5;
+	h = (h ^ static_cast<uint32_t>(size)) * 0x01000193;
+	h = (h ^ first) * 0x01000193;
+	h = (h ^ last) * 0x01000193;
+	return h >> (32 - Keyword_Table_Bits);
+}
+
+struct Keyword_Table {
+	bool found;
+	uint32_t seed;
+	size_t min_size;
+	size_t max_size;
+	std::array<int8_t, Keyword_Table_Size> slots;
+};
+
+constexpr Keyword_Table build_keyword_table() {
+	Keyword_Table table {};
+	table.min_size = std::numeric_limits<size_t>::max();
+
+	for (size_t i = 0; i < Keyword_Count; i++) {
+		table.min_size = std::min(table.min_size, Keywords[i].size);
+		table.max_size = std::max(table.max_size, Keywords[i].size);
+	}
+
+	for (uint32_t seed = 0; seed < 4096; seed++) {
+		for (auto &slot : table.slots) slot = -1;
+
+		bool collided = false;
+		for (size_t i = 0; i < Keyword_Count && !collided; i++) {
+			const Keyword &k = Keywords[i];
+			uint32_t h = keyword_hash(seed, k.size, k.text[0], k.text[k.size - 1]);
+			if (table.slots[h] >= 0) {
+				collided = true;
+			} else {
+				table.slots[h] = static_cast<int8_t>(i);
+			}
+		}
+
+		if (!collided) {
+			table.found = true;
+			table.seed = seed;
+			return table;
+		}
+	}
+
+	return table;
+}
+
+constexpr Keyword_Table Keyword_Lookup = build_keyword_table();
+static_assert(Keyword_Lookup.found, "No perfect hash seed found for `Keywords`!");
+
+// Returns the keyword `word` spells, if any, with a single table probe.
+//
+const Keyword *find_keyword(String word) {
+	if (word.size < Keyword_Lookup.min_size || word.size > Keyword_Lookup.max_size) {
+		return nullptr;
+	}
+
+	uint32_t h = keyword_hash(Keyword_Lookup.seed, word.size, word.chars[0], word.chars[word.size - 1]);
+	int8_t slot = Keyword_Lookup.slots[h];
+	if (slot < 0) {
+		return nullptr;
+	}
+
+	const Keyword *keyword = &Keywords[slot];
+	if (keyword->size != word.size || memcmp(keyword->text, word.chars, word.size) != 0) {
+		return nullptr;
+	}
+
+	return keyword;
+}
+
+// Whole-file token stream stored as parallel arrays. Only tokens that carry
+// data (literals and identifiers) get an entry in `data`; everything else
+// has a payload index of 0. The buffer always ends with an `Eof` token.
+//
+struct Token_Buffer {
+	File_ID file;
+	std::vector<Token_Kind> kinds;
+	std::vector<uint32_t> payloads;
+	std::vector<uint32_t> offsets;
+	std::vector<Token_Data> data;
+
+	size_t count() const {
+		return kinds.size();
+	}
+
+	Token_Kind kind(size_t index) const {
+		return kinds[std::min(index, kinds.size() - 1)];
+	}
+
+	Code_Location location(size_t index) const {
+		index = std::min(index, kinds.size() - 1);
+		return Code_Location { offsets[index], file };
+	}
+
+	Token get(size_t index) const {
+		index = std::min(index, kinds.size() - 1);
+
+		Token token;
+		token.kind = kinds[index];
+		token.data = data[payloads[index]];
+		token.location = location(index);
+
+		return token;
+	}
+
+	void push(const Token &token) {
+		uint32_t payload = 0;
+		switch (token.kind) {
+			case Token_Kind::Literal_Boolean:
+			case Token_Kind::Literal_Character:
+			case Token_Kind::Literal_Integer:
+			case Token_Kind::Literal_Floating_Point:
+			case Token_Kind::Literal_String:
+			case Token_Kind::Symbol_Identifier:
+				payload = static_cast<uint32_t>(data.size());
+				data.push_back(token.data);
+				break;
+
+			default:
+				break;
+		}
+
+		kinds.push_back(token.kind);
+		payloads.push_back(payload);
+		offsets.push_back(token.location.offset);
+	}
+};
+
+// Fixed-size window over an input that can't be mapped (stdin, pipes,
+// FIFOs). The `Tokenizer` consumes bytes from the front of the window; when
+// it runs dry `Tokenizer::refill()` slides the unconsumed tail, starting at
+// the current token, down to the start of `buffer` and tops it up from `fd`.
+// Tokens therefore always sit contiguously in memory, and a token has to be
+// shorter than `capacity` bytes for the stream to hold it.
+//
+struct Source_Stream {
+	static constexpr size_t Default_Capacity = 64 * 1024;
+
+	int fd;
+	File_ID file;
+	char *buffer;
+	size_t capacity;
+	bool at_eof;
+	bool overflowed;
+	bool too_large;
+	size_t discarded; // bytes of the input already slid out of the window
+
+	void open(int fd, File_ID file, size_t capacity = Default_Capacity) {
+		this->fd = fd;
+		this->file = file;
+		this->buffer = reinterpret_cast<char *>(malloc(capacity));
+		this->capacity = capacity;
+		this->at_eof = false;
+		this->overflowed = false;
+		this->too_large = false;
+		this->discarded = 0;
+		internal_verify(buffer, "Failed to allocate %zu byte stream buffer!", capacity);
+	}
+
+	void close() {
+		::close(fd);
+		::free(buffer);
+		buffer = nullptr;
+	}
+};
+
+const char *skip_number_characters(const char *p, const char *end) {
+	while (p < end && (is_identifier_byte(*p) || *p == '.')) p++;
+	return p;
+}
+
+struct Tokenizer {
+	File_ID file;
+	String source;
+	const char *origin = nullptr; // start of the file when it's all in memory
+	const char *token_start = nullptr;
+	Token previous_token { Token_Kind::Delimeter_Newline };
+	std::optional<Token> peeked_token;
+	bool after_prefix_dash = false; // `previous_token` is a `-` that negates what follows
+	Code_Location token_location = {}; // of the token being lexed
+
+	// Set when lexing from a `Source_Stream`, or for any tree that has to
+	// outlive its text. String literal text is copied into `arena` then.
+	//
+	Source_Stream *stream = nullptr;
+	Arena *arena = nullptr;
+
+	// Slides everything from `token_start` onwards to the front of the
+	// stream's window and reads more input behind it. Returns `false` once
+	// the input is exhausted or the current token fills the whole window.
+	//
+	bool refill() {
+		if (!stream || stream->at_eof) {
+			return false;
+		}
+
+		size_t shift = token_start - stream->buffer;
+		size_t kept = source_end() - token_start;
+
+		if (kept == stream->capacity) {
+			stream->overflowed = true;
+			return false;
+		}
+
+		memmove(stream->buffer, token_start, kept);
+		stream->discarded += shift;
+		token_start -= shift;
+		source.chars -= shift;
+
+		ssize_t n;
+		do {
+			n = read(stream->fd, stream->buffer + kept, stream->capacity - kept);
+		} while (n < 0 && errno == EINTR);
+
+		if (n <= 0 || stream->discarded + kept + n > std::numeric_limits<uint32_t>::max()) {
+			stream->at_eof = true;
+			stream->too_large = n > 0;
+			source.size = kept - (source.chars - stream->buffer);
+			return false;
+		}
+
+		source_files.add_chunk(stream->file, stream->buffer + kept, n, stream->discarded + kept);
+
+		source.size = kept + n - (source.chars - stream->buffer);
+		return true;
+	}
+
+	// Makes at least `n` bytes available at the cursor if the input has them.
+	//
+	bool ensure(size_t n) {
+		while (source.size < n) {
+			if (!refill()) return false;
+		}
+		return true;
+	}
+
+	// Runs a `Scanner` routine from the cursor. When streaming, a run that
+	// reaches the end of the window is rescanned after a refill so the whole
+	// run ends up in memory. Unless `keep` is set the bytes already scanned
+	// are consumed before refilling, so runs we don't need the text of
+	// (whitespace, comments) can be longer than the window.
+	//
+	const char *scan_run(const char *(*scan)(const char *p, const char *end), bool keep) {
+		const char *p = scan(source.chars, source_end());
+
+		while (stream && p == source_end()) {
+			if (!keep) {
+				advance_to(p);
+				token_start = source.chars;
+			}
+
+			if (!refill()) break;
+			p = scan(source.chars, source_end());
+		}
+
+		return p;
+	}
+
+	// Decodes the codepoint starting `skip` bytes past the cursor. ASCII
+	// never goes near the decoder. Malformed input comes back as
+	// `Invalid_Codepoint` with a size of 1.
+	//
+	char32_t decode_char(size_t skip, size_t *size) {
+		if (skip >= source.size && !ensure(skip + 1)) {
+			*size = 0;
+			return '\0';
+		}
+
+		unsigned char lead = source.chars[skip];
+		if (lead < 0x80) {
+			*size = 1;
+			return lead;
+		}
+
+		ensure(skip + 4);
+
+		char32_t c;
+		int n = decode_utf8(source.chars + skip, source_end(), &c);
+		if (n <= 0) {
+			*size = 1;
+			return Invalid_Codepoint;
+		}
+
+		*size = n;
+		return c;
+	}
+
+	char32_t peek_char(size_t skip = 0) {
+		size_t size;
+		return decode_char(skip, &size);
+	}
+
+	char32_t next_char() {
+		size_t size;
+		char32_t c = decode_char(0, &size);
+
+		source.chars += size;
+		source.size -= size;
+
+		return c;
+	}
+
+	const char *source_end() const {
+		return source.chars + source.size;
+	}
+
+	void advance_to(const char *p) {
+		size_t n = p - source.chars;
+		source.chars += n;
+		source.size -= n;
+	}
+
+	bool next_char_if_eq(char32_t &actual, char32_t expected) {
+		if (actual == expected) {
+			actual = next_char();
+			return true;
+		}
+		return false;
+	}
+
+	bool match_char(char32_t expected, char32_t *opt_out_c = nullptr) {
+		if (peek_char() == expected) {
+			char32_t c = next_char();
+			if (opt_out_c) *opt_out_c = c;
+			return true;
+		}
+		return false;
+	}
+
+	Code_Location current_location() {
+		size_t offset = stream
+			? stream->discarded + (source.chars - stream->buffer)
+			: source.chars - origin;
+
+		return Code_Location {
+			static_cast<uint32_t>(offset),
+			file,
+		};
+	}
+
+	Token make_token(Token_Kind kind, Token_Data data = {}) {
+		return Token { 
+			kind, 
+			data
+		};
+	}
+
+	// Whether a `-` after a token of `kind` subtracts rather than negates.
+	//
+	static bool ends_operand(Token_Kind kind) {
+		switch (kind) {
+			case Token_Kind::Literal_Null:
+			case Token_Kind::Literal_Boolean:
+			case Token_Kind::Literal_Character:
+			case Token_Kind::Literal_Integer:
+			case Token_Kind::Literal_Floating_Point:
+			case Token_Kind::Literal_String:
+			case Token_Kind::Symbol_Identifier:
+			case Token_Kind::Delimeter_Right_Parenthesis:
+			case Token_Kind::Delimeter_Right_Curly:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	bool is_identifier_start(char32_t c) {
+		return c < 0x80 ? (c == '_' || isalpha(c)) : c < Invalid_Codepoint;
+	}
+
+	bool is_identifier_character(char32_t c) {
+		return c < 0x80 ? (c == '_' || isalnum(c)) : c < Invalid_Codepoint;
+	}
+
+	// Skips whitespace and comments. A comment runs up to, but not including,
+	// its new-line so the new-line still terminates the statement before it.
+	// Runs of new-lines following a `Delimeter_Newline` are collapsed.
+	//
+	char32_t skip_to_begining_of_next_token() {
+		while (true) {
+			token_start = source.chars;
+
+			char32_t c = peek_char();
+			if (c < 0x80 && is_horizontal_whitespace(c)) {
+				advance_to(scan_run(scanner->skip_whitespace, false));
+				c = peek_char();
+			}
+
+			if (c == '/' && peek_char(1) == '/') {
+				advance_to(scan_run(scanner->find_newline, false));
+			} else if (c == '\n' && previous_token.kind == Token_Kind::Delimeter_Newline) {
+				next_char();
+			} else {
+				return c;
+			}
+		}
+	}
+
+	Result<Token> peek() {
+		if (peeked_token.has_value()) {
+			return peeked_token.value();
+		}
+		peeked_token = try_(next());
+		return peeked_token.value();
+	}
+
+	Result<Token> next() {
+		if (peeked_token.has_value()) {
+			previous_token = peeked_token.value();
+			peeked_token = {};
+			return previous_token;
+		}
+
+		Token_Kind before = previous_token.kind;
+
+		char32_t c = skip_to_begining_of_next_token();
+		token_location = current_location();
+		token_start = source.chars;
+
+		verify(c != Invalid_Codepoint, token_location, "Invalid UTF-8 sequence.");
+
+		if (c == '\0') {
+			previous_token = make_token(Token_Kind::Eof);
+		} else if (next_char_if_eq(c, '\n')) {
+			previous_token = make_token(Token_Kind::Delimeter_Newline);
+		} else if (next_char_if_eq(c, '\'')) {
+			previous_token = try_(next_character_token());
+		} else if (next_char_if_eq(c, '\"')) {
+			previous_token = try_(next_string_token());
+		} else if ((c < 0x80 && isdigit(c)) || (c == '.' && isdigit(peek_char(1)))) {
+			previous_token = try_(next_number_token());
+		} else if ((c != '_' && is_identifier_start(c)) || (c == '_' && is_identifier_character(peek_char(1)))) {
+			previous_token = try_(next_keyword_or_identifier_token());
+		} else {
+			next_char();
+			previous_token = try_(next_punctuation_token(c));
+		}
+
+		previous_token.location = token_location;
+		after_prefix_dash = previous_token.kind == Token_Kind::Punctuation_Dash && !ends_operand(before);
+
+		try_(verify_whole_token());
+		verify(!stream || !stream->too_large, token_location, "Input is larger than 4GB.");
+
+		return previous_token;
+	}
+
+	// A run the stream's window cut short isn't the whole token, so nothing
+	// else about it is worth reporting.
+	//
+	Result<void> verify_whole_token() {
+		verify(!stream || !stream->overflowed, token_location, "Token is longer than the %zu byte stream buffer.", stream->capacity);
+		return {};
+	}
+
+	// Lexes everything that's left in `source` in one go.
+	//
+	Result<void> tokenize_all(Token_Buffer &buffer) {
+		buffer.file = file;
+
+		// payload slot 0 is shared by every token without data
+		buffer.data.push_back(Token_Data {});
+
+		while (true) {
+			Token token = try_(next());
+			buffer.push(token);
+			if (token.kind == Token_Kind::Eof) break;
+		}
+
+		return {};
+	}
+
+	Result<Token> next_character_token() {
+		char32_t character = next_char();
+
+		verify(character != Invalid_Codepoint, current_location(), "Invalid UTF-8 sequence in character literal.");
+
+		char utf8[5];
+		encode_utf8(character, utf8);
+		verify(character >= 0x80 || isalnum(character) || ispunct(character) || isspace(character), current_location(), "Invalid character in character literal `%s`.", utf8);
+
+		verify(next_char() == '\'', current_location(), "Expected a single-quote `'`' to terminate character literal.");
+		
+		return make_token(
+			Token_Kind::Literal_Character, 
+			Token_Data { 
+				.character = character 
+			}
+		);
+	}
+
+	Result<Token> next_string_token() {
+		// @TODO:
+		// :HandleStringData
+		//
+		const char *end = scan_run(scanner->find_string_end, true);
+		auto string = String { static_cast<size_t>(end - source.chars), source.chars };
+
+		try_(verify_whole_token());
+		verify(is_valid_utf8(string.chars, end), current_location(), "Invalid UTF-8 sequence in string literal.");
+
+		if (arena) {
+			char *copy = reinterpret_cast<char *>(arena->allocate(string.size, 1));
+			memcpy(copy, string.chars, string.size);
+			string.chars = copy;
+		}
+
+		advance_to(end);
+		next_char();
+
+		return make_token(
+			Token_Kind::Literal_String, 
+			Token_Data { 
+				.string = string 
+			}
+		);
+	}
+
+	// Scans and evaluates a numeric literal in one pass. Integers may be
+	// decimal, `0x` hexadecimal or `0b` binary and may contain `_` separators
+	// between digits. Floating point literals are handed to
+	// `std::from_chars` straight from the source unless they contain
+	// separators.
+	//
+	static bool is_digit(char c, uint64_t base) {
+		switch (base) {
+			case 2:  return c == '0' || c == '1';
+			case 16: return isxdigit(static_cast<unsigned char>(c));
+			default: return isdigit(static_cast<unsigned char>(c));
+		}
+	}
+
+	Result<Token> next_number_token() {
+		Code_Location location = current_location();
+		scan_run(skip_number_characters, true);
+
+		const char *start = source.chars;
+		const char *end = source_end();
+		const char *p = start;
+
+		uint64_t base = 10;
+		if (p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+			base = 16;
+			p += 2;
+		} else if (p + 1 < end && p[0] == '0' && (p[1] == 'b' || p[1] == 'B')) {
+			base = 2;
+			p += 2;
+		}
+
+		uint64_t value = 0;
+		size_t digit_count = 0;
+		bool has_separators = false;
+		bool overflowed = false;
+
+		for (; p < end; p++) {
+			unsigned char c = *p;
+
+			if (c == '_' && digit_count > 0) {
+				verify(p + 1 < end && is_digit(p[1], base), location, "Expected a digit after `_` in numeric literal.");
+				has_separators = true;
+				continue;
+			}
+
+			uint64_t digit;
+			if (c >= '0' && c <= '9') {
+				digit = c - '0';
+			} else if (base == 16 && (c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+				digit = (c | 0x20) - 'a' + 10;
+			} else {
+				break;
+			}
+
+			verify(digit < base, location, "Invalid digit `%c` in binary literal.", c);
+
+			if (value > (std::numeric_limits<uint64_t>::max() - digit) / base) {
+				overflowed = true;
+			}
+			value = value * base + digit;
+			digit_count++;
+		}
+
+		bool is_floating_point = false;
+		if (base == 10 && p + 1 < end && p[0] == '.' && isdigit(p[1])) {
+			is_floating_point = true;
+
+			for (p++; p < end && (isdigit(*p) || *p == '_'); p++) {
+				if (*p == '_') {
+					verify(p + 1 < end && isdigit(p[1]), location, "Expected a digit after `_` in numeric literal.");
+					has_separators = true;
+				}
+			}
+		}
+
+		verify(base == 10 || digit_count > 0, location, "Expected digits after `%.*s` prefix.", 2, start);
+		verify(p >= end || !is_identifier_byte(*p), location, "Invalid character `%c` in numeric literal.", *p);
+
+		advance_to(p);
+
+		if (is_floating_point) {
+			std::string digits;
+			const char *first = start;
+			const char *last = p;
+
+			if (has_separators) {
+				digits.reserve(last - first);
+				for (const char *q = first; q < last; q++) {
+					if (*q != '_') digits.push_back(*q);
+				}
+				first = digits.data();
+				last = digits.data() + digits.size();
+			}
+
+			double number;
+			auto [ptr, ec] = std::from_chars(first, last, number);
+			verify(ec == std::errc() && ptr == last, location, "Invalid floating point literal `%.*s`.", static_cast<int>(p - start), start);
+
+			return make_token(
+				Token_Kind::Literal_Floating_Point,
+				Token_Data {
+					.floating_point = number
+				}
+			);
+		}
+
+		// Hexadecimal and binary literals spell out a bit pattern so they may
+		// use all 64 bits. Decimal literals have to fit in an `i64` once
+		// negated, so the smallest `i64` can be written out.
+		//
+		uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + after_prefix_dash;
+		verify(!overflowed, location, "Integer literal `%.*s` does not fit in 64 bits.", static_cast<int>(p - start), start);
+		verify(base != 10 || value <= limit, location, "Integer literal `%.*s` is too large for `i64`.", static_cast<int>(p - start), start);
+
+		return make_token(
+			Token_Kind::Literal_Integer,
+			Token_Data {
+				.integer = static_cast<int64_t>(value)
+			}
+		);
+	}
+
+	Result<Token> next_keyword_or_identifier_token() {
+		const char *end = scan_run(skip_identifier_utf8, true);
+		auto word = String { static_cast<size_t>(end - source.chars), source.chars };
+
+		try_(verify_whole_token());
+		verify(is_valid_utf8(word.chars, end), current_location(), "Invalid UTF-8 sequence in identifier.");
+		advance_to(end);
+
+		Token token;
+		if (const Keyword *keyword = find_keyword(word)) {
+			if (keyword->kind == Token_Kind::Literal_Boolean) {
+				token = make_token(
+					keyword->kind,
+					Token_Data {
+						.boolean = keyword->boolean
+					}
+				);
+			} else {
+				token = make_token(keyword->kind);
+			}
+		} else {
+			token = make_token(
+				Token_Kind::Symbol_Identifier,
+				Token_Data {
+					.symbol = interner.intern(word)
+				}
+			);
+		}
+
+		return token;
+	}
+
+	Result<Token> next_punctuation_token(char32_t c) {
+		Token token;
+
+		switch (c) {
+			case ';': {
+				token = make_token(Token_Kind::Delimeter_Semicolon);
+			} break;
+			case ',': {
+				token = make_token(Token_Kind::Delimeter_Comma);
+			} break;
+			case '(': {
+				token = make_token(Token_Kind::Delimeter_Left_Parenthesis);
+			} break;
+			case ')': {
+				token = make_token(Token_Kind::Delimeter_Right_Parenthesis);
+			} break;
+			case '{': {
+				token = make_token(Token_Kind::Delimeter_Left_Curly);
+			} break;
+			case '}': {
+				token = make_token(Token_Kind::Delimeter_Right_Curly);
+			} break;
+			case '!': {
+				if (match_char('=')) {
+					token = make_token(Token_Kind::Punctuation_Bang_Equal);
+				} else {
+					token = make_token(Token_Kind::Punctuation_Bang);
+				}
+			} break;
+			case '=': {
+				if (match_char('=')) {
+					token = make_token(Token_Kind::Punctuation_Equal_Equal);
+				} else {
+					token = make_token(Token_Kind::Punctuation_Equal);
+				}
+			} break;
+			case ':': {
+				token = make_token(Token_Kind::Punctuation_Colon);
+			} break; 
+			case '+': {
+				token = make_token(Token_Kind::Punctuation_Plus);
+			} break;
+			case '-': {
+				if (match_char('>')) {
+					token = make_token(Token_Kind::Punctuation_Right_Thin_Arrow);
+				} else {
+					token = make_token(Token_Kind::Punctuation_Dash);
+				}
+			} break;
+			case '*': {
+				token = make_token(Token_Kind::Punctuation_Star);
+			} break;
+			case '/': {
+				token = make_token(Token_Kind::Punctuation_Slash);
+			} break;
+			case '&': {
+				if (match_char('&')) {
+					token = make_token(Token_Kind::Punctuation_Ampersand_Ampersand);
+				} else {
+					todo("Implement `&` tokenization.");
+				}
+			} break;
+			case '|': {
+				if (match_char('|')) {
+					token = make_token(Token_Kind::Punctuation_Pipe_Pipe);
+				} else {
+					todo("Implement `|` tokenization.");
+				}
+			} break;
+
+			default:
+				char utf8[5];
+				encode_utf8(c, utf8);
+				error(current_location(), "Unknown operator `%s`.", utf8);
+		}
+
+		return token;
+	}
+};
+
+struct Parser {
+	bool error;
+	Arena *arena;
+	FILE *errors = stderr;
+	Tokenizer tokenizer;
+
+	// When `tokens` is set the whole file has already been lexed and the
+	// parser just walks the buffer with `cursor`. Otherwise tokens are pulled
+	// from `tokenizer` one at a time.
+	//
+	Token_Buffer *tokens = nullptr;
+	size_t cursor = 0;
+
+	Result<Token> next_token() {
+		if (tokens) {
+			Token token = tokens->get(cursor);
+			if (cursor + 1 < tokens->count()) cursor++;
+			return token;
+		}
+		return tokenizer.next();
+	}
+
+	Result<Token> peek_token() {
+		if (tokens) {
+			return tokens->get(cursor);
+		}
+		return tokenizer.peek();
+	}
+
+	Token_Kind peek_kind() {
+		if (tokens) {
+			return tokens->kind(cursor);
+		}
+
+		// @NOTE: 
+		// Maybe `check()` and `match()` should return `Result<bool>`s or something
+		//
+		return tokenizer.peek().unwrap().kind;
+	}
+
+	bool check(Token_Kind kind) {
+		return peek_kind() == kind;
+	}
+
+	bool skip_check(Token_Kind kind) {
+		skip_newlines();
+		return check(kind);
+	}
+
+	// @NOTE: See above!
+	//
+	bool match(Token_Kind kind) {
+		if (check(kind)) {
+			if (tokens) {
+				cursor++;
+			} else {
+				tokenizer.next().unwrap();
+			}
+			return true;
+		}
+		return false;
+	}
+
+	bool skip_match(Token_Kind kind) {
+		skip_newlines();
+		return match(kind);
+	}
+
+	Result<Token> expect(Token_Kind kind, const char *err, ...) {
+		va_list args;
+		va_start(args, err);
+		auto t = expect(kind, err, args);
+		va_end(args);
+
+		return t;
+	}
+
+	Result<Token> expect(Token_Kind kind, const char *err, va_list args) {
+		auto t = try_(next_token());
+		verify(t.kind == kind, t.location, err, args);
+		return t;
+	}
+
+	Result<Token> skip_expect(Token_Kind kind, const char *err, ...) {
+		skip_newlines();
+
+		va_list args;
+		va_start(args, err);
+		auto t = expect(kind, err, args);
+		va_end(args);
+
+		return t;
+	}
+
+	Result<Token> expect_statement_terminator(const char *err, ...) {
+		va_list args;
+		va_start(args, err);
+		auto t = expect_statement_terminator(err, args);
+		va_end(args);
+
+		return t;
+	}
+
+	Result<Token> expect_statement_terminator(const char *err, va_list args) {
+		auto t = try_(next_token());
+		verify(
+			t.kind == Token_Kind::Delimeter_Newline || t.kind == Token_Kind::Delimeter_Semicolon || t.kind == Token_Kind::Eof,
+			t.location, 
+			err, 
+			args
+		);
+		return t;
+	}
+
+	void skip_newlines() {
+		while (match(Token_Kind::Delimeter_Newline)) {}
+	}
+
+	Result<AST *> parse_declaration() {
+		AST *node = nullptr;
+		
+		if (false) {
+			todo("This is where declaration parsing functions will go.");
+		} else {
+			node = try_(parse_statement());
+		}
+
+		return node;
+	}
+
+	Result<AST *> parse_statement() {
+		AST *node = nullptr;
+
+		if (check(Token_Kind::Delimeter_Left_Curly)) {
+			node = try_(parse_block());
+		} else if (check(Token_Kind::Keyword_If)) {
+			node = try_(parse_if_statement());
+		} else if (check(Token_Kind::Keyword_While)) {
+			node = try_(parse_while_statement());
+		} else {
+			node = try_(parse_expression_or_assignment());
+			try_(expect_statement_terminator("Expected end of statement!"));
+		}
+
+		return node;
+	}
+
+	Result<AST_If *> parse_if_statement() {
+		auto location = try_(skip_expect(Token_Kind::Keyword_If, "Expected `if` statement!")).location;
+		skip_newlines();
+		
+		auto condition = try_(parse_expression());
+
+		auto then_block = try_(parse_block());
+
+		AST *else_block = nullptr;
+		if (skip_match(Token_Kind::Keyword_Else)) {
+			if (skip_check(Token_Kind::Keyword_If)) {
+				else_block = try_(parse_if_statement());
+			} else {
+				else_block = try_(parse_block());
+			}
+		}
+
+		AST_If *node = arena->make<AST_If>();
+		node->kind = AST_Kind::If;
+		node->location = location;
+		node->condition = condition;
+		node->then_block = then_block;
+		node->else_block = else_block;
+
+		return node;
+	}
+
+	Result<AST_Binary *> parse_while_statement() {
+		auto location = try_(skip_expect(Token_Kind::Keyword_While, "Expected `while` statement!")).location;
+		skip_newlines();
+
+		auto condition = try_(parse_expression());
+		auto body = try_(parse_block());
+
+		AST_Binary *node = arena->make<AST_Binary>();
+		node->kind = AST_Kind::Binary_While;
+		node->location = location;
+		node->lhs = condition;
+		node->rhs = body;
+
+		return node;
+	}
+
+	Result<AST *> parse_expression_or_assignment() {
+		return parse_precedence(Token_Precedence::Assignment);
+	}
+
+	Result<AST *> parse_expression() {
+		auto expression = try_(parse_expression_or_assignment());
+
+		verify(expression->kind != AST_Kind::Binary_Assignment, expression->location, "Cannot assign in expression context.");
+		verify(expression->kind != AST_Kind::Variable_Instantiation, expression->location, "Cannot instantiate new variables in expression context.");
+		verify(expression->kind != AST_Kind::Constant_Instantiation, expression->location, "Cannot instantiate new constants in expression context.");
+		verify(expression->kind != AST_Kind::Binary_Variable_Declaration, expression->location, "Cannot declare new variables in expression context.");
+		
+		return expression;
+	}
+
+	Result<AST *> parse_precedence(Token_Precedence precedence) {
+		Token token = try_(next_token());
+		verify(token.kind != Token_Kind::Eof, token.location, "Unexpected end of file!");
+
+		auto previous = try_(parse_prefix(token));
+		internal_verify(previous, "`parse_prefix()` returned null!");
+
+		while (precedence <= try_(peek_token()).precedence()) {
+			Token token = try_(next_token());
+			previous = try_(parse_infix(token, previous));
+			internal_verify(previous, "`parse_infix()` returned null!");
+		}
+
+		return previous;
+	}
+
+	Result<AST *> parse_prefix(Token token) {
+		AST *node = nullptr;
+
+		Code_Location location = token.location;
+
+		switch (token.kind) {
+			case Token_Kind::Symbol_Identifier: {
+				AST_Symbol *identifier = arena->make<AST_Symbol>();
+				identifier->kind = AST_Kind::Symbol_Identifier;
+				identifier->location = location;
+				identifier->symbol = token.data.symbol;
+
+				node = identifier;
+			} break;
+			case Token_Kind::Literal_Null: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_Null;
+				literal->location = location;
+
+				node = literal;
+			} break;
+			case Token_Kind::Literal_Boolean: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_Boolean;
+				literal->location = location;
+				literal->as.boolean = token.data.boolean;
+
+				node = literal;
+			} break;
+			case Token_Kind::Literal_Character: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_Character;
+				literal->location = location;
+				literal->as.character = token.data.character;
+
+				node = literal;
+			} break;
+			case Token_Kind::Literal_Integer: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_Integer;
+				literal->location = location;
+				literal->as.integer = token.data.integer;
+
+				node = literal;
+			} break;
+			case Token_Kind::Literal_Floating_Point: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_Floating_Point;
+				literal->location = location;
+				literal->as.floating_point = token.data.floating_point;
+
+				node = literal;
+			} break;
+			case Token_Kind::Literal_String: {
+				AST_Literal *literal = arena->make<AST_Literal>();
+				literal->kind = AST_Kind::Literal_String;
+				literal->location = location;
+
+				// @TODO:
+				// :HandleStringData
+				//
+				literal->as.string = token.data.string;
+
+				node = literal;
+			} break;
+			case Token_Kind::Punctuation_Bang:
+				node = try_(parse_unary(AST_Kind::Unary_Not, location));
+				break;
+			case Token_Kind::Punctuation_Dash:
+				if (check(Token_Kind::Literal_Integer)) {
+					Token literal_token = try_(next_token());
+					AST_Literal *literal = ast_cast<AST_Literal>(try_(parse_prefix(literal_token)));
+
+					// Wraps, so the smallest `i64` negates to itself.
+					literal->as.integer = static_cast<int64_t>(0 - static_cast<uint64_t>(literal->as.integer));
+					literal->location = location;
+
+					node = literal;
+				} else if (check(Token_Kind::Literal_Floating_Point)) {
+					Token literal_token = try_(next_token());
+					AST_Literal *literal = ast_cast<AST_Literal>(try_(parse_prefix(literal_token)));
+
+					literal->as.floating_point = -literal->as.floating_point;
+					literal->location = location;
+
+					node = literal;
+				} else {
+					node = try_(parse_unary(AST_Kind::Unary_Negate, location));
+				}
+				break;
+			
+			case Token_Kind::Keyword_Fn:
+				node = try_(parse_function(token));
+				break;
+
+			default:
+				error(location, "`%s` is not a prefix operation!", token.display_str().c_str());
+		}
+
+		return node;
+	}
+
+	Result<AST *> parse_infix(Token token, AST *previous) {
+		AST *node = nullptr;
+		auto precedence = token.precedence();
+		auto location = token.location;
+
+		switch (token.kind) {
+			case Token_Kind::Punctuation_Colon:
+				node = try_(parse_colon(previous, location));
+				break;
+			case Token_Kind::Punctuation_Bang_Equal:
+				node = try_(parse_binary(AST_Kind::Binary_NE, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Equal_Equal:
+				node = try_(parse_binary(AST_Kind::Binary_EQ, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Equal:
+				node = try_(parse_binary(AST_Kind::Binary_Assignment, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Plus:
+				node = try_(parse_binary(AST_Kind::Binary_Add, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Dash:
+				node = try_(parse_binary(AST_Kind::Binary_Subtract, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Star:
+				node = try_(parse_binary(AST_Kind::Binary_Multiply, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Slash:
+				node = try_(parse_binary(AST_Kind::Binary_Divide, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Ampersand_Ampersand:
+				node = try_(parse_binary(AST_Kind::Binary_And, precedence, previous, location));
+				break;
+			case Token_Kind::Punctuation_Pipe_Pipe:
+				node = try_(parse_binary(AST_Kind::Binary_Or, precedence, previous, location));
+				break;
+			case Token_Kind::Delimeter_Left_Parenthesis:
+				node = try_(parse_call(previous, location));
+				break;
+
+			default:
+				error(location, "`%s` is not an infix operation!", token.display_str().c_str());
+		}
+
+		return node;
+	}
+
+	Result<AST *> parse_unary(AST_Kind kind, Code_Location location) {
+		skip_newlines();
+
+		auto sub = try_(parse_precedence(Token_Precedence::Unary));
+
+		auto unary = arena->make<AST_Unary>();
+		unary->kind = kind;
+		unary->location = location;
+		unary->sub = sub;
+
+		return unary;
+	}
+
+	Result<AST *> parse_binary(AST_Kind kind, Token_Precedence precedence, AST *lhs, Code_Location location) {
+		skip_newlines();
+
+		auto rhs = try_(parse_precedence(precedence + 1));
+
+		auto binary = arena->make<AST_Binary>();
+		binary->kind = kind;
+		binary->location = location;
+		binary->lhs = lhs;
+		binary->rhs = rhs;
+
+		return binary;
+	}
+
+	Result<AST *> parse_call(AST *callee, Code_Location location) {
+		AST_Block *arguments = arena->make<AST_Block>();
+		arguments->kind = AST_Kind::Block_Comma;
+		arguments->location = location;
+
+		do {
+			if (skip_check(Token_Kind::Delimeter_Right_Parenthesis)) break;
+			arguments->nodes.push_back(try_(parse_expression()));
+		} while (skip_match(Token_Kind::Delimeter_Comma));
+
+		try_(skip_expect(Token_Kind::Delimeter_Right_Parenthesis, "Expected `)` to terminate argument list."));
+
+		AST_Binary *call = arena->make<AST_Binary>();
+		call->kind = AST_Kind::Binary_Call;
+		call->location = location;
+		call->lhs = callee;
+		call->rhs = arguments;
+
+		return call;
+	}
+
+	Result<AST_Block *> parse_block() {
+		auto location = try_(skip_expect(Token_Kind::Delimeter_Left_Curly, "Expected `{` to begin block!")).location;
+
+		auto block = arena->make<AST_Block>();
+		block->kind = AST_Kind::Block;
+
+		while (true) {
+			skip_newlines();
+			if (check(Token_Kind::Delimeter_Right_Curly) || check(Token_Kind::Eof)) break;
+
+			auto node = try_(parse_declaration());
+			block->nodes.push_back(node);
+		}
+
+		try_(skip_expect(Token_Kind::Delimeter_Right_Curly, "Expected `}` to terminate block!"));
+		block->location = location;
+
+		return block;
+	}
+
+	Result<AST *> parse_colon(AST *previous, Code_Location location) {
+		AST *node = nullptr;
+
+		if (match(Token_Kind::Punctuation_Equal)) {
+			auto initializer = try_(parse_expression());
+
+			AST_Variable_Instantiation *inst = arena->make<AST_Variable_Instantiation>();
+			inst->kind = AST_Kind::Variable_Instantiation;
+			inst->location = location;
+
+			AST_Symbol *symbol = ast_cast_if<AST_Symbol>(previous);
+			verify(symbol, previous->location, "Expected a symbol on the left hand side of variable instantiation.");
+			inst->symbol = symbol;
+
+			inst->initializer = initializer;
+
+			inst->specified_type_signature = nullptr;
+
+			node = inst;
+		} else if (match(Token_Kind::Punctuation_Colon)) {
+			auto initializer = try_(parse_expression());
+
+			AST_Variable_Instantiation *inst = arena->make<AST_Variable_Instantiation>();
+			inst->kind = AST_Kind::Constant_Instantiation;
+			inst->location = location;
+
+			AST_Symbol *symbol = ast_cast_if<AST_Symbol>(previous);
+			verify(symbol, previous->location, "Expected a symbol on the left hand side of constant declaration.");
+			inst->symbol = symbol;
+
+			inst->initializer = initializer;
+
+			inst->specified_type_signature = nullptr;
+
+			node = inst;
+		} else {
+			todo("Variable declarations not yet implemented. previous.location = %s", previous->location.debug_str().c_str());
+		}
+
+		return node;
+	}
+
+	Result<AST *> parse_function(Token fn_token) {
+		auto parameters_location = try_(skip_expect(Token_Kind::Delimeter_Left_Parenthesis, "Expected `(` after `fn` keyword.")).location;
+
+		// @NOTE:
+		// @TODO:
+		// Should this be factored out into some sort of `parse_comma_separated_expressions()`?
+		//
+		AST_Block *parameters = arena->make<AST_Block>();
+		parameters->kind = AST_Kind::Block_Comma;
+		parameters->location = parameters_location;
+
+		do {
+			if (skip_check(Token_Kind::Delimeter_Right_Parenthesis)) break;
+			Token param_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected either `)` or parameter name."));
+			
+			Code_Location param_location = try_(skip_expect(Token_Kind::Punctuation_Colon, "Expected `:` after parameter name.")).location;
+
+			// @TODO:
+			// :ImplementParseTypeSignature
+			//
+			Token type_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected type name for parameter."));
+
+			AST_Symbol *param_ident = arena->make<AST_Symbol>();
+			param_ident->kind = AST_Kind::Symbol_Identifier;
+			param_ident->location = param_token.location;
+			param_ident->symbol = param_token.data.symbol;
+
+			AST_Symbol *type_ident = arena->make<AST_Symbol>();
+			type_ident->kind = AST_Kind::Symbol_Identifier;
+			type_ident->location = type_token.location;
+			type_ident->symbol = type_token.data.symbol;
+
+			AST_Binary *param_node = arena->make<AST_Binary>();
+			param_node->kind = AST_Kind::Binary_Variable_Declaration;
+			param_node->location = param_location;
+			param_node->lhs = param_ident;
+			param_node->rhs = type_ident;
+
+			parameters->nodes.push_back(param_node);
+		} while (skip_match(Token_Kind::Delimeter_Comma) || check(Token_Kind::Eof));
+
+		try_(expect(Token_Kind::Delimeter_Right_Parenthesis, "Expected `)` to terminate parameter list."));
+
+		AST *return_type = nullptr;
+		if (skip_match(Token_Kind::Punctuation_Right_Thin_Arrow)) {
+			// @TODO:
+			// :ImplementParseTypeSignature
+			//
+			Token type_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected type name for parameter."));
+			AST_Symbol *type_ident = arena->make<AST_Symbol>();
+			type_ident->kind = AST_Kind::Symbol_Identifier;
+			type_ident->location = type_token.location;
+			type_ident->symbol = type_token.data.symbol;
+
+			return_type = type_ident;
+		}
+
+		AST_Block *body = try_(parse_block());
+
+		AST_Function_Declaration *decl = arena->make<AST_Function_Declaration>();
+		decl->kind = AST_Kind::Function_Declaration;
+		decl->location = fn_token.location;
+		decl->parameters = parameters;
+		decl->return_type_signature = return_type;
+		decl->body = body;
+
+		return decl;
+	}
+};
+
+// When `starts` is given, the offset each top-level declaration begins at
+// is appended to it.
+//
+AST_Block *parse_top_level(Parser &p, std::vector<uint32_t> *starts = nullptr) {
+	AST_Block *ast = p.arena->make<AST_Block>();
+	ast->kind = AST_Kind::Block;
+	ast->location = Code_Location { 0, p.tokenizer.file };
+
+	while (true) {
+		p.skip_newlines();
+		if (p.check(Token_Kind::Eof)) break;
+
+		if (starts) starts->push_back(p.peek_token().unwrap().location.offset);
+
+		auto result = p.parse_declaration();
+		if (result.is_err()) {
+			p.error = true;
+			result.err()->print(p.errors);
+			continue;
+		}
+
+		ast->nodes.push_back(result.ok());
+	}
+
+	return p.error ? nullptr : ast;
+}
+
+AST_Block *parse(Arena &arena, String source, File_ID file, bool pretokenize = true, FILE *errors = stderr) {
+	Parser p;
+	p.error = false;
+	p.arena = &arena;
+	p.errors = errors;
+	p.tokenizer.source = source;
+	p.tokenizer.origin = source.chars;
+	p.tokenizer.file = file;
+
+	Token_Buffer tokens;
+	if (pretokenize) {
+		auto result = p.tokenizer.tokenize_all(tokens);
+		if (result.is_err()) {
+			result.err()->print(errors);
+			return nullptr;
+		}
+		p.tokens = &tokens;
+	}
+
+	return parse_top_level(p);
+}
+
+// Parses straight off a stream, pulling tokens lazily so only the stream's
+// window is ever resident.
+//
+AST_Block *parse(Arena &arena, Source_Stream &stream, FILE *errors = stderr) {
+	Parser p;
+	p.error = false;
+	p.arena = &arena;
+	p.errors = errors;
+	p.tokenizer.source = String { 0, stream.buffer };
+	p.tokenizer.file = stream.file;
+	p.tokenizer.stream = &stream;
+	p.tokenizer.arena = &arena;
+
+	return parse_top_level(p);
+}
+
+//
+//
+// Incremental Parsing
+//
+//
+
+// Replaces `removed` bytes at `offset` with `inserted`. Offsets are always
+// into the text as it was before any of the edits in the same batch, and a
+// batch is sorted by offset without overlaps.
+//
+struct Text_Edit {
+	uint32_t offset;
+	uint32_t removed;
+	String inserted;
+};
+
+std::string apply_edits(String source, const std::vector<Text_Edit> &edits) {
+	std::string text;
+	size_t copied = 0;
+
+	for (const Text_Edit &edit : edits) {
+		internal_verify(edit.offset >= copied && edit.offset + edit.removed <= source.size, "Text edits must be sorted, disjoint and inside the text!");
+		text.append(source.chars + copied, edit.offset - copied);
+		text.append(edit.inserted.chars, edit.inserted.size);
+		copied = edit.offset + edit.removed;
+	}
+
+	text.append(source.chars + copied, source.size - copied);
+	return text;
+}
+
+// A parsed file that can be brought up to date after an edit by reparsing
+// only the top-level declarations the edit touches. `starts` is where each
+// of `ast`'s declarations begins; a declaration runs until the next one
+// starts. String literals are copied into `arena`, so the tree never points
+// into `source` and old text can be freed once it's been replaced. Replaced
+// declarations stay in `arena` until the caller resets it.
+//
+// Declarations kept across an edit before them aren't walked to move their
+// locations. Instead `shifts` holds how far each one's locations are behind
+// the text, and `flatten` adds it on the way out, so an edit only costs
+// the declarations it touches. Read the tree through `flatten`.
+//
+struct Incremental_Parse {
+	Arena *arena = nullptr;
+	File_ID file;
+	String source;
+	AST_Block *ast = nullptr;
+	std::vector<uint32_t> starts;
+	std::vector<int64_t> shifts;
+
+	// Parses all of `text`. Returns false and prints the errors if it
+	// doesn't parse, in which case the next `reparse` parses it all again.
+	//
+	bool parse(String text, FILE *errors = stderr) {
+		source = text;
+		source_files.replace_text(file, text);
+
+		Parser p = parser(text, 0, text.size, errors);
+		Token_Buffer tokens;
+
+		auto result = p.tokenizer.tokenize_all(tokens);
+		if (result.is_err()) {
+			result.err()->print(errors);
+			ast = nullptr;
+			return false;
+		}
+		p.tokens = &tokens;
+
+		starts.clear();
+		ast = parse_top_level(p, &starts);
+		shifts.assign(starts.size(), 0);
+		return ast != nullptr;
+	}
+
+	// The tree with every location where it is in `source` now.
+	//
+	Flat_AST flatten() const {
+		Flat_AST flat;
+		Flattener flattener { &flat };
+
+		std::vector<AST_Index> declarations;
+		declarations.reserve(ast->nodes.size());
+		for (size_t i = 0; i < ast->nodes.size(); i++) {
+			AST_Index first = static_cast<AST_Index>(flat.count());
+			declarations.push_back(flattener.flatten(ast->nodes[i]));
+
+			for (AST_Index n = first; shifts[i] && n < flat.count(); n++) {
+				flat.locations[n].offset = static_cast<uint32_t>(flat.locations[n].offset + shifts[i]);
+			}
+		}
+
+		uint32_t first = static_cast<uint32_t>(flat.children.size());
+		flat.children.insert(flat.children.end(), declarations.begin(), declarations.end());
+		flat.root = flattener.push(ast, first, static_cast<uint32_t>(declarations.size()));
+		return flat;
+	}
+
+	// Brings the tree up to date with `text`, which must be `source` with
+	// `edits` applied. Declarations before an edit are kept as they are and
+	// those after it are kept with their shifts moved; only the ones an
+	// edit touches are lexed and parsed again. Whenever a partial reparse
+	// can't vouch for its result the whole file is parsed instead, which is
+	// also what reports any errors.
+	//
+	bool reparse(String text, const std::vector<Text_Edit> &edits, FILE *errors = stderr) {
+		if (!ast || starts.empty() || edits.empty()) {
+			return parse(text, errors);
+		}
+
+		std::vector<AST *> nodes;
+		std::vector<uint32_t> new_starts;
+		std::vector<int64_t> new_shifts;
+		nodes.reserve(ast->nodes.size());
+		new_starts.reserve(starts.size());
+		new_shifts.reserve(shifts.size());
+
+		size_t kept = 0; // old declarations before this have been dealt with
+		int64_t delta = 0; // how far the edits so far have moved the text
+
+		for (size_t e = 0; e < edits.size();) {
+			// An edit damages every declaration on the lines it touches, plus
+			// the one before in case it continues into them (`if` ... `else`).
+			// Edits whose damage meets are reparsed as one region.
+			//
+			size_t lo = std::lower_bound(starts.begin(), starts.end(), line_begin(edits[e].offset)) - starts.begin();
+			lo = std::max(kept, lo ? lo - 1 : 0);
+
+			size_t hi;
+			uint32_t region_end;
+			int64_t region_delta = delta;
+
+			do {
+				uint32_t last_line = line_end(edits[e].offset + edits[e].removed);
+				hi = std::upper_bound(starts.begin(), starts.end(), last_line) - starts.begin();
+				region_end = hi < starts.size() ? starts[hi] : static_cast<uint32_t>(source.size);
+
+				region_delta += static_cast<int64_t>(edits[e].inserted.size) - edits[e].removed;
+				e++;
+			} while (e < edits.size() && line_begin(edits[e].offset) <= region_end);
+
+			keep(kept, lo, delta, nodes, new_starts, new_shifts);
+
+			uint32_t region_begin = lo ? starts[lo] : 0;
+			if (!parse_region(text, region_begin + delta, region_end + region_delta, nodes, new_starts, new_shifts, errors)) {
+				return parse(text, errors);
+			}
+
+			kept = hi;
+			delta = region_delta;
+		}
+
+		keep(kept, starts.size(), delta, nodes, new_starts, new_shifts);
+
+		source = text;
+		source_files.replace_text(file, text);
+		ast->nodes.swap(nodes);
+		starts.swap(new_starts);
+		shifts.swap(new_shifts);
+		return true;
+	}
+
+private:
+	Parser parser(String text, size_t begin, size_t end, FILE *errors) {
+		Parser p;
+		p.error = false;
+		p.arena = arena;
+		p.errors = errors;
+		p.tokenizer.source = String { end - begin, text.chars + begin };
+		p.tokenizer.origin = text.chars;
+		p.tokenizer.file = file;
+		p.tokenizer.arena = arena;
+		return p;
+	}
+
+	uint32_t line_begin(uint32_t offset) const {
+		while (offset > 0 && source.chars[offset - 1] != '\n') offset--;
+		return offset;
+	}
+
+	uint32_t line_end(uint32_t offset) const {
+		const char *end = source.chars + source.size;
+		return static_cast<uint32_t>(scanner->find_newline(source.chars + offset, end) - source.chars);
+	}
+
+	void keep(size_t begin, size_t end, int64_t delta, std::vector<AST *> &nodes, std::vector<uint32_t> &new_starts, std::vector<int64_t> &new_shifts) {
+		nodes.insert(nodes.end(), ast->nodes.begin() + begin, ast->nodes.begin() + end);
+		for (size_t i = begin; i < end; i++) {
+			new_starts.push_back(static_cast<uint32_t>(starts[i] + delta));
+			new_shifts.push_back(shifts[i] + delta);
+		}
+	}
+
+	// Parses the declarations in `[begin, end)` of `text`. The region always
+	// starts at a declaration and ends at one or at the end of the file, so
+	// it fails rather than guess if anything in it doesn't parse on its own.
+	//
+	bool parse_region(String text, size_t begin, size_t end, std::vector<AST *> &nodes, std::vector<uint32_t> &new_starts, std::vector<int64_t> &new_shifts, FILE *errors) {
+		Parser p = parser(text, begin, end, errors);
+		Token_Buffer tokens;
+
+		if (p.tokenizer.tokenize_all(tokens).is_err()) return false;
+
+		// A string literal still open when the region ends would have run on
+		// into the text after it.
+		//
+		if (tokens.count() >= 2 && tokens.kind(tokens.count() - 2) == Token_Kind::Literal_String) return false;
+
+		p.tokens = &tokens;
+
+		while (true) {
+			p.skip_newlines();
+			if (p.check(Token_Kind::Eof)) return true;
+
+			new_starts.push_back(tokens.location(p.cursor).offset);
+			new_shifts.push_back(0);
+
+			auto result = p.parse_declaration();
+			if (result.is_err()) return false;
+			nodes.push_back(result.ok());
+		}
+	}
+};
+
+//
+//
+// Thread Pool
+//
+//
+
+// Counts the outstanding tasks submitted under it so a caller can wait for
+// just those.
+//
+struct Task_Group {
+	std::atomic<size_t> pending { 0 };
+
+	bool done() const {
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+};
+
+// Work-stealing pool. Every worker owns a deque: it pushes and pops its own
+// tasks at the back (so nested work stays cache-warm) and, when that runs
+// dry, steals from the front of the others'. Threads outside the pool
+// submit to a shared deque at index 0. Waiting on a `Task_Group` runs tasks
+// while there are any, so the caller counts as one of the `--jobs` threads
+// and tasks may wait on tasks they spawn without deadlocking. With nothing
+// left to run, it sleeps until a group finishes or more work is queued.
+//
+struct Thread_Pool {
+	using Task = std::function<void()>;
+
+	struct Queue {
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex sleep_lock;
+	std::condition_variable wake;
+	std::atomic<size_t> queued { 0 };
+	bool stopping = false;
+
+	static thread_local size_t current_queue;
+
+	Thread_Pool() = default;
+	Thread_Pool(const Thread_Pool &) = delete;
+	Thread_Pool &operator=(const Thread_Pool &) = delete;
+
+	~Thread_Pool() {
+		stop();
+	}
+
+	// `jobs` counts the thread that will be waiting, so `jobs - 1` workers
+	// are started and `--jobs 1` runs everything on the caller.
+	//
+	void start(size_t jobs) {
+		size_t worker_count = std::max<size_t>(jobs, 1) - 1;
+
+		queues.reserve(worker_count + 1);
+		for (size_t i = 0; i <= worker_count; i++) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+
+		threads.reserve(worker_count);
+		for (size_t i = 1; i <= worker_count; i++) {
+			threads.emplace_back([this, i]() { work(i); });
+		}
+	}
+
+	void stop() {
+		{
+			std::lock_guard<std::mutex> guard(sleep_lock);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		threads.clear();
+	}
+
+	void submit(Task_Group &group, Task task) {
+		group.pending.fetch_add(1, std::memory_order_relaxed);
+
+		// Counted before it's visible so `queued` never dips below the
+		// number of tasks actually sitting in the queues.
+		queued.fetch_add(1, std::memory_order_relaxed);
+
+		Queue &queue = *queues[current_queue];
+		{
+			std::lock_guard<std::mutex> guard(queue.lock);
+			queue.tasks.push_back([this, &group, task = std::move(task)]() {
+				task();
+
+				// The group may be gone as soon as it's done, so only the
+				// pool is touched after the last task counts itself off.
+				if (group.pending.fetch_sub(1, std::memory_order_release) == 1) {
+					{
+						std::lock_guard<std::mutex> guard(sleep_lock);
+					}
+					wake.notify_all();
+				}
+			});
+		}
+
+		// Taking `sleep_lock` orders the push before any worker's
+		// check-then-sleep, so the wake-up can't be missed.
+		{
+			std::lock_guard<std::mutex> guard(sleep_lock);
+		}
+		wake.notify_one();
+	}
+
+	void wait(Task_Group &group) {
+		while (!group.done()) {
+			if (run_one()) continue;
+
+			std::unique_lock<std::mutex> guard(sleep_lock);
+			wake.wait(guard, [this, &group]() { return group.done() || queued.load(std::memory_order_relaxed) > 0; });
+		}
+	}
+
+private:
+	bool take(Task &task) {
+		size_t self = current_queue;
+
+		{
+			Queue &own = *queues[self];
+			std::lock_guard<std::mutex> guard(own.lock);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		for (size_t i = 1; i < queues.size() + 1; i++) {
+			Queue &victim = *queues[(self + i) % queues.size()];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool run_one() {
+		if (queued.load(std::memory_order_relaxed) == 0) return false;
+
+		Task task;
+		if (!take(task)) return false;
+
+		queued.fetch_sub(1, std::memory_order_relaxed);
+		task();
+		return true;
+	}
+
+	void work(size_t index) {
+		current_queue = index;
+
+		while (true) {
+			if (run_one()) continue;
+
+			std::unique_lock<std::mutex> guard(sleep_lock);
+			wake.wait(guard, [this]() { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+			if (stopping) return;
+		}
+	}
+};
+
+thread_local size_t Thread_Pool::current_queue = 0;
+
+//
+//
+// Typechecking
+//
+//
+
+struct Typechecker {
+	//
+	// Child Data Structures
+	//
+	struct Binding {
+		enum {
+			Variable,
+			Type,
+			Function,
+			Module,
+		} kind;
+
+		struct Function_Binding {
+			PID pid;
+			Type_ID type;
+		};
+
+		union {
+			Type_ID ty;
+			Function_Binding fn;
+			// ::Module *mod;
+		};
+
+		uint32_t slot; // variables only
+
+		static Binding variable(Type_ID type, uint32_t slot) {
+			Binding b;
+			b.kind = Variable;
+			b.ty = type;
+			b.slot = slot;
+			return b;
+		}
+
+		static Binding type(Type_ID type) {
+			Binding b;
+			b.kind = Type;
+			b.ty = type;
+			return b;
+		}
+
+		static Binding function(PID pid, Type_ID fn_type) {
+			Binding b;
+			b.kind = Function;
+			b.fn.pid = pid;
+			b.fn.type = fn_type;
+			return b;
+		}
+
+		/* @TODO:
+			for when we implement modules
+		static Binding module(::Module *module) {
+			return Binding {
+				.kind = Module,
+				.mod = module
+			};
+		}
+		*/
+	};
+
+	// Every binding in scope lives in one open-addressing table keyed by
+	// symbol, which only holds the innermost binding for each name. Whatever
+	// a new binding hides is pushed onto `undo`, and a scope is just the
+	// length `undo` had when it began, so leaving a scope restores exactly
+	// what it shadowed and a lookup is one probe however deep the nesting.
+	//
+	struct Scope_Table {
+		static constexpr Symbol_ID Empty = std::numeric_limits<Symbol_ID>::max();
+		static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+		struct Entry {
+			Symbol_ID symbol = Empty;
+			uint32_t depth = None;    // scope the binding was made in, `None` when unbound
+			uint32_t shadowed = None; // index into `undo` of the entry this one hides
+			Binding binding;
+		};
+
+		std::vector<Entry> slots;
+		size_t occupied = 0;
+		std::vector<Entry> undo;
+		std::vector<uint32_t> marks;
+
+		uint32_t depth() const {
+			return static_cast<uint32_t>(marks.size()) - 1;
+		}
+
+		void begin() {
+			marks.push_back(static_cast<uint32_t>(undo.size()));
+		}
+
+		void end() {
+			internal_verify(!marks.empty(), "No scope to end!");
+
+			uint32_t mark = marks.back();
+			marks.pop_back();
+
+			while (undo.size() > mark) {
+				*probe(undo.back().symbol) = undo.back();
+				undo.pop_back();
+			}
+		}
+
+		// The innermost binding of `id`, or `nullptr`.
+		//
+		const Entry *find(Symbol_ID id) const {
+			if (slots.empty()) return nullptr;
+
+			const Entry *entry = const_cast<Scope_Table *>(this)->probe(id);
+			return entry->depth == None ? nullptr : entry;
+		}
+
+		// The binding `entry` hides, or `nullptr`.
+		//
+		const Entry *shadowed(const Entry *entry) const {
+			if (entry->shadowed == None) return nullptr;
+
+			const Entry *previous = &undo[entry->shadowed];
+			return previous->depth == None ? nullptr : previous;
+		}
+
+		// Fails if `id` is already bound in the current scope.
+		//
+		bool put(Symbol_ID id, Binding binding) {
+			internal_verify(!marks.empty(), "No scope to bind `%s` in!", interner.get(id).str().c_str());
+
+			if ((occupied + 1) * 2 > slots.size()) grow();
+
+			Entry *entry = probe(id);
+			if (entry->depth == depth()) return false;
+
+			if (entry->symbol == Empty) {
+				entry->symbol = id;
+				occupied++;
+			}
+
+			undo.push_back(*entry);
+
+			entry->depth = depth();
+			entry->shadowed = static_cast<uint32_t>(undo.size() - 1);
+			entry->binding = binding;
+
+			return true;
+		}
+
+	private:
+		Entry *probe(Symbol_ID id) {
+			size_t mask = slots.size() - 1;
+			size_t i = (id * 0x9E3779B9u) & mask;
+
+			while (slots[i].symbol != id && slots[i].symbol != Empty) {
+				i = (i + 1) & mask;
+			}
+
+			return &slots[i];
+		}
+
+		void grow() {
+			std::vector<Entry> old = std::move(slots);
+			slots.assign(std::max<size_t>(old.size() * 2, 64), Entry {});
+
+			for (const Entry &entry : old) {
+				if (entry.symbol != Empty) *probe(entry.symbol) = entry;
+			}
+		}
+	};
+
+	//
+	// Fields
+	//
+	// Interpreter *interp;
+	// Module *module;
+	const Scope_Table *globals; // depth 0 of the outermost `Typechecker`'s scopes
+	// Function_Definition *function;
+	Typechecker *parent;
+	// bool has_return;
+	Scope_Table scopes;
+
+	// Every variable gets its own slot in the frame of the function it's
+	// declared in (the top level counts as one). Slots are never reused,
+	// so a variable's slot is free to hold temporaries until it's declared.
+	//
+	Size next_slot = 0;
+
+	//
+	// Constructor B.S
+	//
+	Typechecker() = default;
+
+	/*
+	Typechecker(Interpreter *interp, Module *module) {
+		this->interp = interp;
+		this->module = module;
+		this->function = nullptr;
+		this->parent = nullptr;
+		this->has_return = false;
+		begin_scope(); // global scope
+		globals = &scopes;
+	}
+	*/
+
+	/*
+	Typechecker(Typer &t, Function_Definition *function) {
+		this->interp = t.interp;
+		this->module = t.module;
+		this->globals = t.globals;
+		this->function = function;
+		this->parent = &t;
+		this->has_return = false;
+	}
+	*/
+
+	void begin_scope() {
+		scopes.begin();
+	}
+
+	void end_scope() {
+		scopes.end();
+	}
+
+	std::optional<Binding> find_binding_by_id(Symbol_ID id, bool checking_through_parent = false) {
+		for (const Scope_Table::Entry *entry = scopes.find(id); entry; entry = scopes.shadowed(entry)) {
+			if (checking_through_parent && entry->binding.kind == Binding::Variable) continue;
+			return entry->binding;
+		}
+
+		if (parent) {
+			auto optional_binding = parent->find_binding_by_id(id, true);
+			if (optional_binding.has_value()) {
+				return *optional_binding;
+			}
+		}
+
+		if (!checking_through_parent && globals != &scopes) {
+			for (const Scope_Table::Entry *entry = globals->find(id); entry; entry = globals->shadowed(entry)) {
+				if (entry->depth == 0) return entry->binding;
+			}
+		}
+
+		return {};
+	}
+
+	Result<void> put_binding(Code_Location location, Symbol_ID id, Binding binding) {
+		verify(scopes.put(id, binding), location, "Redefinition of `%s`", interner.get(id).str().c_str());
+		return {};
+	}
+
+	Result<uint32_t> bind_variable(Code_Location location, Symbol_ID id, Type_ID type) {
+		verify(next_slot < std::numeric_limits<uint32_t>::max(), location, "Too many variables in one function.");
+
+		uint32_t slot = static_cast<uint32_t>(next_slot);
+		try_(put_binding(location, id, Binding::variable(type, slot)));
+
+		next_slot++;
+		return slot;
+	}
+
+	// Result<void> bind_type(Code_Location location, Symbol_ID id, Type type) {
+	// 	internal_verify(type.kind == Type_Kind::Type, "Attempted to bind a type name to something other than a type! `%s` to `%s`", interner.get(id).str().c_str(), type.debug_str().c_str());
+	// 	return put_binding(location, id, Binding::type(type));
+	// }
+
+	Result<void> bind_function(Code_Location location, Symbol_ID id, PID pid, Type_ID type) {
+		internal_verify(type_table[type].kind == Type_Kind::Function, "Attempted to bind a function name to something other than a function-type! `%s` to `%s`", interner.get(id).str().c_str(), type_table.display_str(type).c_str());
+		return put_binding(location, id, Binding::function(pid, type));
+	}
+
+	/*
+	Result<void> bind_module(Code_Location location, Symbol_ID id, Module *module) {
+		return put_binding(location, id, Binding::module(module));
+	}
+	*/
+
+	// Numeric literals are typed at the smallest size that holds them, but a
+	// literal takes the type of whatever it meets, as long as that's the same
+	// kind and the literal's value fits: the other operand, the parameter
+	// it's passed to, the variable it's assigned to. So `x + 1` is an `i64`
+	// add when `x` is an `i64`, and `a / 2.0` an `f32` divide when `a` is an
+	// `f32`. Arithmetic on nothing but literals is retyped the same way, so
+	// `x + 72 * 3` is all `i64`. Only sized values of different widths are a
+	// mismatch.
+	//
+	void coerce_literal_operands(AST_Binary *binary) {
+		if (binary->lhs->type == binary->rhs->type) return;
+		if (!coerce_literal(binary->rhs, binary->lhs->type)) {
+			coerce_literal(binary->lhs, binary->rhs->type);
+		}
+	}
+
+	bool coerce_literal(AST *node, Type_ID target) {
+		const Type &type = type_table[node->type];
+		const Type &target_type = type_table[target];
+
+		if (type.kind != target_type.kind) return false;
+		if (type.kind != Type_Kind::Integer && type.kind != Type_Kind::Floating_Point) return false;
+		if (!literal_fits(node, target_type.data.primitive.size)) return false;
+
+		if (node->kind == AST_Kind::Unary_Negate) {
+			coerce_literal(ast_cast<AST_Unary>(node)->sub, target);
+		} else if (AST_Binary *binary = ast_cast_if<AST_Binary>(node)) {
+			coerce_literal(binary->lhs, target);
+			coerce_literal(binary->rhs, target);
+		}
+
+		node->type = target;
+		return true;
+	}
+
+	static bool literal_fits(AST *node, Size size) {
+		switch (node->kind) {
+			case AST_Kind::Literal_Integer:
+				return minimum_required_size_for_literal(ast_cast<AST_Literal>(node)->as.integer) <= size;
+			case AST_Kind::Literal_Floating_Point:
+				return size == sizeof(Runtime_Type::Floating_Point64) || !(std::abs(ast_cast<AST_Literal>(node)->as.floating_point) > std::numeric_limits<Runtime_Type::Floating_Point32>::max());
+			case AST_Kind::Unary_Negate:
+				return literal_fits(ast_cast<AST_Unary>(node)->sub, size);
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				return literal_fits(binary->lhs, size) && literal_fits(binary->rhs, size);
+			}
+			default:
+				return false;
+		}
+	}
+
+	// @TODO:
+	// :ImplementParseTypeSignature
+	// Type signatures are bare type names until the parser knows more.
+	//
+	Result<Type_ID> resolve_type_signature(AST *signature) {
+		AST_Symbol *name = ast_cast_if<AST_Symbol>(signature);
+		verify(name, signature->location, "Expected a type name.");
+
+		auto opt_binding = find_binding_by_id(name->symbol);
+		verify(opt_binding.has_value() && opt_binding->kind == Binding::Type, name->location, "`%s` is not a type.", interner.get(name->symbol).str().c_str());
+
+		name->type = Type_Table::No_Type;
+		return opt_binding->ty;
+	}
+
+	// Works out a function's type from its signature alone, so it can be
+	// bound before anything looks at its body.
+	//
+	Result<Type_ID> typecheck_function_signature(AST_Function_Declaration *decl) {
+		std::vector<Type_ID> parameter_types;
+		parameter_types.reserve(decl->parameters->nodes.size());
+
+		for (AST *node : decl->parameters->nodes) {
+			AST_Binary *parameter = ast_cast<AST_Binary>(node);
+			parameter_types.push_back(try_(resolve_type_signature(parameter->rhs)));
+		}
+
+		Type_ID return_type = Type_Table::No_Type;
+		if (decl->return_type_signature) {
+			return_type = try_(resolve_type_signature(decl->return_type_signature));
+		}
+
+		decl->type = type_table.function(parameter_types.data(), parameter_types.size(), return_type);
+		return decl->type;
+	}
+
+	// Checks a body on a child `Typechecker` that sees its parameters, the
+	// non-variable bindings of every enclosing scope and the globals. When
+	// the function returns something, the last expression in its body is the
+	// value returned.
+	//
+	Result<void> typecheck_function_body(AST_Function_Declaration *decl) {
+		Typechecker child;
+		child.globals = globals;
+		child.parent = this;
+		child.begin_scope();
+
+		Array<const Type_ID> parameter_types = type_table.parameters_of(decl->type);
+		for (size_t i = 0; i < parameter_types.count; i++) {
+			AST_Binary *parameter = ast_cast<AST_Binary>(decl->parameters->nodes[i]);
+			AST_Symbol *name = ast_cast<AST_Symbol>(parameter->lhs);
+
+			name->type = parameter_types.elems[i];
+			parameter->type = Type_Table::No_Type;
+			name->slot = try_(child.bind_variable(parameter->location, name->symbol, name->type));
+		}
+		decl->parameters->type = Type_Table::No_Type;
+
+		decl->body = ast_cast<AST_Block>(try_(child.typecheck(decl->body)));
+
+		Type_ID return_type = type_table[decl->type].data.function.return_type;
+		if (return_type != Type_Table::No_Type) {
+			verify(!decl->body->nodes.empty(), decl->body->location, "Function must return `%s` but its body is empty.", type_table.display_str(return_type).c_str());
+
+			AST *result = decl->body->nodes.back();
+			coerce_literal(result, return_type);
+			verify(
+				result->type == return_type,
+				result->location,
+				"Type mismatch! Function must return `%s` but its body evaluates to `%s`.",
+				type_table.display_str(return_type).c_str(),
+				type_table.display_str(result->type).c_str()
+			);
+		}
+
+		child.end_scope();
+		return {};
+	}
+
+	static PID next_pid() {
+		static std::atomic<PID> pid { 0 };
+		return pid.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// `name :: fn(...) { ... }`
+	//
+	static AST_Function_Declaration *function_constant(AST *node) {
+		if (node->kind != AST_Kind::Constant_Instantiation) return nullptr;
+		AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+		return ast_cast_if<AST_Function_Declaration>(inst->initializer);
+	}
+
+	// Binds a function constant's name to its signature in the current scope
+	// without looking at the body.
+	//
+	Result<void> declare_function(AST_Variable_Instantiation *inst) {
+		AST_Function_Declaration *decl = ast_cast<AST_Function_Declaration>(inst->initializer);
+
+		Type_ID type = try_(typecheck_function_signature(decl));
+		decl->pid = next_pid();
+		try_(bind_function(inst->location, inst->symbol->symbol, decl->pid, type));
+
+		inst->symbol->type = type;
+		inst->symbol->pid = decl->pid;
+		inst->type = Type_Table::No_Type;
+		return {};
+	}
+
+	Result<AST *> typecheck(AST *node) {
+		AST *typechecked_node = nullptr;
+
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier: {
+				AST_Symbol *symbol = ast_cast<AST_Symbol>(node);
+
+				auto opt_binding = find_binding_by_id(symbol->symbol);
+				verify(opt_binding.has_value(), symbol->location, "Unresolved identifier `%s`!", interner.get(symbol->symbol).str().c_str());
+				Binding binding = *opt_binding;
+
+				switch (binding.kind) {
+					case Binding::Variable:
+						symbol->type = binding.ty;
+						symbol->slot = binding.slot;
+						break;
+					case Binding::Function:
+						symbol->type = binding.fn.type;
+						symbol->pid = binding.fn.pid;
+						break;
+					case Binding::Type:
+						error(symbol->location, "`%s` is a type, not a value.", interner.get(symbol->symbol).str().c_str());
+					default:
+						todo("Implement non-variable binding typechecking!");
+				}
+
+				typechecked_node = symbol;
+			} break;
+
+			case AST_Kind::Literal_Null: {
+				node->type = Type_Table::Null;
+				typechecked_node = node;
+			} break;
+			case AST_Kind::Literal_Boolean: {
+				node->type = Type_Table::Boolean;
+				typechecked_node = node;
+			} break;
+			case AST_Kind::Literal_Character: {
+				node->type = Type_Table::Character;
+				typechecked_node = node;
+			} break;
+			case AST_Kind::Literal_Integer: {
+				AST_Literal *literal = ast_cast<AST_Literal>(node);
+
+				Size literal_size = minimum_required_size_for_literal(literal->as.integer);
+				node->type = type_table.integer(literal_size);
+				typechecked_node = node;
+			} break;
+			case AST_Kind::Literal_Floating_Point: {
+				AST_Literal *literal = ast_cast<AST_Literal>(node);
+
+				Size literal_size = minimum_required_size_for_literal(literal->as.floating_point);
+				node->type = type_table.floating_point(literal_size);
+				typechecked_node = node;
+			} break;
+			case AST_Kind::Literal_String: {
+				node->type = Type_Table::String;
+				typechecked_node = node;
+			} break;
+
+			case AST_Kind::Unary_Not: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+
+				unary->sub = try_(typecheck(unary->sub));
+				verify(type_table[unary->sub->type].kind == Type_Kind::Boolean, unary->sub->location, "Type mismatch! `!` expects `%s` but was given `%s`", type_table.display_str(Type_Table::Boolean).c_str(), type_table.display_str(unary->sub->type).c_str());
+
+				unary->type = Type_Table::Boolean;
+				typechecked_node = unary;
+			} break;
+			case AST_Kind::Unary_Negate: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+
+				unary->sub = try_(typecheck(unary->sub));
+				verify(
+					type_table[unary->sub->type].kind == Type_Kind::Integer || type_table[unary->sub->type].kind == Type_Kind::Floating_Point,
+					unary->sub->location,
+					"Type mismatch! `-` expects its argument to be a numeric value but was given `%s`",
+					type_table.display_str(unary->sub->type).c_str()
+				);
+
+				unary->type = unary->sub->type;
+				typechecked_node = unary;
+			} break;
+
+			case AST_Kind::Binary_Variable_Declaration: {
+				todo("Not yet implemented!");
+			} break;
+			case AST_Kind::Binary_Assignment: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal(binary->rhs, binary->lhs->type);
+
+				verify(binary->lhs->type == binary->rhs->type, binary->rhs->location, "Type mismatch! Cannot assign `%s` to `%s`", type_table.display_str(binary->rhs->type).c_str(), type_table.display_str(binary->lhs->type).c_str());
+
+				binary->type = Type_Table::No_Type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_While: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				verify(type_table[binary->lhs->type].kind == Type_Kind::Boolean, binary->lhs->location, "Type mismatch! Expected boolean expression as condition to `while` statement but found `%s`.", type_table.display_str(binary->lhs->type).c_str());
+
+				binary->rhs = try_(typecheck(binary->rhs));
+
+				binary->type = Type_Table::No_Type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_Add: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Integer || type_table[binary->lhs->type].kind == Type_Kind::Floating_Point,
+					binary->lhs->location,
+					"Type mismatch! `+` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Integer || type_table[binary->rhs->type].kind == Type_Kind::Floating_Point,
+					binary->rhs->location,
+					"Type mismatch! `+` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `+` expects its arguments to be the same type. `%s` vs. `%s`",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_Subtract: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Integer || type_table[binary->lhs->type].kind == Type_Kind::Floating_Point,
+					binary->lhs->location,
+					"Type mismatch! `-` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Integer || type_table[binary->rhs->type].kind == Type_Kind::Floating_Point,
+					binary->rhs->location,
+					"Type mismatch! `-` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `-` expects its arguments to be the same type. `%s` vs. `%s`",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_Multiply: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Integer || type_table[binary->lhs->type].kind == Type_Kind::Floating_Point,
+					binary->lhs->location,
+					"Type mismatch! `*` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Integer || type_table[binary->rhs->type].kind == Type_Kind::Floating_Point,
+					binary->rhs->location,
+					"Type mismatch! `*` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `*` expects its arguments to be the same type. `%s` vs. `%s`",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_Divide: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Integer || type_table[binary->lhs->type].kind == Type_Kind::Floating_Point,
+					binary->lhs->location,
+					"Type mismatch! `/` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Integer || type_table[binary->rhs->type].kind == Type_Kind::Floating_Point,
+					binary->rhs->location,
+					"Type mismatch! `/` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `/` expects its arguments to be the same type. `%s` vs. `%s`",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_And: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Boolean,
+					binary->lhs->location,
+					"Type mismatch! `&&` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Boolean,
+					binary->rhs->location,
+					"Type mismatch! `&&` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `&&` expects its arguments to be `%s`",
+					type_table.display_str(Type_Table::Boolean).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_Or: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+
+				verify(
+					type_table[binary->lhs->type].kind == Type_Kind::Boolean,
+					binary->lhs->location,
+					"Type mismatch! `||` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+				verify(
+					type_table[binary->rhs->type].kind == Type_Kind::Boolean,
+					binary->rhs->location,
+					"Type mismatch! `||` expects its arguments to be numeric values but was given `%s`",
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `||` expects its arguments to be `%s`",
+					type_table.display_str(Type_Table::Boolean).c_str()
+				);
+
+				binary->type = binary->lhs->type;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_EQ: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `==` expects its arguments to be the same type! `%s` vs. `%s`.",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type != Type_Table::No_Type && type_table[binary->lhs->type].kind != Type_Kind::Function,
+					binary->location,
+					"`==` can't compare values of type `%s`.",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+
+				binary->type = Type_Table::Boolean;
+				typechecked_node = binary;
+			} break;
+			case AST_Kind::Binary_NE: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				binary->lhs = try_(typecheck(binary->lhs));
+				binary->rhs = try_(typecheck(binary->rhs));
+				coerce_literal_operands(binary);
+
+				verify(
+					binary->lhs->type == binary->rhs->type,
+					binary->location,
+					"Type mismatch! `!=` expects its arguments to be the same type! `%s` vs. `%s`.",
+					type_table.display_str(binary->lhs->type).c_str(),
+					type_table.display_str(binary->rhs->type).c_str()
+				);
+				verify(
+					binary->lhs->type != Type_Table::No_Type && type_table[binary->lhs->type].kind != Type_Kind::Function,
+					binary->location,
+					"`!=` can't compare values of type `%s`.",
+					type_table.display_str(binary->lhs->type).c_str()
+				);
+
+				binary->type = Type_Table::Boolean;
+				typechecked_node = binary;
+			} break;
+
+			case AST_Kind::Binary_Call: {
+				AST_Binary *call = ast_cast<AST_Binary>(node);
+				AST_Block *arguments = ast_cast<AST_Block>(call->rhs);
+
+				// Functions can't be stored in variables, so anything of a
+				// function type names one directly.
+				//
+				call->lhs = try_(typecheck(call->lhs));
+				verify(type_table[call->lhs->type].kind == Type_Kind::Function, call->lhs->location, "Can't call a value of type `%s`.", type_table.display_str(call->lhs->type).c_str());
+
+				Array<const Type_ID> parameters = type_table.parameters_of(call->lhs->type);
+				verify(arguments->nodes.size() == parameters.count, call->location, "Expected %zu argument(s) but was given %zu.", parameters.count, arguments->nodes.size());
+
+				for (size_t i = 0; i < parameters.count; i++) {
+					AST *argument = try_(typecheck(arguments->nodes[i]));
+					coerce_literal(argument, parameters.elems[i]);
+
+					verify(
+						argument->type == parameters.elems[i],
+						argument->location,
+						"Type mismatch! Expected an argument of type `%s` but was given `%s`.",
+						type_table.display_str(parameters.elems[i]).c_str(),
+						type_table.display_str(argument->type).c_str()
+					);
+
+					arguments->nodes[i] = argument;
+				}
+
+				arguments->type = Type_Table::No_Type;
+				call->type = type_table[call->lhs->type].data.function.return_type;
+				typechecked_node = call;
+			} break;
+
+			case AST_Kind::Block: {
+				AST_Block *block = ast_cast<AST_Block>(node);
+
+				begin_scope();
+				for (size_t i = 0; i < block->nodes.size(); i++) {
+					block->nodes[i] = try_(typecheck(block->nodes[i]));
+				}
+				end_scope();
+
+				block->type = Type_Table::No_Type;
+				typechecked_node = block;
+			} break;
+
+			case AST_Kind::Variable_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+
+				AST_Symbol *symbol = inst->symbol;
+				symbol->type = Type_Table::No_Type;
+
+				Type_ID inst_type = Untyped;
+				if (inst->specified_type_signature) {
+					todo("Implement typechecking for var-insts with specified_type_signature.");
+				} else {
+					inst->initializer = try_(typecheck(inst->initializer));
+
+					// The variable will likely hold bigger values than the
+					// literal it starts as, so it gets the default width.
+					switch (type_table[inst->initializer->type].kind) {
+						case Type_Kind::Integer:        coerce_literal(inst->initializer, Type_Table::Integer64); break;
+						case Type_Kind::Floating_Point: coerce_literal(inst->initializer, Type_Table::Float64);   break;
+						default: break;
+					}
+					inst_type = inst->initializer->type;
+				}
+
+				verify(inst_type != Type_Table::No_Type, inst->initializer->location, "`%s` can't be initialized with something that has no value.", interner.get(symbol->symbol).str().c_str());
+				verify(type_table[inst_type].kind != Type_Kind::Function, inst->initializer->location, "Functions can't be stored in variables yet.");
+
+				symbol->slot = try_(bind_variable(inst->location, symbol->symbol, inst_type));
+
+				inst->type = Type_Table::No_Type;
+				typechecked_node = inst;
+			} break;
+			case AST_Kind::Constant_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+
+				if (!function_constant(inst)) {
+					todo("Implement typechecking constant declaration!");
+				}
+
+				// Nested functions are checked in place; only top-level ones
+				// get split across threads.
+				try_(declare_function(inst));
+				try_(typecheck_function_body(ast_cast<AST_Function_Declaration>(inst->initializer)));
+
+				typechecked_node = inst;
+			} break;
+
+			case AST_Kind::If: {
+				AST_If *if_ = ast_cast<AST_If>(node);
+
+				if_->condition = try_(typecheck(if_->condition));
+				verify(
+					type_table[if_->condition->type].kind == Type_Kind::Boolean, 
+					if_->condition->location, 
+					"Type mismatch! Expected boolean expression as conditional of `if` statement but expression evaluates to `%s`", 
+					type_table.display_str(if_->condition->type).c_str()
+				);
+
+				if_->then_block = try_(typecheck(if_->then_block));
+				if (if_->else_block) if_->else_block = try_(typecheck(if_->else_block));
+
+				if_->type = Type_Table::No_Type;
+				typechecked_node = if_;
+			} break;
+
+			default:
+				internal_error("Unhandled AST_Kind: %s!", debug_str(node->kind).c_str());
+		}
+
+		return typechecked_node;
+	}
+};
+
+void bind_builtin_types(Typechecker &t) {
+	struct Builtin {
+		const char *name;
+		Type_ID type;
+	};
+
+	static const Builtin Builtins[] = {
+		{ "bool",   Type_Table::Boolean },
+		{ "char",   Type_Table::Character },
+		{ "string", Type_Table::String },
+		{ "i8",     Type_Table::Integer8 },
+		{ "i16",    Type_Table::Integer16 },
+		{ "i32",    Type_Table::Integer32 },
+		{ "i64",    Type_Table::Integer64 },
+		{ "f32",    Type_Table::Float32 },
+		{ "f64",    Type_Table::Float64 },
+	};
+
+	for (const Builtin &builtin : Builtins) {
+		Symbol_ID id = interner.intern(String { const_cast<char *>(builtin.name) });
+		t.scopes.put(id, Typechecker::Binding::type(builtin.type));
+	}
+}
+
+// Typechecks in two phases. First every top-level function's signature is
+// bound into the global scope, which nothing writes to afterwards. Then the
+// remaining top-level statements are checked in order, and finally each
+// top-level function body is checked on its own child `Typechecker`, spread
+// across `pool` when there is one. The bodies are checked even after a
+// top-level statement fails, so the error reported is always the first
+// in source order, whichever thread found it.
+//
+Result<AST_Block *> typecheck(AST_Block *ast, Thread_Pool *pool = nullptr) {
+	Typechecker globals;
+	globals.parent = nullptr;
+	globals.globals = &globals.scopes;
+	globals.begin_scope();
+	bind_builtin_types(globals);
+
+	std::vector<AST_Function_Declaration *> functions;
+	for (AST *node : ast->nodes) {
+		if (AST_Function_Declaration *decl = Typechecker::function_constant(node)) {
+			try_(globals.declare_function(ast_cast<AST_Variable_Instantiation>(node)));
+			functions.push_back(decl);
+		}
+	}
+
+	Typechecker t;
+	t.parent = nullptr;
+	t.globals = &globals.scopes;
+	t.begin_scope();
+
+	Diagnostic *top_level_error = nullptr;
+	for (size_t i = 0; i < ast->nodes.size(); i++) {
+		if (Typechecker::function_constant(ast->nodes[i])) continue;
+
+		auto checked = t.typecheck(ast->nodes[i]);
+		if (checked.is_err()) {
+			top_level_error = checked.err();
+			break;
+		}
+		ast->nodes[i] = checked.take();
+	}
+
+	std::vector<Diagnostic *> errors(functions.size(), nullptr);
+	Task_Group bodies;
+
+	for (size_t i = 0; i < functions.size(); i++) {
+		auto check = [&t, &functions, &errors, i]() {
+			errors[i] = t.typecheck_function_body(functions[i]).err();
+		};
+
+		if (pool) {
+			pool->submit(bodies, check);
+		} else {
+			check();
+		}
+	}
+
+	if (pool) pool->wait(bodies);
+
+	// `functions` is in source order, so only its first error competes. An
+	// error without a location can't be placed, so the top level keeps it.
+	for (Diagnostic *error : errors) {
+		if (!error) continue;
+		if (!top_level_error) return Failure { error };
+
+		bool earlier = error->has_location && top_level_error->has_location && error->location.offset < top_level_error->location.offset;
+		if (earlier) return Failure { error };
+		break;
+	}
+	if (top_level_error) return Failure { top_level_error };
+
+	return ast;
+}
+
+// Every function declared in `node`, nested ones included, in source order.
+//
+void collect_functions(AST *node, std::vector<AST_Function_Declaration *> &functions) {
+	if (AST_Function_Declaration *decl = ast_cast_if<AST_Function_Declaration>(node)) {
+		functions.push_back(decl);
+	}
+
+	for_each_child(node, [&functions](AST *child) {
+		collect_functions(child, functions);
+	});
+}
+
+// The name each function in `node` was declared with.
+//
+void collect_function_names(AST *node, std::unordered_map<AST_Function_Declaration *, Symbol_ID> &names) {
+	if (AST_Function_Declaration *decl = Typechecker::function_constant(node)) {
+		names[decl] = ast_cast<AST_Variable_Instantiation>(node)->symbol->symbol;
+	}
+
+	for_each_child(node, [&names](AST *child) {
+		collect_function_names(child, names);
+	});
+}
+
+//
+//
+// Bytecode
+//
+//
+
+// One register. Integers of every width are kept sign-extended in
+// `integer`, and so are booleans, characters and `null`, so a single set of
+// comparisons covers all of them and only arithmetic needs to know a width.
+//
+union Value {
+	Runtime_Type::Integer64 integer;
+	Runtime_Type::Floating_Point32 f32;
+	Runtime_Type::Floating_Point64 f64;
+	const Runtime_Type::String *string;
+};
+
+static_assert(sizeof(Value) == 8, "Registers should be one word.");
+
+// Numeric opcodes come in one variant per width, in the order of the
+// numeric `Type_ID`s, so the right one is `first + (type - Integer8)`.
+//
+#define NUMERIC_OPCODES(X, name) \
+	X(name##_I8) X(name##_I16) X(name##_I32) X(name##_I64) X(name##_F32) X(name##_F64)
+
+#define OPCODES(X) \
+	X(Halt) \
+	X(Move) \
+	X(Load_Constant) \
+	X(Jump) \
+	X(Jump_If_False) \
+	X(Jump_If_True) \
+	X(Call) \
+	X(Return) \
+	X(Return_None) \
+	X(Not) \
+	NUMERIC_OPCODES(X, Negate) \
+	NUMERIC_OPCODES(X, Add) \
+	NUMERIC_OPCODES(X, Subtract) \
+	NUMERIC_OPCODES(X, Multiply) \
+	NUMERIC_OPCODES(X, Divide) \
+	X(Equal_Integer) \
+	X(Equal_F32) \
+	X(Equal_F64) \
+	X(Equal_String) \
+	X(Not_Equal_Integer) \
+	X(Not_Equal_F32) \
+	X(Not_Equal_F64) \
+	X(Not_Equal_String)
+
+enum class Opcode : uint16_t {
+	#define X(name) name,
+	OPCODES(X)
+	#undef X
+};
+
+static_assert(Type_Table::Float64 - Type_Table::Integer8 == 5, "Numeric opcodes assume the numeric types are contiguous.");
+
+Opcode numeric_opcode(Opcode first, Type_ID type) {
+	internal_verify(type >= Type_Table::Integer8 && type <= Type_Table::Float64, "`%s` isn't numeric!", type_table.debug_str(type).c_str());
+	return static_cast<Opcode>(static_cast<uint16_t>(first) + (type - Type_Table::Integer8));
+}
+
+// `a` is the destination and `b` and `c` the operands. Constant indices,
+// jump targets and callees don't fit in an `Address`, so they're spread
+// across `b` and `c`.
+//
+struct Instruction {
+	Opcode op;
+	Address a;
+	Address b;
+	Address c;
+
+	uint32_t wide() const {
+		return b | (static_cast<uint32_t>(c) << 16);
+	}
+
+	void set_wide(uint32_t value) {
+		b = static_cast<Address>(value);
+		c = static_cast<Address>(value >> 16);
+	}
+};
+
+static_assert(sizeof(Instruction) == 8, "Instructions should stay two to a word.");
+
+// A function's registers start with its parameters, then its variables at
+// the slots the typechecker gave them, then temporaries. A caller puts the
+// arguments in consecutive registers and the callee's frame starts at the
+// first of them; the result comes back in that same register.
+//
+struct Bytecode_Function {
+	std::vector<Instruction> code;
+	std::vector<Code_Location> locations; // one per instruction
+	Size register_count = 1;
+};
+
+struct Bytecode_Program {
+	std::vector<Bytecode_Function> functions; // `functions[0]` is the top level
+	std::vector<Value> constants;
+	std::deque<Runtime_Type::String> strings;
+};
+
+// Compiles a typechecked tree. Registers below `declared` may belong to
+// variables; temporaries are handed out above them and all given back at
+// the end of every statement, since no temporary outlives one.
+//
+struct Bytecode_Compiler {
+	Bytecode_Program *program;
+
+	std::unordered_map<PID, uint32_t> function_indices;
+	Bytecode_Function *function = nullptr;
+	Size declared = 0;
+	Size next_register = 0;
+
+	Result<void> compile_program(AST_Block *ast) {
+		std::vector<AST_Function_Declaration *> functions;
+		collect_functions(ast, functions);
+
+		program->functions.resize(functions.size() + 1);
+		for (size_t i = 0; i < functions.size(); i++) {
+			function_indices[functions[i]->pid] = static_cast<uint32_t>(i + 1);
+		}
+
+		begin_function(0, 0);
+		for (AST *node : ast->nodes) {
+			try_(compile_statement(node));
+		}
+		emit(Opcode::Halt, ast->location);
+
+		for (size_t i = 0; i < functions.size(); i++) {
+			try_(compile_function(functions[i], i + 1));
+		}
+
+		return {};
+	}
+
+private:
+	void begin_function(size_t index, Size parameter_count) {
+		function = &program->functions[index];
+		declared = parameter_count;
+		next_register = declared;
+		function->register_count = std::max<Size>(declared, 1);
+	}
+
+	Result<void> compile_function(AST_Function_Declaration *decl, size_t index) {
+		verify(decl->parameters->nodes.size() < std::numeric_limits<Address>::max(), decl->location, "Too many parameters to run this function.");
+		begin_function(index, decl->parameters->nodes.size());
+
+		const std::vector<AST *> &body = decl->body->nodes;
+		bool returns_value = type_table[decl->type].data.function.return_type != Type_Table::No_Type;
+
+		for (size_t i = 0; i < body.size(); i++) {
+			if (returns_value && i + 1 == body.size()) {
+				next_register = declared;
+				Address value = try_(compile_operand(body[i]));
+				emit(Opcode::Return, body[i]->location, value);
+			} else {
+				try_(compile_statement(body[i]));
+			}
+		}
+
+		if (!returns_value) emit(Opcode::Return_None, decl->body->location);
+		return {};
+	}
+
+	size_t emit(Opcode op, Code_Location location, Address a = 0, Address b = 0, Address c = 0) {
+		function->code.push_back(Instruction { op, a, b, c });
+		function->locations.push_back(location);
+		return function->code.size() - 1;
+	}
+
+	size_t emit_wide(Opcode op, Code_Location location, Address a, uint32_t wide) {
+		size_t at = emit(op, location, a);
+		function->code[at].set_wide(wide);
+		return at;
+	}
+
+	// Points the jump at `at` to the next instruction emitted.
+	//
+	void patch(size_t at) {
+		function->code[at].set_wide(static_cast<uint32_t>(function->code.size()));
+	}
+
+	Result<Address> allocate(Code_Location location) {
+		verify(next_register < std::numeric_limits<Address>::max(), location, "Function needs too many registers.");
+
+		Address r = static_cast<Address>(next_register++);
+		function->register_count = std::max(function->register_count, next_register);
+		return r;
+	}
+
+	Result<uint32_t> constant(Code_Location location, Value value) {
+		verify(program->constants.size() < std::numeric_limits<uint32_t>::max(), location, "Too many constants.");
+		program->constants.push_back(value);
+		return static_cast<uint32_t>(program->constants.size() - 1);
+	}
+
+	Result<void> compile_statement(AST *node) {
+		next_register = declared;
+
+		switch (node->kind) {
+			case AST_Kind::Variable_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+				verify(inst->symbol->slot < std::numeric_limits<Address>::max(), inst->location, "Too many variables in one function to run it.");
+				Address slot = static_cast<Address>(inst->symbol->slot);
+
+				declared = std::max<Size>(declared, slot + 1);
+				next_register = declared;
+				function->register_count = std::max(function->register_count, declared);
+
+				try_(compile_into(inst->initializer, slot));
+			} break;
+			case AST_Kind::Constant_Instantiation: {
+				// Functions are compiled on their own.
+			} break;
+			case AST_Kind::Binary_Assignment: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				AST_Symbol *target = ast_cast_if<AST_Symbol>(binary->lhs);
+				verify(target, binary->lhs->location, "Can only assign to variables.");
+
+				try_(compile_into(binary->rhs, static_cast<Address>(target->slot)));
+			} break;
+			case AST_Kind::Binary_While: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				uint32_t start = static_cast<uint32_t>(function->code.size());
+				Address condition = try_(compile_operand(binary->lhs));
+				size_t exit = emit_wide(Opcode::Jump_If_False, binary->location, condition, 0);
+
+				try_(compile_statement(binary->rhs));
+				emit_wide(Opcode::Jump, binary->location, 0, start);
+				patch(exit);
+			} break;
+			case AST_Kind::If: {
+				AST_If *if_ = ast_cast<AST_If>(node);
+
+				Address condition = try_(compile_operand(if_->condition));
+				size_t skip_then = emit_wide(Opcode::Jump_If_False, if_->location, condition, 0);
+				try_(compile_statement(if_->then_block));
+
+				if (if_->else_block) {
+					size_t skip_else = emit_wide(Opcode::Jump, if_->location, 0, 0);
+					patch(skip_then);
+					try_(compile_statement(if_->else_block));
+					patch(skip_else);
+				} else {
+					patch(skip_then);
+				}
+			} break;
+			case AST_Kind::Block: {
+				for (AST *child : ast_cast<AST_Block>(node)->nodes) {
+					try_(compile_statement(child));
+				}
+			} break;
+
+			default:
+				try_(compile_operand(node));
+				break;
+		}
+
+		return {};
+	}
+
+	// A variable is already in a register; anything else is computed into a
+	// fresh temporary.
+	//
+	Result<Address> compile_operand(AST *node) {
+		if (AST_Symbol *symbol = ast_cast_if<AST_Symbol>(node)) {
+			if (type_table[symbol->type].kind != Type_Kind::Function) return static_cast<Address>(symbol->slot);
+		}
+
+		Address r = try_(allocate(node->location));
+		try_(compile_into(node, r));
+		return r;
+	}
+
+	Result<void> compile_into(AST *node, Address dest) {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier: {
+				AST_Symbol *symbol = ast_cast<AST_Symbol>(node);
+
+				// A function named on its own does nothing.
+				if (type_table[symbol->type].kind == Type_Kind::Function) break;
+				if (symbol->slot != dest) emit(Opcode::Move, node->location, dest, static_cast<Address>(symbol->slot));
+			} break;
+
+			case AST_Kind::Literal_Null:
+			case AST_Kind::Literal_Boolean:
+			case AST_Kind::Literal_Character:
+			case AST_Kind::Literal_Integer:
+			case AST_Kind::Literal_Floating_Point:
+			case AST_Kind::Literal_String: {
+				AST_Literal *literal = ast_cast<AST_Literal>(node);
+
+				Value value;
+				value.integer = 0;
+
+				switch (node->kind) {
+					case AST_Kind::Literal_Boolean:
+						value.integer = literal->as.boolean;
+						break;
+					case AST_Kind::Literal_Character:
+						value.integer = literal->as.character;
+						break;
+					case AST_Kind::Literal_Integer:
+						value.integer = literal->as.integer;
+						break;
+					case AST_Kind::Literal_Floating_Point:
+						if (node->type == Type_Table::Float32) {
+							value.f32 = static_cast<Runtime_Type::Floating_Point32>(literal->as.floating_point);
+						} else {
+							value.f64 = literal->as.floating_point;
+						}
+						break;
+					case AST_Kind::Literal_String:
+						program->strings.push_back({ static_cast<Runtime_Type::Integer64>(literal->as.string.size), literal->as.string.chars });
+						value.string = &program->strings.back();
+						break;
+					default:
+						break;
+				}
+
+				emit_wide(Opcode::Load_Constant, node->location, dest, try_(constant(node->location, value)));
+			} break;
+
+			case AST_Kind::Unary_Not: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+				Address sub = try_(compile_operand(unary->sub));
+				emit(Opcode::Not, node->location, dest, sub);
+			} break;
+			case AST_Kind::Unary_Negate: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+				Address sub = try_(compile_operand(unary->sub));
+				emit(numeric_opcode(Opcode::Negate_I8, node->type), node->location, dest, sub);
+			} break;
+
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				Opcode first = Opcode::Add_I8;
+				switch (node->kind) {
+					case AST_Kind::Binary_Subtract: first = Opcode::Subtract_I8; break;
+					case AST_Kind::Binary_Multiply: first = Opcode::Multiply_I8; break;
+					case AST_Kind::Binary_Divide:   first = Opcode::Divide_I8;   break;
+					default: break;
+				}
+
+				Address lhs = try_(compile_operand(binary->lhs));
+				Address rhs = try_(compile_operand(binary->rhs));
+				emit(numeric_opcode(first, node->type), node->location, dest, lhs, rhs);
+			} break;
+
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				bool equal = node->kind == AST_Kind::Binary_EQ;
+
+				Opcode op = equal ? Opcode::Equal_Integer : Opcode::Not_Equal_Integer;
+				switch (binary->lhs->type) {
+					case Type_Table::Float32: op = equal ? Opcode::Equal_F32    : Opcode::Not_Equal_F32;    break;
+					case Type_Table::Float64: op = equal ? Opcode::Equal_F64    : Opcode::Not_Equal_F64;    break;
+					case Type_Table::String:  op = equal ? Opcode::Equal_String : Opcode::Not_Equal_String; break;
+				}
+
+				Address lhs = try_(compile_operand(binary->lhs));
+				Address rhs = try_(compile_operand(binary->rhs));
+				emit(op, node->location, dest, lhs, rhs);
+			} break;
+
+			case AST_Kind::Binary_And:
+			case AST_Kind::Binary_Or: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				// The result is written before `rhs` is read, so don't let
+				// that clobber a variable `rhs` might read.
+				Address value = dest < declared ? try_(allocate(node->location)) : dest;
+
+				try_(compile_into(binary->lhs, value));
+				Opcode skip = node->kind == AST_Kind::Binary_And ? Opcode::Jump_If_False : Opcode::Jump_If_True;
+				size_t done = emit_wide(skip, node->location, value, 0);
+				try_(compile_into(binary->rhs, value));
+				patch(done);
+
+				if (value != dest) emit(Opcode::Move, node->location, dest, value);
+			} break;
+
+			case AST_Kind::Binary_Call: {
+				AST_Binary *call = ast_cast<AST_Binary>(node);
+				AST_Symbol *callee = ast_cast<AST_Symbol>(call->lhs);
+				const std::vector<AST *> &arguments = ast_cast<AST_Block>(call->rhs)->nodes;
+
+				// Every argument register is taken before any argument is
+				// computed, so temporaries can't land between them.
+				Address base = try_(allocate(node->location));
+				for (size_t i = 1; i < arguments.size(); i++) {
+					try_(allocate(node->location));
+				}
+
+				for (size_t i = 0; i < arguments.size(); i++) {
+					try_(compile_into(arguments[i], static_cast<Address>(base + i)));
+				}
+
+				auto it = function_indices.find(callee->pid);
+				internal_verify(it != function_indices.end(), "Call to a function that wasn't collected!");
+
+				emit_wide(Opcode::Call, node->location, base, it->second);
+				if (base != dest) emit(Opcode::Move, node->location, dest, base);
+			} break;
+
+			default:
+				internal_error("Unhandled AST_Kind in an expression: %s!", debug_str(node->kind).c_str());
+		}
+
+		return {};
+	}
+};
+
+//
+//
+// Virtual Machine
+//
+//
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+// Runs a `Bytecode_Program`. Every frame lives in one fixed register stack;
+// a call just moves the frame's base up to its arguments. Dispatch jumps
+// straight from each handler to the next through a label table where the
+// compiler supports it, and falls back to a `switch` otherwise.
+//
+struct Virtual_Machine {
+	static constexpr size_t Stack_Size = 1 << 20; // in registers
+
+	const Bytecode_Program *program;
+	std::unique_ptr<Value[]> stack;
+
+	Virtual_Machine(const Bytecode_Program *program) : program(program), stack(new Value[Stack_Size]) {}
+
+	// The top level's frame, where the globals are once `run` returns.
+	//
+	const Value *globals() const {
+		return stack.get();
+	}
+
+	Result<void> run() {
+		struct Frame {
+			const Bytecode_Function *function;
+			const Instruction *resume;
+			Value *registers;
+		};
+		std::vector<Frame> frames;
+
+		const Bytecode_Function *function = &program->functions[0];
+		const Instruction *ip = function->code.data();
+		const Value *constants = program->constants.data();
+		Value *r = stack.get();
+		Value *stack_end = stack.get() + Stack_Size;
+
+		if (function->register_count > Stack_Size) goto stack_overflow;
+
+		#if VM_COMPUTED_GOTO
+		static void *const Labels[] = {
+			#define X(name) &&op_##name,
+			OPCODES(X)
+			#undef X
+		};
+
+		#define VM_CASE(name) op_##name:
+		#define VM_DISPATCH() goto *Labels[static_cast<size_t>(ip->op)]
+		#else
+		#define VM_CASE(name) case Opcode::name:
+		#define VM_DISPATCH() continue
+		#endif
+
+		#define VM_NEXT() { ip++; VM_DISPATCH(); }
+		#define VM_JUMP(target) { ip = function->code.data() + (target); VM_DISPATCH(); }
+
+		// `+`, `-` and `*` wrap at their width: the work's done unsigned,
+		// then truncated and sign-extended back.
+		#define VM_INTEGER_ARITHMETIC(name, op) \
+			VM_CASE(name##_I8)  { r[ip->a].integer = static_cast<int8_t>(static_cast<uint64_t>(r[ip->b].integer) op static_cast<uint64_t>(r[ip->c].integer));  VM_NEXT(); } \
+			VM_CASE(name##_I16) { r[ip->a].integer = static_cast<int16_t>(static_cast<uint64_t>(r[ip->b].integer) op static_cast<uint64_t>(r[ip->c].integer)); VM_NEXT(); } \
+			VM_CASE(name##_I32) { r[ip->a].integer = static_cast<int32_t>(static_cast<uint64_t>(r[ip->b].integer) op static_cast<uint64_t>(r[ip->c].integer)); VM_NEXT(); } \
+			VM_CASE(name##_I64) { r[ip->a].integer = static_cast<int64_t>(static_cast<uint64_t>(r[ip->b].integer) op static_cast<uint64_t>(r[ip->c].integer)); VM_NEXT(); }
+
+		#define VM_FLOAT_ARITHMETIC(name, op) \
+			VM_CASE(name##_F32) { r[ip->a].f32 = r[ip->b].f32 op r[ip->c].f32; VM_NEXT(); } \
+			VM_CASE(name##_F64) { r[ip->a].f64 = r[ip->b].f64 op r[ip->c].f64; VM_NEXT(); }
+
+		// Dividing the most negative value by -1 wraps like negating it.
+		#define VM_INTEGER_DIVIDE(suffix, T) \
+			VM_CASE(Divide_##suffix) { \
+				int64_t x = r[ip->b].integer; \
+				int64_t y = r[ip->c].integer; \
+				if (y == 0) goto division_by_zero; \
+				r[ip->a].integer = static_cast<T>(y == -1 ? 0 - static_cast<uint64_t>(x) : static_cast<uint64_t>(x / y)); \
+				VM_NEXT(); \
+			}
+
+		#define VM_INTEGER_NEGATE(suffix, T) \
+			VM_CASE(Negate_##suffix) { r[ip->a].integer = static_cast<T>(0 - static_cast<uint64_t>(r[ip->b].integer)); VM_NEXT(); }
+
+		#define VM_COMPARE(name, field, op) \
+			VM_CASE(name) { r[ip->a].integer = r[ip->b].field op r[ip->c].field; VM_NEXT(); }
+
+		#if VM_COMPUTED_GOTO
+		VM_DISPATCH();
+		#else
+		while (true) switch (ip->op) {
+		#endif
+
+		VM_CASE(Halt) {
+			return {};
+		}
+		VM_CASE(Move) {
+			r[ip->a] = r[ip->b];
+			VM_NEXT();
+		}
+		VM_CASE(Load_Constant) {
+			r[ip->a] = constants[ip->wide()];
+			VM_NEXT();
+		}
+		VM_CASE(Jump) {
+			VM_JUMP(ip->wide());
+		}
+		VM_CASE(Jump_If_False) {
+			if (!r[ip->a].integer) VM_JUMP(ip->wide());
+			VM_NEXT();
+		}
+		VM_CASE(Jump_If_True) {
+			if (r[ip->a].integer) VM_JUMP(ip->wide());
+			VM_NEXT();
+		}
+		VM_CASE(Call) {
+			const Bytecode_Function *callee = &program->functions[ip->wide()];
+			Value *base = r + ip->a;
+			if (static_cast<size_t>(stack_end - base) < callee->register_count) goto stack_overflow;
+
+			frames.push_back(Frame { function, ip + 1, r });
+			function = callee;
+			r = base;
+			ip = callee->code.data();
+			VM_DISPATCH();
+		}
+		VM_CASE(Return) {
+			r[0] = r[ip->a];
+			Frame caller = frames.back();
+			frames.pop_back();
+
+			function = caller.function;
+			ip = caller.resume;
+			r = caller.registers;
+			VM_DISPATCH();
+		}
+		VM_CASE(Return_None) {
+			Frame caller = frames.back();
+			frames.pop_back();
+
+			function = caller.function;
+			ip = caller.resume;
+			r = caller.registers;
+			VM_DISPATCH();
+		}
+		VM_CASE(Not) {
+			r[ip->a].integer = !r[ip->b].integer;
+			VM_NEXT();
+		}
+
+		VM_INTEGER_NEGATE(I8, int8_t)
+		VM_INTEGER_NEGATE(I16, int16_t)
+		VM_INTEGER_NEGATE(I32, int32_t)
+		VM_INTEGER_NEGATE(I64, int64_t)
+		VM_CASE(Negate_F32) { r[ip->a].f32 = -r[ip->b].f32; VM_NEXT(); }
+		VM_CASE(Negate_F64) { r[ip->a].f64 = -r[ip->b].f64; VM_NEXT(); }
+
+		VM_INTEGER_ARITHMETIC(Add, +)
+		VM_FLOAT_ARITHMETIC(Add, +)
+		VM_INTEGER_ARITHMETIC(Subtract, -)
+		VM_FLOAT_ARITHMETIC(Subtract, -)
+		VM_INTEGER_ARITHMETIC(Multiply, *)
+		VM_FLOAT_ARITHMETIC(Multiply, *)
+
+		VM_INTEGER_DIVIDE(I8, int8_t)
+		VM_INTEGER_DIVIDE(I16, int16_t)
+		VM_INTEGER_DIVIDE(I32, int32_t)
+		VM_INTEGER_DIVIDE(I64, int64_t)
+		VM_FLOAT_ARITHMETIC(Divide, /)
+
+		VM_COMPARE(Equal_Integer, integer, ==)
+		VM_COMPARE(Equal_F32, f32, ==)
+		VM_COMPARE(Equal_F64, f64, ==)
+		VM_CASE(Equal_String) {
+			r[ip->a].integer = strings_equal(r[ip->b].string, r[ip->c].string);
+			VM_NEXT();
+		}
+		VM_COMPARE(Not_Equal_Integer, integer, !=)
+		VM_COMPARE(Not_Equal_F32, f32, !=)
+		VM_COMPARE(Not_Equal_F64, f64, !=)
+		VM_CASE(Not_Equal_String) {
+			r[ip->a].integer = !strings_equal(r[ip->b].string, r[ip->c].string);
+			VM_NEXT();
+		}
+
+		#if !VM_COMPUTED_GOTO
+		}
+		#endif
+
+		#undef VM_CASE
+		#undef VM_DISPATCH
+		#undef VM_NEXT
+		#undef VM_JUMP
+		#undef VM_INTEGER_ARITHMETIC
+		#undef VM_FLOAT_ARITHMETIC
+		#undef VM_INTEGER_DIVIDE
+		#undef VM_INTEGER_NEGATE
+		#undef VM_COMPARE
+
+	division_by_zero:
+		error(location_of(function, ip), "Division by zero.");
+	stack_overflow:
+		error(location_of(function, ip), "Stack overflow.");
+	}
+
+private:
+	static bool strings_equal(const Runtime_Type::String *a, const Runtime_Type::String *b) {
+		return a->size == b->size && memcmp(a->chars, b->chars, a->size) == 0;
+	}
+
+	static Code_Location location_of(const Bytecode_Function *function, const Instruction *ip) {
+		return function->locations[ip - function->code.data()];
+	}
+};
+
+void print_value(FILE *out, Value value, Type_ID type) {
+	switch (type_table[type].kind) {
+		case Type_Kind::Null: {
+			fprintf(out, "null");
+		} break;
+		case Type_Kind::Boolean: {
+			fprintf(out, "%s", value.integer ? "true" : "false");
+		} break;
+		case Type_Kind::Character: {
+			char utf8[5];
+			encode_utf8(static_cast<char32_t>(value.integer), utf8);
+			fprintf(out, "'%s'", utf8);
+		} break;
+		case Type_Kind::Integer: {
+			fprintf(out, "%lld", static_cast<long long>(value.integer));
+		} break;
+		case Type_Kind::Floating_Point: {
+			fprintf(out, "%g", type == Type_Table::Float32 ? value.f32 : value.f64);
+		} break;
+		case Type_Kind::String: {
+			fprintf(out, "\"%.*s\"", static_cast<int>(value.string->size), value.string->chars);
+		} break;
+
+		default:
+			internal_error("Can't print a value of type `%s`!", type_table.debug_str(type).c_str());
+	}
+}
+
+// Prints the final value of each variable declared directly at the top
+// level of `ast`, given the top level's finished frame.
+//
+void print_globals(FILE *out, AST_Block *ast, const Value *frame) {
+	for (AST *node : ast->nodes) {
+		if (node->kind != AST_Kind::Variable_Instantiation) continue;
+		AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+
+		fprintf(out, "%s: %s = ", interner.get(inst->symbol->symbol).str().c_str(), type_table.display_str(inst->initializer->type).c_str());
+		print_value(out, frame[inst->symbol->slot], inst->initializer->type);
+		fprintf(out, "\n");
+	}
+}
+
+// Compiles and runs a typechecked program, then prints each top-level
+// variable's final value to `out`.
+//
+Result<void> run_program(AST_Block *ast, FILE *out) {
+	Bytecode_Program program;
+	Bytecode_Compiler compiler { &program };
+	try_(compiler.compile_program(ast));
+
+	Virtual_Machine vm { &program };
+	try_(vm.run());
+
+	print_globals(out, ast, vm.globals());
+	return {};
+}
+
+//
+//
+// Native Code
+//
+//
+
+#if defined(__x86_64__)
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+namespace X64 {
+	enum Register : uint8_t {
+		RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+		R8, R9, R10, R11, R12, R13, R14, R15,
+	};
+
+	// The low nibble of `Jcc` and `SETcc`.
+	//
+	enum Condition : uint8_t {
+		Below     = 0x2,
+		Equal     = 0x4,
+		Not_Equal = 0x5,
+		Parity    = 0xA,
+		No_Parity = 0xB,
+	};
+
+	constexpr Register Integer_Arguments[] = { RDI, RSI, RDX, RCX, R8, R9 };
+	constexpr size_t Float_Argument_Count = 8; // xmm0-xmm7
+}
+
+// Appends x86-64 machine code. Only the handful of forms the JIT needs are
+// here; every register-or-memory operand goes through `register_op` or
+// `memory_op`, which take care of prefixes, REX and ModRM.
+//
+struct X64_Emitter {
+	std::vector<uint8_t> code;
+
+	size_t here() const {
+		return code.size();
+	}
+
+	void byte(uint8_t b) {
+		code.push_back(b);
+	}
+
+	void bytes(std::initializer_list<uint8_t> bs) {
+		code.insert(code.end(), bs);
+	}
+
+	void u32(uint32_t value) {
+		for (int i = 0; i < 4; i++) byte(static_cast<uint8_t>(value >> (8 * i)));
+	}
+
+	void u64(uint64_t value) {
+		for (int i = 0; i < 8; i++) byte(static_cast<uint8_t>(value >> (8 * i)));
+	}
+
+	// `prefix` is 0x66, 0xF2, 0xF3 or 0 for none. `reg` is the ModRM reg
+	// field: a register, or an opcode extension.
+	//
+	void register_op(uint8_t prefix, bool wide, std::initializer_list<uint8_t> opcode, int reg, int rm) {
+		if (prefix) byte(prefix);
+		rex(wide, reg, rm);
+		bytes(opcode);
+		byte(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+	}
+
+	// Like `register_op`, with `rm` being memory at `[base + displacement]`.
+	//
+	void memory_op(uint8_t prefix, bool wide, std::initializer_list<uint8_t> opcode, int reg, int base, int32_t displacement) {
+		if (prefix) byte(prefix);
+		rex(wide, reg, base);
+		bytes(opcode);
+		byte(static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | (base & 7)));
+		if ((base & 7) == X64::RSP) byte(0x24); // SIB: no index
+		u32(static_cast<uint32_t>(displacement));
+	}
+
+	void mov(X64::Register dst, X64::Register src) { register_op(0, true, { 0x89 }, src, dst); }
+	void load(X64::Register dst, X64::Register base, int32_t displacement) { memory_op(0, true, { 0x8B }, dst, base, displacement); }
+	void store(X64::Register base, int32_t displacement, X64::Register src) { memory_op(0, true, { 0x89 }, src, base, displacement); }
+
+	void mov_immediate(X64::Register dst, uint64_t value) {
+		rex(true, 0, dst);
+		byte(static_cast<uint8_t>(0xB8 + (dst & 7)));
+		u64(value);
+	}
+
+	void push(X64::Register r) {
+		if (r & 8) byte(0x41);
+		byte(static_cast<uint8_t>(0x50 + (r & 7)));
+	}
+
+	void pop(X64::Register r) {
+		if (r & 8) byte(0x41);
+		byte(static_cast<uint8_t>(0x58 + (r & 7)));
+	}
+
+	// Jumps and calls are emitted with a zero rel32 and return where it is,
+	// for `patch` once the target's known.
+	//
+	size_t jump() {
+		byte(0xE9);
+		u32(0);
+		return here() - 4;
+	}
+
+	size_t jump_if(X64::Condition condition) {
+		bytes({ 0x0F, static_cast<uint8_t>(0x80 | condition) });
+		u32(0);
+		return here() - 4;
+	}
+
+	size_t call() {
+		byte(0xE8);
+		u32(0);
+		return here() - 4;
+	}
+
+	void patch(size_t at, size_t target) {
+		uint32_t rel = static_cast<uint32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(at + 4));
+		memcpy(&code[at], &rel, 4);
+	}
+
+	void ret() {
+		byte(0xC3);
+	}
+
+private:
+	void rex(bool wide, int reg, int rm) {
+		uint8_t prefix = static_cast<uint8_t>(0x40 | (wide << 3) | ((reg & 8) >> 1) | ((rm & 8) >> 3));
+		if (prefix != 0x40) byte(prefix);
+	}
+};
+
+// Shared by a native call and everything it calls, through `r15`. The entry
+// thunk saves its stack pointer here so a trap at any depth can unwind
+// straight back to it.
+//
+struct Jit_State {
+	uint64_t saved_rsp;
+	uint32_t trap;
+	uint32_t padding;
+	uint64_t stack_limit;
+};
+
+static_assert(offsetof(Jit_State, saved_rsp) == 0 && offsetof(Jit_State, trap) == 8 && offsetof(Jit_State, stack_limit) == 16, "The generated code hardcodes `Jit_State`'s layout.");
+
+struct Jit_Function {
+	size_t code;  // follows the System V ABI, with integers sign-extended to 64 bits
+	size_t entry; // `void (const Value *arguments, Value *result, Jit_State *state)`
+	Type_ID type;
+};
+
+// Functions compiled to x86-64, in pages that are made executable once the
+// code is written. Only call them through `call`, which sets up the state
+// runtime errors need.
+//
+struct Jit_Program {
+	static constexpr uint32_t No_Trap = std::numeric_limits<uint32_t>::max();
+	static constexpr size_t Max_Parameters = std::size(X64::Integer_Arguments) + X64::Float_Argument_Count;
+	static constexpr size_t Stack_Budget = 1 << 20;
+
+	struct Trap {
+		Code_Location location;
+		const char *message;
+	};
+
+	void *memory = nullptr;
+	size_t size = 0;
+	std::unordered_map<PID, Jit_Function> functions;
+	std::vector<Trap> traps;
+
+	Jit_Program() = default;
+	Jit_Program(const Jit_Program &) = delete;
+	Jit_Program &operator=(const Jit_Program &) = delete;
+
+	~Jit_Program() {
+		if (memory) munmap(memory, size);
+	}
+
+	const Jit_Function *find(PID pid) const {
+		auto it = functions.find(pid);
+		return it == functions.end() ? nullptr : &it->second;
+	}
+
+	Result<void> load(const std::vector<uint8_t> &code) {
+		size = std::max<size_t>(code.size(), 1);
+		void *pages = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		verify(pages != MAP_FAILED, "Couldn't map memory for native code: %s.", strerror(errno));
+
+		memory = pages;
+		memcpy(memory, code.data(), code.size());
+		verify(mprotect(memory, size, PROT_READ | PROT_EXEC) == 0, "Couldn't make native code executable: %s.", strerror(errno));
+		return {};
+	}
+
+	// Calls may use the native stack down to `stack_limit`, or by default
+	// `Stack_Budget` below where they start.
+	//
+	Result<Value> call(const Jit_Function &function, const Value *arguments, const char *stack_limit = nullptr) const {
+		using Entry = void (*)(const Value *arguments, Value *result, Jit_State *state);
+
+		char here;
+		Jit_State state = {};
+		state.trap = No_Trap;
+		state.stack_limit = stack_limit ? reinterpret_cast<uint64_t>(stack_limit) : reinterpret_cast<uint64_t>(&here) - Stack_Budget;
+
+		Value result = {};
+		reinterpret_cast<Entry>(static_cast<char *>(memory) + function.entry)(arguments, &result, &state);
+
+		if (state.trap != No_Trap) {
+			error(traps[state.trap].location, "%s", traps[state.trap].message);
+		}
+		return result;
+	}
+};
+
+// Whether native code is for this process or for an object file. JIT code
+// reports traps through `Jit_State` so the caller can turn them into
+// diagnostics; object code has no caller to report to, so a trap prints
+// its message and exits, and string literals go in `.rodata`.
+//
+enum class Native_Target : uint8_t {
+	Jit,
+	Object,
+};
+
+// A function (or helper) in an object file's `.text`.
+//
+struct Native_Symbol {
+	std::string name;
+	size_t offset;
+	size_t size;
+	bool global;
+};
+
+// Compiles every function that only uses numbers, booleans and characters
+// (and only calls other such functions) straight to machine code. It's a
+// one-pass stack-machine translation: every variable lives in the frame,
+// every expression leaves its value in `rax` (floats as their bits) and
+// operands wait on the stack. That's far from what an optimizing compiler
+// would make, but it's still several times faster than interpreting.
+//
+// For an object file every function has to compile, strings are allowed
+// too (as pointers to a size and then the bytes), and the top level
+// becomes `_start`.
+//
+struct X64_Compiler {
+	Jit_Program *program; // null for an object file
+	Native_Target target = Native_Target::Jit;
+
+	X64_Emitter x;
+	std::unordered_map<PID, AST_Function_Declaration *> candidates;
+	std::unordered_map<PID, size_t> offsets; // where each compiled function's code starts
+	std::vector<std::pair<size_t, PID>> calls;
+
+	// The helpers every trap and string comparison jump to.
+	size_t trap_stub = 0;
+	size_t string_equal = 0;
+
+	// What an object file needs besides the code. Each reference is the
+	// offset of a rel32 in `code` and the offset in `rodata` it points at.
+	std::vector<uint8_t> rodata;
+	std::vector<std::pair<size_t, size_t>> rodata_references;
+	std::vector<Native_Symbol> symbols;
+
+	struct Pending_Trap {
+		size_t jump;
+		Code_Location location;
+		const char *message;
+	};
+	std::vector<Pending_Trap> pending_traps; // of the function being compiled
+
+	Result<void> compile(AST_Block *ast) {
+		verify(JIT_SUPPORTED, ast->location, "Native code generation needs an x86-64 machine.");
+
+		std::vector<AST_Function_Declaration *> functions;
+		collect_functions(ast, functions);
+		select_candidates(functions);
+		if (candidates.empty()) return {};
+
+		emit_trap_stub();
+
+		std::vector<AST_Function_Declaration *> selected;
+		for (AST_Function_Declaration *decl : functions) {
+			if (candidates.count(decl->pid)) selected.push_back(decl);
+		}
+
+		for (AST_Function_Declaration *decl : selected) {
+			offsets[decl->pid] = x.here();
+			compile_function(decl);
+		}
+
+		for (AST_Function_Declaration *decl : selected) {
+			Jit_Function &function = program->functions[decl->pid];
+			function = Jit_Function { offsets[decl->pid], 0, decl->type };
+			emit_entry(function);
+		}
+
+		patch_calls();
+		return program->load(x.code);
+	}
+
+	// Compiles the whole program for an object file, with a global symbol
+	// for each top-level function. If the top level does more than declare
+	// functions, it's compiled too, and `_start` runs it and exits.
+	//
+	Result<void> compile_object(AST_Block *ast) {
+		internal_verify(target == Native_Target::Object, "Compiling an object file for the JIT!");
+
+		std::vector<AST_Function_Declaration *> functions;
+		collect_functions(ast, functions);
+		select_candidates(functions);
+
+		std::unordered_map<AST_Function_Declaration *, Symbol_ID> names;
+		collect_function_names(ast, names);
+
+		for (AST_Function_Declaration *decl : functions) {
+			verify(candidates.count(decl->pid), decl->location, "`%s` can't be compiled to native code yet.", interner.get(names[decl]).str().c_str());
+		}
+
+		bool runs = false;
+		for (AST *node : ast->nodes) {
+			if (node->kind == AST_Kind::Constant_Instantiation) continue;
+			verify(supported(node), node->location, "This can't be compiled to native code yet.");
+			runs = true;
+		}
+
+		size_t start = x.here();
+		emit_object_trap_stub();
+		symbols.push_back({ "ds_trap", start, x.here() - start, false });
+
+		start = x.here();
+		emit_string_equal();
+		symbols.push_back({ "ds_string_equal", start, x.here() - start, false });
+
+		std::unordered_set<AST_Function_Declaration *> top_level;
+		for (AST *node : ast->nodes) {
+			if (AST_Function_Declaration *decl = Typechecker::function_constant(node)) top_level.insert(decl);
+		}
+
+		for (AST_Function_Declaration *decl : functions) {
+			start = offsets[decl->pid] = x.here();
+			compile_function(decl);
+			symbols.push_back({ interner.get(names[decl]).str(), start, x.here() - start, top_level.count(decl) > 0 });
+		}
+
+		if (runs) {
+			Size slots = 0;
+			frame_size(ast, slots);
+
+			start = x.here();
+			emit_prologue(slots);
+			for (AST *node : ast->nodes) {
+				generate(node);
+			}
+			emit_epilogue();
+			emit_pending_traps();
+			symbols.push_back({ "ds_top_level", start, x.here() - start, false });
+
+			size_t entry = x.here();
+			x.patch(x.call(), start);
+			x.register_op(0, false, { 0x31 }, X64::RDI, X64::RDI); // xor edi, edi
+			emit_exit();
+			symbols.push_back({ "_start", entry, x.here() - entry, true });
+		}
+
+		patch_calls();
+		return {};
+	}
+
+private:
+	bool supported_type(Type_ID type) const {
+		switch (type_table[type].kind) {
+			case Type_Kind::Null:
+			case Type_Kind::Boolean:
+			case Type_Kind::Character:
+			case Type_Kind::Integer:
+			case Type_Kind::Floating_Point:
+				return true;
+			case Type_Kind::String:
+				return target == Native_Target::Object;
+			default:
+				return false;
+		}
+	}
+
+	static bool is_float(Type_ID type) {
+		return type == Type_Table::Float32 || type == Type_Table::Float64;
+	}
+
+	bool supported_signature(AST_Function_Declaration *decl) const {
+		const Type &type = type_table[decl->type];
+		Type_ID return_type = type.data.function.return_type;
+		if (return_type != Type_Table::No_Type && !supported_type(return_type)) return false;
+
+		size_t integers = 0;
+		size_t floats = 0;
+
+		Array<const Type_ID> parameters = type_table.parameters_of(decl->type);
+		for (size_t i = 0; i < parameters.count; i++) {
+			if (!supported_type(parameters.elems[i])) return false;
+			(is_float(parameters.elems[i]) ? floats : integers)++;
+		}
+
+		return integers <= std::size(X64::Integer_Arguments) && floats <= X64::Float_Argument_Count;
+	}
+
+	bool supported(AST *node) const {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier:
+				return type_table[node->type].kind == Type_Kind::Function || supported_type(node->type);
+			case AST_Kind::Literal_String:
+				return target == Native_Target::Object;
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE:
+				if (!supported_type(ast_cast<AST_Binary>(node)->lhs->type)) return false;
+				break;
+			case AST_Kind::Binary_Assignment:
+				if (!ast_cast_if<AST_Symbol>(ast_cast<AST_Binary>(node)->lhs)) return false;
+				break;
+			case AST_Kind::Binary_Call: {
+				AST_Symbol *callee = ast_cast<AST_Symbol>(ast_cast<AST_Binary>(node)->lhs);
+				if (!candidates.count(callee->pid)) return false;
+			} break;
+			case AST_Kind::Variable_Instantiation: {
+				AST *initializer = ast_cast<AST_Variable_Instantiation>(node)->initializer;
+				return supported_type(initializer->type) && supported(initializer);
+			}
+			case AST_Kind::Constant_Instantiation:
+				return true; // a nested function stands on its own
+			default:
+				break;
+		}
+
+		bool all = true;
+		for_each_child(node, [this, &all](AST *child) {
+			all = all && supported(child);
+		});
+		return all;
+	}
 
-			// keywords
-			CASE(Keyword_If, None);
-			CASE(Keyword_Else, None);
-			CASE(Keyword_While, None);
-			CASE(Keyword_Fn, None);
+	// Drops functions until every call left is to a function that's kept.
+	//
+	void select_candidates(const std::vector<AST_Function_Declaration *> &functions) {
+		for (AST_Function_Declaration *decl : functions) {
+			if (supported_signature(decl)) candidates[decl->pid] = decl;
+		}
 
-			default:
-				internal_error("Unhandled Token_Kind: %s!", debug_str(kind).c_str());
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (AST_Function_Declaration *decl : functions) {
+				if (candidates.count(decl->pid) && !supported(decl->body)) {
+					candidates.erase(decl->pid);
+					changed = true;
+				}
+			}
 		}
+	}
 
-		#undef CASE
+	static void frame_size(AST *node, Size &size) {
+		if (node->kind == AST_Kind::Constant_Instantiation) return;
+		if (node->kind == AST_Kind::Variable_Instantiation) {
+			size = std::max<Size>(size, ast_cast<AST_Variable_Instantiation>(node)->symbol->slot + Size { 1 });
+		}
+
+		for_each_child(node, [&size](AST *child) {
+			frame_size(child, size);
+		});
 	}
 
-	void debug_print(int indentation = 0) const {
-		printf("%*sToken::%s:\n", static_cast<int>(Print_Indentation_Size * indentation), "", debug_str(kind).c_str());
+	static int32_t slot_offset(uint32_t slot) {
+		return -8 * static_cast<int32_t>(slot + 1);
+	}
 
-		// @TODO:
-		// print data
-		//
-		switch (kind) {
-			case Token_Kind::Literal_Boolean:
-				printf("%*sdata: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.boolean ? "true" : "false");
-				break;
-			case Token_Kind::Literal_Character:
-				printf("%*sdata: %c\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.character);
+	void patch_calls() {
+		for (auto [at, pid] : calls) {
+			x.patch(at, offsets[pid]);
+		}
+	}
+
+	// The callee-saved registers the entry thunk keeps, in push order.
+	//
+	static constexpr X64::Register Saved[] = { X64::R15, X64::RBX, X64::R12, X64::R13 };
+
+	void emit_restore_and_return() {
+		for (size_t i = std::size(Saved); i-- > 0;) x.pop(Saved[i]);
+		x.pop(X64::RBP);
+		x.ret();
+	}
+
+	// Jumped to with the trap's index in `eax`.
+	//
+	void emit_trap_stub() {
+		trap_stub = x.here();
+		x.memory_op(0, false, { 0x89 }, X64::RAX, X64::R15, offsetof(Jit_State, trap));
+		x.load(X64::RSP, X64::R15, offsetof(Jit_State, saved_rsp));
+		emit_restore_and_return();
+	}
+
+	// `exit(edi)`
+	//
+	void emit_exit() {
+		x.byte(0xB8); // mov eax, SYS_exit
+		x.u32(60);
+		x.bytes({ 0x0F, 0x05 }); // syscall
+	}
+
+	// Jumped to with a message in `rsi` and its length in `edx`, which it
+	// writes to stderr before exiting with 1.
+	//
+	void emit_object_trap_stub() {
+		trap_stub = x.here();
+		x.byte(0xBF); // mov edi, stderr
+		x.u32(2);
+		x.byte(0xB8); // mov eax, SYS_write
+		x.u32(1);
+		x.bytes({ 0x0F, 0x05 }); // syscall
+		x.byte(0xBF); // mov edi, 1
+		x.u32(1);
+		emit_exit();
+	}
+
+	// Compares the strings at `rdi` and `rsi`, leaving 1 in `eax` if they're
+	// equal and 0 if not.
+	//
+	void emit_string_equal() {
+		string_equal = x.here();
+
+		x.load(X64::RCX, X64::RDI, 0);
+		x.memory_op(0, true, { 0x3B }, X64::RCX, X64::RSI, 0); // cmp rcx, [rsi]
+		size_t different_sizes = x.jump_if(X64::Not_Equal);
+
+		size_t loop = x.here();
+		x.register_op(0, true, { 0x85 }, X64::RCX, X64::RCX); // test rcx, rcx
+		size_t equal = x.jump_if(X64::Equal);
+		x.memory_op(0, false, { 0x0F, 0xB6 }, X64::RAX, X64::RDI, 8); // movzx eax, byte [rdi + 8]
+		x.memory_op(0, false, { 0x3A }, X64::RAX, X64::RSI, 8); // cmp al, [rsi + 8]
+		size_t different_chars = x.jump_if(X64::Not_Equal);
+		x.register_op(0, true, { 0xFF }, 0, X64::RDI); // inc rdi
+		x.register_op(0, true, { 0xFF }, 0, X64::RSI); // inc rsi
+		x.register_op(0, true, { 0xFF }, 1, X64::RCX); // dec rcx
+		x.patch(x.jump(), loop);
+
+		x.patch(equal, x.here());
+		x.byte(0xB8); // mov eax, 1
+		x.u32(1);
+		x.ret();
+
+		x.patch(different_sizes, x.here());
+		x.patch(different_chars, x.here());
+		x.register_op(0, false, { 0x31 }, X64::RAX, X64::RAX); // xor eax, eax
+		x.ret();
+	}
+
+	void emit_entry(Jit_Function &function) {
+		function.entry = x.here();
+
+		x.push(X64::RBP);
+		x.mov(X64::RBP, X64::RSP);
+		for (X64::Register r : Saved) x.push(r);
+
+		x.mov(X64::R15, X64::RDX);
+		x.mov(X64::RBX, X64::RDI);
+		x.mov(X64::R13, X64::RSI);
+		x.store(X64::R15, offsetof(Jit_State, saved_rsp), X64::RSP);
+
+		size_t integers = 0;
+		size_t floats = 0;
+
+		Array<const Type_ID> parameters = type_table.parameters_of(function.type);
+		for (size_t i = 0; i < parameters.count; i++) {
+			int32_t offset = static_cast<int32_t>(8 * i);
+			if (is_float(parameters.elems[i])) {
+				x.memory_op(0xF2, false, { 0x0F, 0x10 }, static_cast<int>(floats++), X64::RBX, offset); // movsd xmm, [rbx + offset]
+			} else {
+				x.load(X64::Integer_Arguments[integers++], X64::RBX, offset);
+			}
+		}
+
+		size_t at = x.call();
+		x.patch(at, function.code);
+
+		if (is_float(type_table[function.type].data.function.return_type)) {
+			x.memory_op(0x66, false, { 0x0F, 0xD6 }, 0, X64::R13, 0); // movq [r13], xmm0
+		} else {
+			x.store(X64::R13, 0, X64::RAX);
+		}
+
+		emit_restore_and_return();
+	}
+
+	void emit_prologue(Size slots) {
+		uint32_t frame_bytes = static_cast<uint32_t>((slots * 8 + 15) & ~Size { 15 });
+
+		x.push(X64::RBP);
+		x.mov(X64::RBP, X64::RSP);
+		x.register_op(0, true, { 0x81 }, 5, X64::RSP); // sub rsp, frame_bytes
+		x.u32(frame_bytes);
+	}
+
+	void emit_epilogue() {
+		x.mov(X64::RSP, X64::RBP);
+		x.pop(X64::RBP);
+		x.ret();
+	}
+
+	void emit_pending_traps() {
+		for (const Pending_Trap &pending : pending_traps) {
+			x.patch(pending.jump, x.here());
+
+			if (target == Native_Target::Jit) {
+				program->traps.push_back({ pending.location, pending.message });
+				x.byte(0xB8); // mov eax, trap
+				x.u32(static_cast<uint32_t>(program->traps.size() - 1));
+			} else {
+				// The same message a diagnostic would print.
+				std::string message = std::string { Color::Red } + "Error @ " + pending.location.debug_str() + ": " + pending.message + Color::Reset + "\n";
+				size_t at = rodata.size();
+				rodata.insert(rodata.end(), message.begin(), message.end());
+
+				x.bytes({ 0x48, 0x8D, 0x35 }); // lea rsi, [rip + message]
+				rodata_references.push_back({ x.here(), at });
+				x.u32(0);
+				x.byte(0xBA); // mov edx, size
+				x.u32(static_cast<uint32_t>(message.size()));
+			}
+			x.patch(x.jump(), trap_stub);
+		}
+		pending_traps.clear();
+	}
+
+	void compile_function(AST_Function_Declaration *decl) {
+		Size slots = decl->parameters->nodes.size();
+		frame_size(decl->body, slots);
+		emit_prologue(slots);
+
+		size_t integers = 0;
+		size_t floats = 0;
+
+		Array<const Type_ID> parameters = type_table.parameters_of(decl->type);
+		for (size_t i = 0; i < parameters.count; i++) {
+			int32_t offset = slot_offset(static_cast<uint32_t>(i));
+			if (is_float(parameters.elems[i])) {
+				x.memory_op(0x66, false, { 0x0F, 0xD6 }, static_cast<int>(floats++), X64::RBP, offset); // movq [rbp + offset], xmm
+			} else {
+				X64::Register r = X64::Integer_Arguments[integers++];
+				normalize(r, parameters.elems[i]);
+				x.store(X64::RBP, offset, r);
+			}
+		}
+
+		for (AST *node : decl->body->nodes) {
+			generate(node);
+		}
+
+		if (is_float(type_table[decl->type].data.function.return_type)) {
+			x.register_op(0x66, true, { 0x0F, 0x6E }, 0, X64::RAX); // movq xmm0, rax
+		}
+
+		emit_epilogue();
+		emit_pending_traps();
+	}
+
+	// The System V ABI leaves the bits above a narrow argument undefined,
+	// so a caller written in C needn't extend them the way we do.
+	//
+	void normalize(X64::Register r, Type_ID type) {
+		switch (type) {
+			case Type_Table::Boolean:   x.register_op(0, true, { 0x0F, 0xB6 }, r, r); break; // movzx r, r8
+			case Type_Table::Character: x.register_op(0, false, { 0x89 }, r, r);      break; // mov r32, r32
+			case Type_Table::Integer8:  x.register_op(0, true, { 0x0F, 0xBE }, r, r); break;
+			case Type_Table::Integer16: x.register_op(0, true, { 0x0F, 0xBF }, r, r); break;
+			case Type_Table::Integer32: x.register_op(0, true, { 0x63 }, r, r);       break;
+		}
+	}
+
+	// Sign-extends `rax` from the width of `type`, so integers stay in the
+	// same form the other backends keep them in.
+	//
+	void extend(Type_ID type) {
+		switch (type) {
+			case Type_Table::Integer8:  x.register_op(0, true, { 0x0F, 0xBE }, X64::RAX, X64::RAX); break;
+			case Type_Table::Integer16: x.register_op(0, true, { 0x0F, 0xBF }, X64::RAX, X64::RAX); break;
+			case Type_Table::Integer32: x.register_op(0, true, { 0x63 }, X64::RAX, X64::RAX);       break;
+		}
+	}
+
+	// `lhs` ends up in `rax` and `rhs` in `rcx`.
+	//
+	void generate_operands(AST_Binary *binary) {
+		generate(binary->lhs);
+		x.push(X64::RAX);
+		generate(binary->rhs);
+		x.mov(X64::RCX, X64::RAX);
+		x.pop(X64::RAX);
+	}
+
+	void move_operands_to_xmm() {
+		x.register_op(0x66, true, { 0x0F, 0x6E }, 0, X64::RAX); // movq xmm0, rax
+		x.register_op(0x66, true, { 0x0F, 0x6E }, 1, X64::RCX); // movq xmm1, rcx
+	}
+
+	void generate(AST *node) {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier: {
+				AST_Symbol *symbol = ast_cast<AST_Symbol>(node);
+				if (type_table[symbol->type].kind == Type_Kind::Function) break;
+				x.load(X64::RAX, X64::RBP, slot_offset(symbol->slot));
+			} break;
+
+			case AST_Kind::Literal_Null:
+				x.mov_immediate(X64::RAX, 0);
 				break;
-			case Token_Kind::Literal_Integer:
-				printf("%*sdata: %lld\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.integer);
+			case AST_Kind::Literal_Boolean:
+				x.mov_immediate(X64::RAX, ast_cast<AST_Literal>(node)->as.boolean);
 				break;
-			case Token_Kind::Literal_Floating_Point:
-				printf("%*sdata: '%f'\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", data.floating_point);
+			case AST_Kind::Literal_Character:
+				x.mov_immediate(X64::RAX, ast_cast<AST_Literal>(node)->as.character);
 				break;
-			case Token_Kind::Literal_String:
-				printf("%*sdata: \"%.*s\"\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", static_cast<int>(data.string.size), data.string.chars);
+			case AST_Kind::Literal_Integer:
+				x.mov_immediate(X64::RAX, static_cast<uint64_t>(ast_cast<AST_Literal>(node)->as.integer));
 				break;
-			case Token_Kind::Symbol_Identifier:
-				printf("%*sdata: \"%.*s\"\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", static_cast<int>(data.string.size), data.string.chars);
+			case AST_Kind::Literal_Floating_Point: {
+				Value value = {};
+				if (node->type == Type_Table::Float32) {
+					value.f32 = static_cast<Runtime_Type::Floating_Point32>(ast_cast<AST_Literal>(node)->as.floating_point);
+				} else {
+					value.f64 = ast_cast<AST_Literal>(node)->as.floating_point;
+				}
+				x.mov_immediate(X64::RAX, static_cast<uint64_t>(value.integer));
+			} break;
+			case AST_Kind::Literal_String: {
+				String string = ast_cast<AST_Literal>(node)->as.string;
+				rodata.resize((rodata.size() + 7) & ~size_t { 7 });
+				size_t at = rodata.size();
+
+				uint64_t size = string.size;
+				rodata.insert(rodata.end(), reinterpret_cast<uint8_t *>(&size), reinterpret_cast<uint8_t *>(&size + 1));
+				rodata.insert(rodata.end(), string.chars, string.chars + string.size);
+
+				x.bytes({ 0x48, 0x8D, 0x05 }); // lea rax, [rip + string]
+				rodata_references.push_back({ x.here(), at });
+				x.u32(0);
+			} break;
+
+			case AST_Kind::Unary_Not: {
+				generate(ast_cast<AST_Unary>(node)->sub);
+				x.register_op(0, false, { 0x83 }, 6, X64::RAX); // xor eax, 1
+				x.byte(1);
+			} break;
+			case AST_Kind::Unary_Negate: {
+				generate(ast_cast<AST_Unary>(node)->sub);
+				if (is_float(node->type)) {
+					x.register_op(0, true, { 0x0F, 0xBA }, 7, X64::RAX); // btc rax, sign bit
+					x.byte(node->type == Type_Table::Float32 ? 31 : 63);
+				} else {
+					x.register_op(0, true, { 0xF7 }, 3, X64::RAX); // neg rax
+					extend(node->type);
+				}
+			} break;
+
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				generate_operands(binary);
+
+				if (is_float(node->type)) {
+					uint8_t op = 0x58;
+					switch (node->kind) {
+						case AST_Kind::Binary_Subtract: op = 0x5C; break;
+						case AST_Kind::Binary_Multiply: op = 0x59; break;
+						case AST_Kind::Binary_Divide:   op = 0x5E; break;
+						default: break;
+					}
+
+					move_operands_to_xmm();
+					x.register_op(node->type == Type_Table::Float32 ? 0xF3 : 0xF2, false, { 0x0F, op }, 0, 1); // op xmm0, xmm1
+					x.register_op(0x66, true, { 0x0F, 0x7E }, 0, X64::RAX); // movq rax, xmm0
+					break;
+				}
+
+				switch (node->kind) {
+					case AST_Kind::Binary_Add:
+						x.register_op(0, true, { 0x01 }, X64::RCX, X64::RAX);
+						break;
+					case AST_Kind::Binary_Subtract:
+						x.register_op(0, true, { 0x29 }, X64::RCX, X64::RAX);
+						break;
+					case AST_Kind::Binary_Multiply:
+						x.register_op(0, true, { 0x0F, 0xAF }, X64::RAX, X64::RCX);
+						break;
+					default: {
+						// Dividing by -1 is negating, which wraps instead of
+						// faulting on the most negative value.
+						x.register_op(0, true, { 0x85 }, X64::RCX, X64::RCX); // test rcx, rcx
+						pending_traps.push_back({ x.jump_if(X64::Equal), node->location, "Division by zero." });
+
+						x.register_op(0, true, { 0x83 }, 7, X64::RCX); // cmp rcx, -1
+						x.byte(0xFF);
+						size_t divide = x.jump_if(X64::Not_Equal);
+						x.register_op(0, true, { 0xF7 }, 3, X64::RAX); // neg rax
+						size_t done = x.jump();
+
+						x.patch(divide, x.here());
+						x.bytes({ 0x48, 0x99 }); // cqo
+						x.register_op(0, true, { 0xF7 }, 7, X64::RCX); // idiv rcx
+						x.patch(done, x.here());
+					} break;
+				}
+				extend(node->type);
+			} break;
+
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				bool equal = node->kind == AST_Kind::Binary_EQ;
+				generate_operands(binary);
+
+				if (is_float(binary->lhs->type)) {
+					// Unordered compares set ZF and PF, and NaN equals nothing.
+					move_operands_to_xmm();
+					x.register_op(binary->lhs->type == Type_Table::Float32 ? 0 : 0x66, false, { 0x0F, 0x2E }, 0, 1); // ucomis xmm0, xmm1
+					x.register_op(0, false, { 0x0F, static_cast<uint8_t>(0x90 | (equal ? X64::Equal : X64::Not_Equal)) }, 0, X64::RAX);
+					x.register_op(0, false, { 0x0F, static_cast<uint8_t>(0x90 | (equal ? X64::No_Parity : X64::Parity)) }, 0, X64::RCX);
+					x.register_op(0, false, { static_cast<uint8_t>(equal ? 0x20 : 0x08) }, X64::RCX, X64::RAX); // and/or al, cl
+				} else if (binary->lhs->type == Type_Table::String) {
+					x.mov(X64::RDI, X64::RAX);
+					x.mov(X64::RSI, X64::RCX);
+					x.patch(x.call(), string_equal);
+					if (!equal) {
+						x.register_op(0, false, { 0x83 }, 6, X64::RAX); // xor eax, 1
+						x.byte(1);
+					}
+					break;
+				} else {
+					x.register_op(0, true, { 0x39 }, X64::RCX, X64::RAX); // cmp rax, rcx
+					x.register_op(0, false, { 0x0F, static_cast<uint8_t>(0x90 | (equal ? X64::Equal : X64::Not_Equal)) }, 0, X64::RAX);
+				}
+				x.register_op(0, false, { 0x0F, 0xB6 }, X64::RAX, X64::RAX); // movzx eax, al
+			} break;
+
+			case AST_Kind::Binary_And:
+			case AST_Kind::Binary_Or: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				generate(binary->lhs);
+				x.register_op(0, true, { 0x85 }, X64::RAX, X64::RAX); // test rax, rax
+				size_t done = x.jump_if(node->kind == AST_Kind::Binary_And ? X64::Equal : X64::Not_Equal);
+				generate(binary->rhs);
+				x.patch(done, x.here());
+			} break;
+
+			case AST_Kind::Binary_Assignment: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				generate(binary->rhs);
+				x.store(X64::RBP, slot_offset(ast_cast<AST_Symbol>(binary->lhs)->slot), X64::RAX);
+			} break;
+			case AST_Kind::Variable_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+				generate(inst->initializer);
+				x.store(X64::RBP, slot_offset(inst->symbol->slot), X64::RAX);
+			} break;
+			case AST_Kind::Constant_Instantiation:
 				break;
 
+			case AST_Kind::Binary_While: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				size_t start = x.here();
+				generate(binary->lhs);
+				x.register_op(0, true, { 0x85 }, X64::RAX, X64::RAX);
+				size_t exit = x.jump_if(X64::Equal);
+
+				generate(binary->rhs);
+				x.patch(x.jump(), start);
+				x.patch(exit, x.here());
+			} break;
+			case AST_Kind::If: {
+				AST_If *if_ = ast_cast<AST_If>(node);
+
+				generate(if_->condition);
+				x.register_op(0, true, { 0x85 }, X64::RAX, X64::RAX);
+				size_t skip_then = x.jump_if(X64::Equal);
+				generate(if_->then_block);
+
+				if (if_->else_block) {
+					size_t skip_else = x.jump();
+					x.patch(skip_then, x.here());
+					generate(if_->else_block);
+					x.patch(skip_else, x.here());
+				} else {
+					x.patch(skip_then, x.here());
+				}
+			} break;
+			case AST_Kind::Block: {
+				for (AST *child : ast_cast<AST_Block>(node)->nodes) {
+					generate(child);
+				}
+			} break;
+
+			case AST_Kind::Binary_Call: {
+				AST_Binary *call = ast_cast<AST_Binary>(node);
+				AST_Symbol *callee = ast_cast<AST_Symbol>(call->lhs);
+				const std::vector<AST *> &arguments = ast_cast<AST_Block>(call->rhs)->nodes;
+
+				for (AST *argument : arguments) {
+					generate(argument);
+					x.push(X64::RAX);
+				}
+
+				Array<const Type_ID> parameters = type_table.parameters_of(callee->type);
+				size_t integers = 0;
+				size_t floats = 0;
+				for (size_t i = 0; i < parameters.count; i++) {
+					(is_float(parameters.elems[i]) ? floats : integers)++;
+				}
+
+				for (size_t i = parameters.count; i-- > 0;) {
+					if (is_float(parameters.elems[i])) {
+						x.pop(X64::RAX);
+						x.register_op(0x66, true, { 0x0F, 0x6E }, static_cast<int>(--floats), X64::RAX); // movq xmm, rax
+					} else {
+						x.pop(X64::Integer_Arguments[--integers]);
+					}
+				}
+
+				// Object code runs on its own stack, where overflowing faults.
+				if (target == Native_Target::Jit) {
+					x.memory_op(0, true, { 0x3B }, X64::RSP, X64::R15, offsetof(Jit_State, stack_limit)); // cmp rsp, [r15 + stack_limit]
+					pending_traps.push_back({ x.jump_if(X64::Below), node->location, "Stack overflow." });
+				}
+				calls.push_back({ x.call(), callee->pid });
+
+				if (is_float(call->type)) {
+					x.register_op(0x66, true, { 0x0F, 0x7E }, 0, X64::RAX); // movq rax, xmm0
+				}
+			} break;
+
 			default:
-				break;
+				internal_error("Unhandled AST_Kind in native code: %s!", debug_str(node->kind).c_str());
 		}
+	}
+};
 
-		printf("%*slocation: %s\n", static_cast<int>(Print_Indentation_Size * (indentation + 1)), "", location.debug_str().c_str());
+//
+//
+// Closure Evaluation
+//
+//
+
+struct Closure;
+struct Closure_Function;
+struct Closure_Evaluator;
+
+using Closure_Code = Value (*)(const Closure *self, Value *frame, Closure_Evaluator *evaluator);
+
+// One node of a typechecked tree turned into a call: `code` already knows
+// the node's operation and operand types, and variables are already frame
+// indices, so evaluating never looks at an `AST_Kind`, a `Type` or a scope.
+//
+struct Closure {
+	Closure_Code code;
+	const Closure *a = nullptr;
+	const Closure *b = nullptr;
+	const Closure *c = nullptr;
+	const Closure *const *children = nullptr; // blocks and call arguments
+	uint32_t count = 0;
+	uint32_t slot = 0;
+	Value constant = {};
+	const Closure_Function *function = nullptr; // the callee of a call
+	Code_Location location;
+
+	Value operator()(Value *frame, Closure_Evaluator *evaluator) const {
+		return code(this, frame, evaluator);
 	}
+};
 
-	std::string display_str() const {
-		#define CASE(kind, display) case Token_Kind::kind: return display
+struct Closure_Function {
+	const Closure *body = nullptr;
+	Size frame_size = 1;
 
-		switch (kind) {
-			CASE(Eof, "EOF");
+	// Set when the function was also compiled to native code, which calls
+	// then go to instead.
+	//
+	const Jit_Program *jit = nullptr;
+	const Jit_Function *native = nullptr;
+};
 
-			// literals
-			CASE(Literal_Null, "null");
-			CASE(Literal_Boolean, data.boolean ? "true" : "false");
-			CASE(Literal_Character, std::to_string(data.character));
-			CASE(Literal_Integer, std::to_string(data.integer));
-			CASE(Literal_Floating_Point, std::to_string(data.floating_point));
-			CASE(Literal_String, data.string.str());
-		
-			// symbols
-			CASE(Symbol_Identifier, data.string.str());
-		
-			// delimeters
-			CASE(Delimeter_Newline, "new-line");
-			CASE(Delimeter_Semicolon, ";");
-			CASE(Delimeter_Comma, ",");
-			CASE(Delimeter_Left_Parenthesis, "(");
-			CASE(Delimeter_Right_Parenthesis, ")");
-			CASE(Delimeter_Left_Curly, "{");
-			CASE(Delimeter_Right_Curly, "}");
-		
-			// punctuation
-			CASE(Punctuation_Bang, "!");
-			CASE(Punctuation_Bang_Equal, "!=");
-			CASE(Punctuation_Equal, "=");
-			CASE(Punctuation_Equal_Equal, "==");
-			CASE(Punctuation_Colon, ":");
-			CASE(Punctuation_Plus, "+");
-			CASE(Punctuation_Dash, "-");
-			CASE(Punctuation_Star, "*");
-			CASE(Punctuation_Slash, "/");
-			CASE(Punctuation_Ampersand_Ampersand, "&&");
-			CASE(Punctuation_Pipe_Pipe, "||");
-			CASE(Punctuation_Right_Thin_Arrow, "->");
-		
-			// keywords
-			CASE(Keyword_If, "if");
-			CASE(Keyword_Else, "else");
-			CASE(Keyword_While, "while");
-			CASE(Keyword_Fn, "fn");
+// Frames are bump-allocated from one value stack. A runtime error is left
+// in `failure`; blocks and loops stop as soon as it's set, and whatever
+// values are computed meanwhile are thrown away.
+//
+struct Closure_Evaluator {
+	static constexpr size_t Stack_Size = 1 << 20; // in values
 
-			default:
-				internal_error("Unhandled Token_Kind: %s!\n", debug_str(kind).c_str());
-		}
+	// Calls recurse on the native stack, so `evaluate_program` runs the tree
+	// on a thread with this much of it. That's enough to recurse as deep as
+	// the bytecode VM's stack allows for the same program.
+	//
+	static constexpr size_t Native_Stack_Size = 256 << 20;
+	static constexpr size_t Native_Stack_Reserve = 256 << 10; // left for whatever a call runs into
+
+	std::unique_ptr<Value[]> stack { new Value[Stack_Size] };
+	Value *top = stack.get();
+	Value *end = stack.get() + Stack_Size;
+	const char *native_limit = nullptr; // calls fail once the native stack reaches it
+	Diagnostic *failure = nullptr;
+
+	Value fail(Code_Location location, const char *message) {
+		if (!failure) failure = error_impl(location, "%s", message);
+		return Value {};
+	}
+};
 
-		#undef CASE
+template<typename T>
+T value_as(Value value) {
+	if constexpr (std::is_same_v<T, Runtime_Type::Floating_Point32>) {
+		return value.f32;
+	} else if constexpr (std::is_same_v<T, Runtime_Type::Floating_Point64>) {
+		return value.f64;
+	} else {
+		return static_cast<T>(value.integer);
+	}
+}
+
+template<typename T>
+Value value_of(T x) {
+	Value value;
+	if constexpr (std::is_same_v<T, Runtime_Type::Floating_Point32>) {
+		value.f32 = x;
+	} else if constexpr (std::is_same_v<T, Runtime_Type::Floating_Point64>) {
+		value.f64 = x;
+	} else {
+		value.integer = x;
 	}
+	return value;
+}
+
+// Variables and constants are read straight out of an operator's operand
+// closures instead of being called, which saves an indirect call on most
+// operands in practice.
+//
+enum class Operand : uint8_t {
+	Any,
+	Variable,
+	Constant,
 };
 
-struct Tokenizer {
-	size_t line = 0;
-	size_t coloumn = 0;
-	const char *filename;
-	String source;
-	Token previous_token;
-	std::optional<Token> peeked_token;
+namespace Closure_Op {
+	template<Operand Kind>
+	inline Value fetch(const Closure *operand, Value *frame, Closure_Evaluator *evaluator) {
+		if constexpr (Kind == Operand::Variable) {
+			return frame[operand->slot];
+		} else if constexpr (Kind == Operand::Constant) {
+			return operand->constant;
+		} else {
+			return (*operand)(frame, evaluator);
+		}
+	}
+
+	Value constant(const Closure *self, Value *, Closure_Evaluator *) {
+		return self->constant;
+	}
+
+	Value variable(const Closure *self, Value *frame, Closure_Evaluator *) {
+		return frame[self->slot];
+	}
+
+	Value store(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		frame[self->slot] = (*self->a)(frame, evaluator);
+		return Value {};
+	}
 
-	// @TODO:
-	// :HandleUTF8
-	//
-	char32_t peek_char(int skip = 0) {
-		if (source.size <= 0) {
-			return '\0';
-		}
-		return source.chars[skip];
+	Value nothing(const Closure *, Value *, Closure_Evaluator *) {
+		return Value {};
 	}
 
-	// @TODO:
-	// :HandleUTF8
+	Value logical_not(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		return value_of<Runtime_Type::Integer64>(!(*self->a)(frame, evaluator).integer);
+	}
+
+	// Integer `-`, `+`, `-` and `*` wrap at the width of `T`.
 	//
-	char32_t next_char() {
-		if (source.size <= 0) {
-			return '\0';
+	template<typename T>
+	Value negate(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		T x = value_as<T>((*self->a)(frame, evaluator));
+		if constexpr (std::is_integral_v<T>) {
+			return value_of<T>(static_cast<T>(0 - static_cast<uint64_t>(x)));
+		} else {
+			return value_of<T>(-x);
 		}
-
-		char32_t next_char = peek_char();
-		source.advance();
-		coloumn++;
-		return next_char;
 	}
 
-	bool next_char_if_eq(char32_t &actual, char32_t expected) {
-		if (actual == expected) {
-			actual = next_char();
-			return true;
+	template<typename T, typename Operation, Operand L, Operand R>
+	Value arithmetic(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		T x = value_as<T>(fetch<L>(self->a, frame, evaluator));
+		T y = value_as<T>(fetch<R>(self->b, frame, evaluator));
+		if constexpr (std::is_integral_v<T>) {
+			return value_of<T>(static_cast<T>(Operation {}(static_cast<uint64_t>(x), static_cast<uint64_t>(y))));
+		} else {
+			return value_of<T>(Operation {}(x, y));
 		}
-		return false;
 	}
 
-	bool match_char(char32_t expected, char32_t *opt_out_c = nullptr) {
-		if (peek_char() == expected) {
-			char32_t c = next_char();
-			if (opt_out_c) *opt_out_c = c;
-			return true;
+	template<typename T, Operand L, Operand R>
+	Value divide(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		T x = value_as<T>(fetch<L>(self->a, frame, evaluator));
+		T y = value_as<T>(fetch<R>(self->b, frame, evaluator));
+		if constexpr (std::is_integral_v<T>) {
+			if (y == 0) return evaluator->fail(self->location, "Division by zero.");
+			if (y == -1) return value_of<T>(static_cast<T>(0 - static_cast<uint64_t>(x)));
+			return value_of<T>(static_cast<T>(x / y));
+		} else {
+			return value_of<T>(x / y);
 		}
-		return false;
 	}
 
-	Code_Location current_location() {
-		return Code_Location {
-			line,
-			coloumn,
-			filename,
-		};
+	template<typename T, bool Equal, Operand L, Operand R>
+	Value compare(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		T x = value_as<T>(fetch<L>(self->a, frame, evaluator));
+		T y = value_as<T>(fetch<R>(self->b, frame, evaluator));
+		return value_of<Runtime_Type::Integer64>((x == y) == Equal);
 	}
 
-	Token make_token(Token_Kind kind, Token_Data data = {}) {
-		return Token { 
-			kind, 
-			data
-		};
+	template<bool Equal>
+	Value compare_strings(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		const Runtime_Type::String *x = (*self->a)(frame, evaluator).string;
+		const Runtime_Type::String *y = (*self->b)(frame, evaluator).string;
+		bool equal = x->size == y->size && memcmp(x->chars, y->chars, x->size) == 0;
+		return value_of<Runtime_Type::Integer64>(equal == Equal);
 	}
 
-	bool is_whitespace(char32_t c) {
-		return c != '\n' && isspace(c);
+	Value logical_and(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		Value x = (*self->a)(frame, evaluator);
+		return x.integer ? (*self->b)(frame, evaluator) : x;
 	}
 
-	bool is_identifier_character(char32_t c) {
-		return c == '_' || isalnum(c);
+	Value logical_or(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		Value x = (*self->a)(frame, evaluator);
+		return x.integer ? x : (*self->b)(frame, evaluator);
 	}
 
-	char32_t skip_to_begining_of_next_token() {
-		char c = peek_char();
+	// A block's value is its last statement's, which is how a function body
+	// returns.
+	//
+	Value block(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		Value result = {};
+		for (uint32_t i = 0; i < self->count; i++) {
+			result = (*self->children[i])(frame, evaluator);
+			if (evaluator->failure) break;
+		}
+		return result;
+	}
 
-		while (is_whitespace(c) || c == '/') {
-			if (c == '/' && peek_char(1) == '/') {
-				while (c != '\n') {
-					next_char();
-					c = peek_char();
-				}
-				line++;
-				coloumn = 0;
-			}
+	Value if_(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		Value condition = (*self->a)(frame, evaluator);
+		if (evaluator->failure) return Value {};
 
-			if (c == '\n' && previous_token.kind == Token_Kind::Delimeter_Newline) {
-				while (c == '\n') {
-					next_char();
-					c = peek_char();
-					line++;
-					coloumn = 0;
-				}
-			} else {
-				next_char();
-				c = peek_char();
-			}
+		if (condition.integer) {
+			(*self->b)(frame, evaluator);
+		} else if (self->c) {
+			(*self->c)(frame, evaluator);
 		}
-
-		return c;
+		return Value {};
 	}
 
-	Result<Token> peek() {
-		if (peeked_token.has_value()) {
-			return peeked_token.value();
+	Value while_(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		while (true) {
+			Value condition = (*self->a)(frame, evaluator);
+			if (evaluator->failure || !condition.integer) break;
+
+			(*self->b)(frame, evaluator);
+			if (evaluator->failure) break;
 		}
-		peeked_token = try_(next());
-		return peeked_token.value();
+		return Value {};
 	}
 
-	Result<Token> next() {
-		if (peeked_token.has_value()) {
-			previous_token = peeked_token.value();
-			peeked_token = {};
-			return previous_token;
-		}
+	// The callee's frame is reserved before any argument is evaluated, so
+	// calls among the arguments get frames above it.
+	//
+	Value call(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		const Closure_Function *callee = self->function;
 
-		// @TODO:
-		// :HandleUTF8
-		//
+		char here;
+		Value *callee_frame = evaluator->top;
+		if (static_cast<size_t>(evaluator->end - callee_frame) < callee->frame_size || &here < evaluator->native_limit) {
+			return evaluator->fail(self->location, "Stack overflow.");
+		}
+		evaluator->top += callee->frame_size;
 
-		char32_t c = skip_to_begining_of_next_token();
-		Code_Location token_location = current_location();
+		for (uint32_t i = 0; i < self->count; i++) {
+			callee_frame[i] = (*self->children[i])(frame, evaluator);
+		}
 
-		if (c == '\0') {
-			previous_token = make_token(Token_Kind::Eof);
-		} else if (next_char_if_eq(c, '\n')) {
-			previous_token = make_token(Token_Kind::Delimeter_Newline);
-			line++;
-			coloumn = 0;
-		} else if (next_char_if_eq(c, '\'')) {
-			previous_token = try_(next_character_token());
-		} else if (next_char_if_eq(c, '\"')) {
-			previous_token = next_string_token();
-		} else if (isdigit(c) || (c == '.' && isdigit(peek_char(1)))) {
-			previous_token = next_number_token();
-		} else if (isalpha(c) || (c == '_' && is_identifier_character(peek_char(1)))) {
-			previous_token = next_keyword_or_identifier_token();
-		} else {
-			next_char();
-			previous_token = try_(next_punctuation_token(c));
+		Value result = {};
+		if (!evaluator->failure) {
+			result = (*callee->body)(callee_frame, evaluator);
 		}
 
-		previous_token.location = token_location;
+		evaluator->top = callee_frame;
+		return result;
+	}
 
-		return previous_token;
+	Value native_call(const Closure *self, Value *frame, Closure_Evaluator *evaluator) {
+		Value arguments[Jit_Program::Max_Parameters];
+		for (uint32_t i = 0; i < self->count; i++) {
+			arguments[i] = (*self->children[i])(frame, evaluator);
+		}
+		if (evaluator->failure) return Value {};
+
+		auto result = self->function->jit->call(*self->function->native, arguments, evaluator->native_limit);
+		if (result.is_err()) {
+			evaluator->failure = result.err();
+			return Value {};
+		}
+		return result.take();
 	}
+}
 
-	Result<Token> next_character_token() {
-		char32_t character = next_char();
+// Builds the closure tree for a typechecked program. Each operator's
+// closure is picked by its operand type here, once, instead of on every
+// evaluation.
+//
+struct Closure_Builder {
+	Arena *arena;
+	std::deque<Runtime_Type::String> *strings;
+	const Jit_Program *jit = nullptr;
+
+	std::unordered_map<PID, Closure_Function *> functions;
+	Closure_Function *function = nullptr; // the one being built
+
+	Result<Closure_Function *> build_program(AST_Block *ast) {
+		std::vector<AST_Function_Declaration *> declarations;
+		collect_functions(ast, declarations);
+
+		for (AST_Function_Declaration *decl : declarations) {
+			Closure_Function *built = arena->make<Closure_Function>();
+			built->frame_size = std::max<Size>(decl->parameters->nodes.size(), 1);
+			built->jit = jit;
+			built->native = jit ? jit->find(decl->pid) : nullptr;
+			functions[decl->pid] = built;
+		}
 
-		// @TODO:
-		// :HandleUTF8
-		//
-		verify(isalnum(character) || ispunct(character) || isspace(character), current_location(), "Invalid character in character literal `%c`.", character);
+		for (AST_Function_Declaration *decl : declarations) {
+			function = functions[decl->pid];
+			function->body = try_(build(decl->body));
+		}
 
-		verify(next_char() == '\'', current_location(), "Expected a single-quote `'`' to terminate character literal.");
-		
-		return make_token(
-			Token_Kind::Literal_Character, 
-			Token_Data { 
-				.character = character 
-			}
-		);
+		Closure_Function *top_level = arena->make<Closure_Function>();
+		function = top_level;
+		top_level->body = try_(build(ast));
+		return top_level;
 	}
 
-	Token next_string_token() {
-		// @TODO:
-		// :HandleStringData
-		//
-		auto string = String { 0, source.chars };
+private:
+	Closure *make(Closure_Code code, AST *node, const Closure *a = nullptr, const Closure *b = nullptr, const Closure *c = nullptr) {
+		Closure *closure = arena->make<Closure>();
+		closure->code = code;
+		closure->a = a;
+		closure->b = b;
+		closure->c = c;
+		closure->location = node->location;
+		return closure;
+	}
 
-		char32_t c = next_char();
-		while (c != '\"' && c != '\0') {
-			string.size++;
-			c = next_char();
+	Result<const Closure *const *> build_all(const std::vector<AST *> &nodes) {
+		const Closure **children = reinterpret_cast<const Closure **>(arena->allocate(sizeof(Closure *) * std::max<size_t>(nodes.size(), 1), alignof(Closure *)));
+		for (size_t i = 0; i < nodes.size(); i++) {
+			children[i] = try_(build(nodes[i]));
 		}
+		return children;
+	}
 
-		return make_token(
-			Token_Kind::Literal_String, 
-			Token_Data { 
-				.string = string 
-			}
-		);
+	static Operand operand_kind(const Closure *operand) {
+		if (operand->code == Closure_Op::variable) return Operand::Variable;
+		if (operand->code == Closure_Op::constant) return Operand::Constant;
+		return Operand::Any;
 	}
 
-	Token next_number_token() {
-		bool is_floating_point = false;
+	template<template<typename, Operand, Operand> class Pick, typename T, Operand L>
+	static Closure_Code by_rhs(Operand rhs) {
+		switch (rhs) {
+			case Operand::Variable: return Pick<T, L, Operand::Variable>::code;
+			case Operand::Constant: return Pick<T, L, Operand::Constant>::code;
+			default:                return Pick<T, L, Operand::Any>::code;
+		}
+	}
 
-		// @TODO:
-		// :HandleUTF8
-		//
-		char *start = source.chars;
-		size_t size = 0;
+	template<template<typename, Operand, Operand> class Pick, typename T>
+	static Closure_Code by_operands(const Closure *lhs, const Closure *rhs) {
+		switch (operand_kind(lhs)) {
+			case Operand::Variable: return by_rhs<Pick, T, Operand::Variable>(operand_kind(rhs));
+			case Operand::Constant: return by_rhs<Pick, T, Operand::Constant>(operand_kind(rhs));
+			default:                return by_rhs<Pick, T, Operand::Any>(operand_kind(rhs));
+		}
+	}
 
-		while (isdigit(peek_char())) {
-			size++;
-			next_char();
+	template<template<typename, Operand, Operand> class Pick>
+	static Closure_Code by_numeric_type(Type_ID type, const Closure *lhs, const Closure *rhs) {
+		switch (type) {
+			case Type_Table::Integer8:  return by_operands<Pick, Runtime_Type::Integer8>(lhs, rhs);
+			case Type_Table::Integer16: return by_operands<Pick, Runtime_Type::Integer16>(lhs, rhs);
+			case Type_Table::Integer32: return by_operands<Pick, Runtime_Type::Integer32>(lhs, rhs);
+			case Type_Table::Integer64: return by_operands<Pick, Runtime_Type::Integer64>(lhs, rhs);
+			case Type_Table::Float32:   return by_operands<Pick, Runtime_Type::Floating_Point32>(lhs, rhs);
+			case Type_Table::Float64:   return by_operands<Pick, Runtime_Type::Floating_Point64>(lhs, rhs);
 		}
+		internal_error("`%s` isn't numeric!", type_table.debug_str(type).c_str());
+	}
 
-		if (peek_char() == '.' && isdigit(peek_char(1))) {
-			is_floating_point = true;
-			next_char();
-			size++;
+	template<typename T, Operand L, Operand R> struct Add      { static constexpr Closure_Code code = Closure_Op::arithmetic<T, std::plus<>, L, R>; };
+	template<typename T, Operand L, Operand R> struct Subtract { static constexpr Closure_Code code = Closure_Op::arithmetic<T, std::minus<>, L, R>; };
+	template<typename T, Operand L, Operand R> struct Multiply { static constexpr Closure_Code code = Closure_Op::arithmetic<T, std::multiplies<>, L, R>; };
+	template<typename T, Operand L, Operand R> struct Divide   { static constexpr Closure_Code code = Closure_Op::divide<T, L, R>; };
+	template<typename T, Operand L, Operand R> struct Equal    { static constexpr Closure_Code code = Closure_Op::compare<T, true, L, R>; };
+	template<typename T, Operand L, Operand R> struct Unequal  { static constexpr Closure_Code code = Closure_Op::compare<T, false, L, R>; };
 
-			while (isdigit(peek_char())) {
-				size++;
-				next_char();
-			}
+	// Booleans, characters and `null` all compare as `i64`s.
+	//
+	template<template<typename, Operand, Operand> class Pick>
+	static Closure_Code comparison(Type_ID type, const Closure *lhs, const Closure *rhs) {
+		switch (type) {
+			case Type_Table::Float32: return by_operands<Pick, Runtime_Type::Floating_Point32>(lhs, rhs);
+			case Type_Table::Float64: return by_operands<Pick, Runtime_Type::Floating_Point64>(lhs, rhs);
 		}
+		return by_operands<Pick, Runtime_Type::Integer64>(lhs, rhs);
+	}
+
+	Result<const Closure *> build(AST *node) {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier: {
+				AST_Symbol *symbol = ast_cast<AST_Symbol>(node);
 
-		char *word = reinterpret_cast<char *>(alloca(size));
-		memcpy(word, start, size);
+				// A function named on its own does nothing.
+				if (type_table[symbol->type].kind == Type_Kind::Function) return make(Closure_Op::nothing, node);
 
-		Token token;
+				Closure *closure = make(Closure_Op::variable, node);
+				closure->slot = symbol->slot;
+				return closure;
+			}
 
-		if (is_floating_point) {
-			double number = atof(word);
-			token = make_token(
-				Token_Kind::Literal_Floating_Point,
-				Token_Data {
-					.floating_point = number
+			case AST_Kind::Literal_Null:
+			case AST_Kind::Literal_Boolean:
+			case AST_Kind::Literal_Character:
+			case AST_Kind::Literal_Integer:
+			case AST_Kind::Literal_Floating_Point:
+			case AST_Kind::Literal_String: {
+				AST_Literal *literal = ast_cast<AST_Literal>(node);
+				Closure *closure = make(Closure_Op::constant, node);
+
+				switch (node->kind) {
+					case AST_Kind::Literal_Boolean:
+						closure->constant.integer = literal->as.boolean;
+						break;
+					case AST_Kind::Literal_Character:
+						closure->constant.integer = literal->as.character;
+						break;
+					case AST_Kind::Literal_Integer:
+						closure->constant.integer = literal->as.integer;
+						break;
+					case AST_Kind::Literal_Floating_Point:
+						if (node->type == Type_Table::Float32) {
+							closure->constant.f32 = static_cast<Runtime_Type::Floating_Point32>(literal->as.floating_point);
+						} else {
+							closure->constant.f64 = literal->as.floating_point;
+						}
+						break;
+					case AST_Kind::Literal_String:
+						strings->push_back({ static_cast<Runtime_Type::Integer64>(literal->as.string.size), literal->as.string.chars });
+						closure->constant.string = &strings->back();
+						break;
+					default:
+						break;
 				}
-			);
-		} else {
-			int64_t number = atoll(word);
-			token = make_token(
-				Token_Kind::Literal_Integer,
-				Token_Data { 
-					.integer = number
+
+				return closure;
+			}
+
+			case AST_Kind::Unary_Not: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+				return make(Closure_Op::logical_not, node, try_(build(unary->sub)));
+			}
+			case AST_Kind::Unary_Negate: {
+				AST_Unary *unary = ast_cast<AST_Unary>(node);
+				const Closure *sub = try_(build(unary->sub));
+
+				Closure_Code code = nullptr;
+				switch (node->type) {
+					case Type_Table::Integer8:  code = Closure_Op::negate<Runtime_Type::Integer8>;         break;
+					case Type_Table::Integer16: code = Closure_Op::negate<Runtime_Type::Integer16>;        break;
+					case Type_Table::Integer32: code = Closure_Op::negate<Runtime_Type::Integer32>;        break;
+					case Type_Table::Integer64: code = Closure_Op::negate<Runtime_Type::Integer64>;        break;
+					case Type_Table::Float32:   code = Closure_Op::negate<Runtime_Type::Floating_Point32>; break;
+					default:                    code = Closure_Op::negate<Runtime_Type::Floating_Point64>; break;
 				}
-			);
-		}
 
-		return token;
-	}
+				return make(code, node, sub);
+			}
 
-	Token next_keyword_or_identifier_token() {
-		auto word = String { 0, source.chars };
+			case AST_Kind::Binary_Assignment: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
 
-		while (is_identifier_character(peek_char())) {
-			word.size++;
-			next_char();
-		}
+				AST_Symbol *target = ast_cast_if<AST_Symbol>(binary->lhs);
+				verify(target, binary->lhs->location, "Can only assign to variables.");
 
-		Token token;
-		if (word == "null") {
-			token = make_token(Token_Kind::Literal_Null);
-		} else if (word == "true") {
-			token = make_token(
-				Token_Kind::Literal_Boolean,
-				Token_Data {
-					.boolean = true
-				}
-			);
-		} else if (word == "false") {
-			token = make_token(
-				Token_Kind::Literal_Boolean,
-				Token_Data {
-					.boolean = false
-				}
-			);
-		} else if (word == "if") {
-			token = make_token(Token_Kind::Keyword_If);
-		} else if (word == "else") {
-			token = make_token(Token_Kind::Keyword_Else);
-		} else if (word == "while") {
-			token = make_token(Token_Kind::Keyword_While);
-		} else if (word == "fn") {
-			token = make_token(Token_Kind::Keyword_Fn);
-		} else {
-			token = make_token(
-				Token_Kind::Symbol_Identifier,
-				Token_Data {
-					.string = word
+				Closure *closure = make(Closure_Op::store, node, try_(build(binary->rhs)));
+				closure->slot = target->slot;
+				return closure;
+			}
+			case AST_Kind::Binary_While: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				const Closure *condition = try_(build(binary->lhs));
+				return make(Closure_Op::while_, node, condition, try_(build(binary->rhs)));
+			}
+
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide:
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE:
+			case AST_Kind::Binary_And:
+			case AST_Kind::Binary_Or: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+
+				const Closure *lhs = try_(build(binary->lhs));
+				const Closure *rhs = try_(build(binary->rhs));
+				bool strings = binary->lhs->type == Type_Table::String;
+
+				Closure_Code code = nullptr;
+				switch (node->kind) {
+					case AST_Kind::Binary_Add:      code = by_numeric_type<Add>(node->type, lhs, rhs);      break;
+					case AST_Kind::Binary_Subtract: code = by_numeric_type<Subtract>(node->type, lhs, rhs); break;
+					case AST_Kind::Binary_Multiply: code = by_numeric_type<Multiply>(node->type, lhs, rhs); break;
+					case AST_Kind::Binary_Divide:   code = by_numeric_type<Divide>(node->type, lhs, rhs);   break;
+					case AST_Kind::Binary_And:      code = Closure_Op::logical_and;                         break;
+					case AST_Kind::Binary_Or:       code = Closure_Op::logical_or;                          break;
+					case AST_Kind::Binary_EQ:
+						code = strings ? Closure_Op::compare_strings<true> : comparison<Equal>(binary->lhs->type, lhs, rhs);
+						break;
+					default:
+						code = strings ? Closure_Op::compare_strings<false> : comparison<Unequal>(binary->lhs->type, lhs, rhs);
+						break;
 				}
-			);
-		}
 
-		return token;
-	}
+				return make(code, node, lhs, rhs);
+			}
 
-	Result<Token> next_punctuation_token(char32_t c) {
-		Token token;
+			case AST_Kind::Binary_Call: {
+				AST_Binary *call = ast_cast<AST_Binary>(node);
+				AST_Symbol *callee = ast_cast<AST_Symbol>(call->lhs);
+				AST_Block *arguments = ast_cast<AST_Block>(call->rhs);
 
-		switch (c) {
-			case ';': {
-				token = make_token(Token_Kind::Delimeter_Semicolon);
-			} break;
-			case ',': {
-				token = make_token(Token_Kind::Delimeter_Comma);
-			} break;
-			case '(': {
-				token = make_token(Token_Kind::Delimeter_Left_Parenthesis);
-			} break;
-			case ')': {
-				token = make_token(Token_Kind::Delimeter_Right_Parenthesis);
-			} break;
-			case '{': {
-				token = make_token(Token_Kind::Delimeter_Left_Curly);
-			} break;
-			case '}': {
-				token = make_token(Token_Kind::Delimeter_Right_Curly);
-			} break;
-			case '!': {
-				if (match_char('=')) {
-					token = make_token(Token_Kind::Punctuation_Bang_Equal);
-				} else {
-					token = make_token(Token_Kind::Punctuation_Bang);
-				}
-			} break;
-			case '=': {
-				if (match_char('=')) {
-					token = make_token(Token_Kind::Punctuation_Equal_Equal);
-				} else {
-					token = make_token(Token_Kind::Punctuation_Equal);
-				}
-			} break;
-			case ':': {
-				token = make_token(Token_Kind::Punctuation_Colon);
-			} break; 
-			case '+': {
-				token = make_token(Token_Kind::Punctuation_Plus);
-			} break;
-			case '-': {
-				if (match_char('>')) {
-					token = make_token(Token_Kind::Punctuation_Right_Thin_Arrow);
-				} else {
-					token = make_token(Token_Kind::Punctuation_Dash);
-				}
-			} break;
-			case '*': {
-				token = make_token(Token_Kind::Punctuation_Star);
-			} break;
-			case '/': {
-				token = make_token(Token_Kind::Punctuation_Slash);
-			} break;
-			case '&': {
-				if (match_char('&')) {
-					token = make_token(Token_Kind::Punctuation_Ampersand_Ampersand);
-				} else {
-					todo("Implement `&` tokenization.");
-				}
-			} break;
-			case '|': {
-				if (match_char('|')) {
-					token = make_token(Token_Kind::Punctuation_Pipe_Pipe);
-				} else {
-					todo("Implement `|` tokenization.");
-				}
-			} break;
+				auto it = functions.find(callee->pid);
+				internal_verify(it != functions.end(), "Call to a function that wasn't collected!");
+
+				Closure *closure = make(it->second->native ? Closure_Op::native_call : Closure_Op::call, node);
+				closure->function = it->second;
+				closure->children = try_(build_all(arguments->nodes));
+				closure->count = static_cast<uint32_t>(arguments->nodes.size());
+				return closure;
+			}
+
+			case AST_Kind::Block: {
+				AST_Block *block = ast_cast<AST_Block>(node);
+
+				Closure *closure = make(Closure_Op::block, node);
+				closure->children = try_(build_all(block->nodes));
+				closure->count = static_cast<uint32_t>(block->nodes.size());
+				return closure;
+			}
+
+			case AST_Kind::Variable_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+				function->frame_size = std::max<Size>(function->frame_size, inst->symbol->slot + Size { 1 });
+
+				Closure *closure = make(Closure_Op::store, node, try_(build(inst->initializer)));
+				closure->slot = inst->symbol->slot;
+				return closure;
+			}
+			case AST_Kind::Constant_Instantiation: {
+				// Functions are built on their own.
+				return make(Closure_Op::nothing, node);
+			}
+
+			case AST_Kind::If: {
+				AST_If *if_ = ast_cast<AST_If>(node);
+
+				const Closure *condition = try_(build(if_->condition));
+				const Closure *then_block = try_(build(if_->then_block));
+				const Closure *else_block = if_->else_block ? try_(build(if_->else_block)) : nullptr;
+				return make(Closure_Op::if_, node, condition, then_block, else_block);
+			}
 
 			default:
-				error(current_location(), "Unknown operator `%c`.", c);
+				internal_error("Unhandled AST_Kind: %s!", debug_str(node->kind).c_str());
 		}
-
-		return token;
 	}
 };
 
-struct Parser {
-	bool error;
-	Tokenizer tokenizer;
+// Runs `body` on a new thread with a `size` byte stack and waits for it to
+// finish. Returns 0, or the error that kept the thread from starting.
+//
+template<typename F>
+int run_with_stack(size_t size, F &&body) {
+	using Body = std::remove_reference_t<F>;
+
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstacksize(&attributes, size);
+
+	pthread_t thread;
+	int started = pthread_create(&thread, &attributes, [](void *argument) -> void * {
+		(*static_cast<Body *>(argument))();
+		return nullptr;
+	}, &body);
+	pthread_attr_destroy(&attributes);
+
+	if (started == 0) pthread_join(thread, nullptr);
+	return started;
+}
 
-	bool check(Token_Kind kind) {
-		// @NOTE: 
-		// Maybe `check()` and `match()` should return `Result<bool>`s or something
-		//
-		auto peeked = tokenizer.peek().unwrap();
-		return peeked.kind == kind;
+// Builds a closure tree for a typechecked program and evaluates it, then
+// prints each top-level variable's final value to `out`. There's nothing
+// to lower or optimize first, so short scripts start running immediately.
+// With `native` set, every function the JIT can handle is compiled to
+// machine code first and called there instead.
+//
+Result<void> evaluate_program(AST_Block *ast, FILE *out, bool native = false) {
+	Arena arena;
+	std::deque<Runtime_Type::String> strings;
+
+	Jit_Program jit;
+	if (native) {
+		X64_Compiler compiler { &jit };
+		try_(compiler.compile(ast));
 	}
 
-	bool skip_check(Token_Kind kind) {
-		skip_newlines();
-		return check(kind);
-	}
+	Closure_Builder builder { &arena, &strings, native ? &jit : nullptr };
+	Closure_Function *top_level = try_(builder.build_program(ast));
 
-	// @NOTE: See above!
+	Closure_Evaluator evaluator;
+	verify(top_level->frame_size <= Closure_Evaluator::Stack_Size, ast->location, "Stack overflow.");
+
+	Value *frame = evaluator.top;
+	evaluator.top += top_level->frame_size;
+
+	// A failure is raised into the evaluating thread's diagnostics, which
+	// go with it, so it's carried out as text.
 	//
-	bool match(Token_Kind kind) {
-		if (check(kind)) {
-			tokenizer.next().unwrap();
-			return true;
+	bool failed = false;
+	Code_Location failure_location = {};
+	std::string failure_message;
+
+	int started = run_with_stack(Closure_Evaluator::Native_Stack_Size, [&]() {
+		char base;
+		evaluator.native_limit = reinterpret_cast<const char *>(reinterpret_cast<uintptr_t>(&base) - (Closure_Evaluator::Native_Stack_Size - Closure_Evaluator::Native_Stack_Reserve));
+		(*top_level->body)(frame, &evaluator);
+
+		if (evaluator.failure) {
+			failed = true;
+			failure_location = evaluator.failure->location;
+			failure_message = evaluator.failure->message;
 		}
-		return false;
-	}
+	});
+	verify(started == 0, ast->location, "Couldn't start a thread to evaluate on: %s.", strerror(started));
+	verify(!failed, failure_location, "%s", failure_message.c_str());
 
-	bool skip_match(Token_Kind kind) {
-		skip_newlines();
-		return match(kind);
+	print_globals(out, ast, frame);
+	return {};
+}
+
+//
+//
+// Entry Point
+//
+//
+
+// Source text handed to the `Tokenizer`. Regular files are mapped read-only
+// so the tokenizer reads straight out of the page cache; anything that
+// can't be mapped (stdin, pipes, FIFOs) is lexed through a bounded
+// `Source_Stream` instead.
+//
+struct Source_Buffer {
+	File_ID file;
+	String text;
+	bool is_stream;
+	Source_Stream stream;
+
+	void free() {
+		source_files.forget_text(file);
+
+		if (is_stream) {
+			stream.close();
+		} else if (text.chars) {
+			munmap(text.chars, text.size);
+		}
+		text = String { 0, nullptr };
 	}
+};
 
-	Result<Token> expect(Token_Kind kind, const char *err, ...) {
-		va_list args;
-		va_start(args, err);
-		return expect(kind, err, args);
+// `-` names stdin.
+//
+Result<Source_Buffer> open_source_file(const char *path, size_t stream_capacity = Source_Stream::Default_Capacity) {
+	int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+	verify(fd >= 0, "'%s' could not be opened.", path);
+
+	struct stat info;
+	if (fstat(fd, &info) != 0) {
+		close(fd);
+		error("Could not stat '%s'.", path);
 	}
 
-	Result<Token> expect(Token_Kind kind, const char *err, va_list args) {
-		auto t = try_(tokenizer.next());
-		verify(t.kind == kind, t.location, err, args);
+	Source_Buffer source = {};
 
-		va_end(args);
-		return t;
+	if (!S_ISREG(info.st_mode)) {
+		source.file = source_files.add_stream(path);
+		source.is_stream = true;
+		source.stream.open(fd, source.file, stream_capacity);
+		return source;
 	}
 
-	Result<Token> skip_expect(Token_Kind kind, const char *err, ...) {
-		va_list args;
-		va_start(args, err);
-
-		skip_newlines();
-		return expect(kind, err, args);
+	size_t size = static_cast<size_t>(info.st_size);
+	if (size > std::numeric_limits<uint32_t>::max()) {
+		close(fd);
+		error("'%s' is larger than 4GB.", path);
 	}
 
-	Result<Token> expect_statement_terminator(const char *err, ...) {
-		va_list args;
-		va_start(args, err);
+	if (size > 0) {
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		verify(mapping != MAP_FAILED, "Could not map '%s'.", path);
 
-		auto t = try_(tokenizer.next());
-		verify(
-			t.kind == Token_Kind::Delimeter_Newline || t.kind == Token_Kind::Delimeter_Semicolon || t.kind == Token_Kind::Eof,
-			t.location, 
-			err, 
-			args
-		);
-		
-		va_end(args);
-		return t;
+		madvise(mapping, size, MADV_SEQUENTIAL);
+		source.text = String { size, reinterpret_cast<char *>(mapping) };
+	} else {
+		close(fd);
 	}
 
-	void skip_newlines() {
-		while (match(Token_Kind::Delimeter_Newline)) {}
+	source.file = source_files.add(path, source.text);
+	return source;
+}
+
+//
+//
+// Benchmarks
+//
+//
+
+// Builds roughly `size` bytes of plausible D# code: indented blocks,
+// comments, string literals and plenty of identifiers. With `mixed_script`
+// some identifiers and every string literal contain non-ASCII text.
+//
+std::string generate_benchmark_corpus(size_t size, bool mixed_script = false) {
+	std::string corpus;
+	corpus.reserve(size + 256);
+
+	const char *total = mixed_script ? "gesamtgröße_" : "total_value_";
+	const char *message = mixed_script ? "сообщение_" : "message_";
+	const char *text = mixed_script ? "日本語のテキスト and the quick brown fox " : "the quick brown fox jumps over the lazy dog ";
+
+	for (size_t i = 0; corpus.size() < size; i++) {
+		std::string n = std::to_string(i);
+
+		corpus += "// iteration " + n + " of the generated benchmark corpus\n";
+		corpus += "counter_" + n + " := " + n + "\n";
+		corpus += total + n + " := counter_" + n + " * 3 + 7\n";
+		corpus += "if counter_" + n + " == " + total + n + " && !false {\n";
+		corpus += std::string("\t") + message + n + " := \"" + text + n + "\"\n";
+		corpus += "} else {\n";
+		corpus += "\tcounter_" + n + " = counter_" + n + " - 1  // decrement\n";
+		corpus += "}\n";
+		corpus += "scale_" + n + " :: fn(value: i64, by: i64) -> i64 {\n";
+		corpus += "\tvalue * by + " + n + "\n";
+		corpus += "}\n";
+		corpus += "scaled_" + n + " := scale_" + n + "(counter_" + n + ", 3)\n";
+		corpus += "while counter_" + n + " != 0 {\n";
+		corpus += "\t\tcounter_" + n + " = counter_" + n + " - 1\n";
+		corpus += "}\n\n";
 	}
 
-	Result<AST *> parse_declaration() {
-		AST *node = nullptr;
-		
-		if (false) {
-			todo("This is where declaration parsing functions will go.");
+	return corpus;
+}
+
+// Walks `[p, end)` using only the scanner's bulk routines, classifying the
+// text into runs the same way the tokenizer does. Returns the run count so
+// the work can't be optimized away.
+//
+size_t scan_runs(const Scanner *s, const char *p, const char *end) {
+	size_t runs = 0;
+
+	while (p < end) {
+		if (is_horizontal_whitespace(*p)) {
+			p = s->skip_whitespace(p, end);
+		} else if (*p == '/' && p + 1 < end && p[1] == '/') {
+			p = s->find_newline(p, end);
+		} else if (*p == '\"') {
+			p = s->find_string_end(p + 1, end) + 1;
+		} else if (is_identifier_byte(*p)) {
+			p = s->skip_identifier(p, end);
 		} else {
-			node = try_(parse_statement());
+			p++;
 		}
+		runs++;
+	}
 
-		return node;
+	return runs;
+}
+
+template<typename F>
+double best_time_of(size_t iterations, F f) {
+	double best = std::numeric_limits<double>::max();
+
+	for (size_t i = 0; i < iterations; i++) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		auto end = std::chrono::steady_clock::now();
+
+		best = std::min(best, std::chrono::duration<double>(end - start).count());
 	}
 
-	Result<AST *> parse_statement() {
-		AST *node = nullptr;
+	return best;
+}
 
-		if (check(Token_Kind::Delimeter_Left_Curly)) {
-			node = try_(parse_block());
-		} else if (check(Token_Kind::Keyword_If)) {
-			node = try_(parse_if_statement());
-		} else if (check(Token_Kind::Keyword_While)) {
-			node = try_(parse_while_statement());
-		} else {
-			node = try_(parse_expression_or_assignment());
-			try_(expect_statement_terminator("Expected end of statement!"));
-		}
+// Compares every scanner this machine supports, both in isolation ("scan")
+// and driving the full tokenizer into a `Token_Buffer` ("tokenize"). The
+// scalar row is the baseline the vectorized paths are measured against.
+//
+void benchmark_tokenizer(size_t megabytes, bool mixed_script) {
+	std::string corpus = generate_benchmark_corpus(megabytes * 1024 * 1024, mixed_script);
+	double corpus_megabytes = corpus.size() / (1024.0 * 1024.0);
+	const size_t Iterations = 5;
+	File_ID file = source_files.add("<benchmark>", String { corpus.size(), corpus.data() });
+
+	printf("tokenizer benchmark: %.1f MB %s corpus, best of %zu runs\n", corpus_megabytes, mixed_script ? "mixed-script" : "ASCII", Iterations);
+	printf("  %-8s %14s %14s %14s\n", "scanner", "scan", "utf8", "tokenize");
+
+	const Scanner *selected = scanner;
+	for (const Scanner *candidate : available_scanners()) {
+		scanner = candidate;
+
+		size_t runs = 0;
+		double scan_time = best_time_of(Iterations, [&]() {
+			runs = scan_runs(candidate, corpus.data(), corpus.data() + corpus.size());
+		});
+
+		bool valid = false;
+		double utf8_time = best_time_of(Iterations, [&]() {
+			valid = is_valid_utf8(corpus.data(), corpus.data() + corpus.size());
+		});
+		internal_verify(valid, "Benchmark corpus isn't valid UTF-8!");
+
+		size_t token_count = 0;
+		double tokenize_time = best_time_of(Iterations, [&]() {
+			Tokenizer tokenizer;
+			tokenizer.file = file;
+			tokenizer.source = String { corpus.size(), corpus.data() };
+			tokenizer.origin = corpus.data();
+
+			Token_Buffer tokens;
+			tokenizer.tokenize_all(tokens).unwrap();
+			token_count = tokens.count();
+		});
+
+		printf("  %-8s %9.1f MB/s %9.1f MB/s %9.1f MB/s  (%zu runs, %zu tokens)\n",
+			candidate->name,
+			corpus_megabytes / scan_time,
+			corpus_megabytes / utf8_time,
+			corpus_megabytes / tokenize_time,
+			runs,
+			token_count
+		);
+	}
+	scanner = selected;
+}
 
-		return node;
+// Flattened, two trees are the same exactly when their arrays are,
+// locations included.
+//
+bool same_tree(const Flat_AST &a, const Flat_AST &b) {
+	if (a.count() != b.count() || a.root != b.root || a.types != b.types || a.children != b.children || a.strings != b.strings) return false;
+
+	for (size_t i = 0; i < a.count(); i++) {
+		if (a.nodes[i].kind != b.nodes[i].kind || memcmp(a.nodes[i].operands, b.nodes[i].operands, sizeof(a.nodes[i].operands)) != 0) return false;
+		if (a.locations[i].offset != b.locations[i].offset || a.locations[i].file != b.locations[i].file) return false;
 	}
+	return true;
+}
 
-	Result<AST_If *> parse_if_statement() {
-		auto location = try_(skip_expect(Token_Kind::Keyword_If, "Expected `if` statement!")).location;
-		skip_newlines();
-		
-		auto condition = try_(parse_expression());
+// Makes a run of small edits to a generated file, alternately making one
+// and taking it out again, and times reparsing after each against parsing
+// the whole file. Edits add whole declarations, add statements to function
+// bodies and `else` branches, and type into the middle of expressions and
+// `if` conditions. Every reparsed tree is checked against the full parse,
+// locations and all.
+//
+void benchmark_reparse(size_t megabytes) {
+	const size_t Edits = 40;
+
+	// Where each kind of edit goes: just past `skip` bytes of the next
+	// `anchor` at or after a random offset, or at a line start if there's
+	// no anchor.
+	struct Edit_Kind {
+		const char *anchor;
+		size_t skip;
+		const char *text;
+	};
 
-		auto then_block = try_(parse_block());
+	const Edit_Kind Kinds[] = {
+		{ nullptr,          0,  "probe := 1\n" },
+		{ ") -> i64 {\n",   11, "\tprobe := by\n" },
+		{ "\tvalue * by",   6,  " - 1" },
+		{ " && !false {",   0,  " || probe" },
+		{ "} else {\n",     9,  "\tprobe := 2\n" },
+	};
 
-		AST *else_block = nullptr;
-		if (skip_match(Token_Kind::Keyword_Else)) {
-			if (skip_check(Token_Kind::Keyword_If)) {
-				else_block = try_(parse_if_statement());
+	std::string text = generate_benchmark_corpus(megabytes * 1024 * 1024);
+	File_ID file = source_files.add("<reparse benchmark>", String { text.size(), text.data() });
+
+	Arena arena;
+	Incremental_Parse incremental;
+	incremental.arena = &arena;
+	incremental.file = file;
+	internal_verify(incremental.parse(String { text.size(), text.data() }), "Reparse benchmark corpus doesn't parse!");
+
+	uint64_t seed = 0x9E3779B97F4A7C15;
+	double reparse_time = 0;
+	double parse_time = 0;
+	Text_Edit last = {};
+
+	for (size_t i = 0; i < Edits; i++) {
+		const Edit_Kind &kind = Kinds[(i / 2) % (sizeof(Kinds) / sizeof(Kinds[0]))];
+		std::string inserted = kind.text;
+
+		Text_Edit edit;
+		if (i % 2 == 0) {
+			seed = seed * 6364136223846793005 + 1442695040888963407;
+			size_t offset = (seed >> 33) % text.size();
+
+			if (kind.anchor) {
+				size_t found = text.find(kind.anchor, offset);
+				if (found == std::string::npos) found = text.find(kind.anchor);
+				internal_verify(found != std::string::npos, "Reparse benchmark corpus has no `%s`!", kind.anchor);
+				offset = found + kind.skip;
 			} else {
-				else_block = try_(parse_block());
+				while (offset > 0 && text[offset - 1] != '\n') offset--;
 			}
+
+			edit = Text_Edit { static_cast<uint32_t>(offset), 0, String { inserted.size(), inserted.data() } };
+		} else {
+			edit = Text_Edit { last.offset, static_cast<uint32_t>(last.inserted.size), String {} };
 		}
 
-		AST_If *node = new AST_If;
-		node->kind = AST_Kind::If;
-		node->location = location;
-		node->condition = condition;
-		node->then_block = then_block;
-		node->else_block = else_block;
+		std::vector<Text_Edit> edits { edit };
+		std::string next = apply_edits(String { text.size(), text.data() }, edits);
+		String source = String { next.size(), next.data() };
 
-		return node;
+		auto start = std::chrono::steady_clock::now();
+		internal_verify(incremental.reparse(source, edits), "Reparse after edit %zu failed!", i);
+		reparse_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		Arena full_arena;
+		start = std::chrono::steady_clock::now();
+		AST_Block *full = parse(full_arena, source, file);
+		parse_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		internal_verify(full && same_tree(incremental.flatten(), flatten(full)), "Reparse after edit %zu doesn't match a full parse!", i);
+		full_arena.release();
+
+		text.swap(next);
+		last = edit;
 	}
 
-	Result<AST_Binary *> parse_while_statement() {
-		auto location = try_(skip_expect(Token_Kind::Keyword_While, "Expected `while` statement!")).location;
-		skip_newlines();
+	printf("reparse benchmark: %.1f MB corpus, %zu edits, every tree matches a full parse\n", text.size() / (1024.0 * 1024.0), Edits);
+	printf("  full parse %9.2f ms\n", 1000 * parse_time / Edits);
+	printf("  reparse    %9.2f ms\n", 1000 * reparse_time / Edits);
+	arena.release();
+}
 
-		auto condition = try_(parse_expression());
-		auto body = try_(parse_block());
+// Runs the same numeric kernels as bytecode, as a closure tree and as
+// native code, and checks they all agree. Compile time is included; it's
+// noise next to the kernels.
+//
+void benchmark_jit() {
+	static const char Kernels[] =
+		"sum :: fn(n: i64) -> i64 {\n"
+		"\ttotal := n - n\n"
+		"\ti := n - n\n"
+		"\twhile i != n {\n"
+		"\t\ttotal = total + i * 3\n"
+		"\t\ti = i + 1\n"
+		"\t}\n"
+		"\ttotal\n"
+		"}\n"
+		"fib :: fn(n: i64) -> i64 {\n"
+		"\tr := n\n"
+		"\tif n != 0 && n != 1 {\n"
+		"\t\tr = fib(n - 1) + fib(n - 2)\n"
+		"\t}\n"
+		"\tr\n"
+		"}\n"
+		"harmonic :: fn(n: f64) -> f64 {\n"
+		"\ttotal := n - n\n"
+		"\tk := n - n\n"
+		"\twhile k != n {\n"
+		"\t\tk = k + 1.0\n"
+		"\t\ttotal = total + 1.0 / k\n"
+		"\t}\n"
+		"\ttotal\n"
+		"}\n"
+		"s := sum(20000000)\n"
+		"f := fib(30)\n"
+		"h := harmonic(20000000.0)\n";
+	const size_t Iterations = 3;
+
+	File_ID file = source_files.add("<benchmark>", String { sizeof(Kernels) - 1, const_cast<char *>(Kernels) });
+	Arena arena;
+	AST_Block *ast = parse(arena, String { sizeof(Kernels) - 1, const_cast<char *>(Kernels) }, file);
+	internal_verify(ast, "Benchmark kernels don't parse!");
+	ast = typecheck(ast).unwrap();
+
+	printf("jit benchmark: sum, fib and harmonic kernels, best of %zu runs\n", Iterations);
+
+	struct Backend {
+		const char *name;
+		std::function<Result<void> (FILE *)> run;
+	};
 
-		AST_Binary *node = new AST_Binary;
-		node->kind = AST_Kind::Binary_While;
-		node->location = location;
-		node->lhs = condition;
-		node->rhs = body;
+	const Backend Backends[] = {
+		{ "bytecode", [ast](FILE *out) { return run_program(ast, out); } },
+		{ "closures", [ast](FILE *out) { return evaluate_program(ast, out); } },
+		{ "native",   [ast](FILE *out) { return evaluate_program(ast, out, true); } },
+	};
 
-		return node;
+	std::string expected;
+	double baseline = 0;
+	for (const Backend &backend : Backends) {
+		char *output = nullptr;
+		size_t output_size = 0;
+
+		double time = best_time_of(Iterations, [&]() {
+			::free(output);
+			FILE *out = open_memstream(&output, &output_size);
+			backend.run(out).unwrap();
+			fclose(out);
+		});
+
+		std::string result { output, output_size };
+		::free(output);
+
+		if (expected.empty()) expected = result;
+		internal_verify(result == expected, "`%s` disagrees with `%s`:\n%s", backend.name, Backends[0].name, result.c_str());
+
+		if (baseline == 0) baseline = time;
+		printf("  %-8s %9.3f s  %6.1fx\n", backend.name, time, baseline / time);
 	}
 
-	Result<AST *> parse_expression_or_assignment() {
-		return parse_precedence(Token_Precedence::Assignment);
+	printf("%s", expected.c_str());
+}
+
+//
+//
+// Parse Cache
+//
+//
+
+// XXH64. Hashing an input costs a small fraction of lexing it, which is the
+// whole point of caching on it.
+//
+uint64_t hash_bytes(const void *data, size_t size, uint64_t seed = 0) {
+	constexpr uint64_t P1 = 11400714785074694791ULL;
+	constexpr uint64_t P2 = 14029467366897019727ULL;
+	constexpr uint64_t P3 = 1609587929392839161ULL;
+	constexpr uint64_t P4 = 9650029242287828579ULL;
+	constexpr uint64_t P5 = 2870177450012600261ULL;
+
+	auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+	auto read64 = [](const unsigned char *p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; };
+	auto read32 = [](const unsigned char *p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; };
+	auto round = [&](uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; };
+	auto merge = [&](uint64_t acc, uint64_t v) { return (acc ^ round(0, v)) * P1 + P4; };
+
+	const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+	const unsigned char *end = p + size;
+	uint64_t h;
+
+	if (size >= 32) {
+		uint64_t v1 = seed + P1 + P2;
+		uint64_t v2 = seed + P2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - P1;
+
+		for (; end - p >= 32; p += 32) {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+		}
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge(h, v1);
+		h = merge(h, v2);
+		h = merge(h, v3);
+		h = merge(h, v4);
+	} else {
+		h = seed + P5;
 	}
 
-	Result<AST *> parse_expression() {
-		auto expression = try_(parse_expression_or_assignment());
+	h += size;
 
-		verify(expression->kind != AST_Kind::Binary_Assignment, expression->location, "Cannot assign in expression context.");
-		verify(expression->kind != AST_Kind::Variable_Instantiation, expression->location, "Cannot instantiate new variables in expression context.");
-		verify(expression->kind != AST_Kind::Constant_Instantiation, expression->location, "Cannot instantiate new constants in expression context.");
-		verify(expression->kind != AST_Kind::Binary_Variable_Declaration, expression->location, "Cannot declare new variables in expression context.");
-		
-		return expression;
+	for (; end - p >= 8; p += 8) {
+		h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+	}
+	if (end - p >= 4) {
+		h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h = rotl(h ^ (*p * P5), 11) * P1;
 	}
 
-	Result<AST *> parse_precedence(Token_Precedence precedence) {
-		Token token = try_(tokenizer.next());
-		verify(token.kind != Token_Kind::Eof, token.location, "Unexpected end of file!");
+	h ^= h >> 33;
+	h *= P2;
+	h ^= h >> 29;
+	h *= P3;
+	h ^= h >> 32;
+	return h;
+}
 
-		auto previous = try_(parse_prefix(token));
-		internal_verify(previous, "`parse_prefix()` returned null!");
+bool write_all(int fd, const void *data, size_t size) {
+	const char *p = reinterpret_cast<const char *>(data);
+	while (size > 0) {
+		ssize_t n = write(fd, p, size);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
 
-		while (precedence <= try_(tokenizer.peek()).precedence()) {
-			Token token = try_(tokenizer.next());
-			previous = try_(parse_infix(token, previous));
-			internal_verify(previous, "`parse_infix()` returned null!");
+// Bump this whenever the parser or the entry format changes what an entry
+// would hold. The build time is hashed in too, so a rebuilt compiler never
+// trusts entries another build wrote.
+//
+constexpr uint32_t Parse_Cache_Version = 2;
+constexpr const char *Compiler_Build = __DATE__ " " __TIME__;
+
+// An entry is this header followed by the node records, the node offsets,
+// the child indices, the length of each symbol name, the string literal
+// bytes and finally the symbol names. Symbol IDs are only good for one run,
+// so an entry's symbol nodes index its own list of names instead.
+//
+struct Parse_Cache_Header {
+	char magic[4];
+	uint32_t version;
+	uint64_t build;
+	uint64_t key;
+	uint32_t source_size;
+	uint32_t node_count;
+	uint32_t child_count;
+	uint32_t symbol_count;
+	uint32_t string_bytes;
+	uint32_t symbol_bytes;
+	AST_Index root;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(Parse_Cache_Header) == 56, "Parse cache header layout changed!");
+
+// Directory of parsed files keyed by a hash of their text, so unchanged
+// inputs skip lexing and parsing altogether. Entries are only ever written
+// whole (to a temporary, then renamed into place), so concurrent jobs and
+// concurrent builds can share a directory. Anything that looks off about an
+// entry makes it a miss rather than an error.
+//
+struct Parse_Cache {
+	std::string directory;
+	uint64_t build;
+
+	Result<void> open(const char *path) {
+		verify(mkdir(path, 0777) == 0 || errno == EEXIST, "Could not create cache directory '%s'.", path);
+
+		directory = path;
+		build = hash_bytes(Compiler_Build, strlen(Compiler_Build), Parse_Cache_Version);
+		return {};
+	}
+
+	uint64_t key(String source) const {
+		return hash_bytes(source.chars, source.size, build);
+	}
+
+	bool load(uint64_t key, String source, File_ID file, Flat_AST &flat) const {
+		int fd = ::open(entry_path(key).c_str(), O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Parse_Cache_Header)) {
+			close(fd);
+			return false;
 		}
 
-		return previous;
+		size_t size = static_cast<size_t>(info.st_size);
+		void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED) return false;
+
+		bool loaded = decode(reinterpret_cast<const char *>(mapping), size, key, source, file, flat);
+		munmap(mapping, size);
+		return loaded;
 	}
 
-	Result<AST *> parse_prefix(Token token) {
-		AST *node = nullptr;
+	void store(uint64_t key, String source, const Flat_AST &flat) const {
+		// Value-initialized so the padding in each record is zero and equal
+		// trees always make identical entries.
+		std::vector<Flat_AST::Node> nodes(flat.count());
+		std::vector<uint32_t> offsets(flat.count());
+		std::vector<uint32_t> symbol_sizes;
+		std::string symbol_names;
+		std::unordered_map<Symbol_ID, uint32_t> symbols;
+
+		for (size_t i = 0; i < flat.count(); i++) {
+			nodes[i].kind = flat.nodes[i].kind;
+			memcpy(nodes[i].operands, flat.nodes[i].operands, sizeof(nodes[i].operands));
+			offsets[i] = flat.locations[i].offset;
+
+			if (nodes[i].kind == AST_Kind::Symbol_Identifier) {
+				auto [it, added] = symbols.emplace(nodes[i].operands[0], static_cast<uint32_t>(symbols.size()));
+				if (added) {
+					String name = interner.get(it->first);
+					symbol_sizes.push_back(static_cast<uint32_t>(name.size));
+					symbol_names.append(name.chars, name.size);
+				}
+				nodes[i].operands[0] = it->second;
+			}
+		}
 
-		Code_Location location = token.location;
+		Parse_Cache_Header header = {};
+		memcpy(header.magic, "DSPC", 4);
+		header.version = Parse_Cache_Version;
+		header.build = build;
+		header.key = key;
+		header.source_size = static_cast<uint32_t>(source.size);
+		header.node_count = static_cast<uint32_t>(nodes.size());
+		header.child_count = static_cast<uint32_t>(flat.children.size());
+		header.symbol_count = static_cast<uint32_t>(symbol_sizes.size());
+		header.string_bytes = static_cast<uint32_t>(flat.strings.size());
+		header.symbol_bytes = static_cast<uint32_t>(symbol_names.size());
+		header.root = flat.root;
+
+		std::string temporary = directory + "/.entry-XXXXXX";
+		int fd = mkstemp(&temporary[0]);
+		if (fd < 0) return;
+
+		bool written = write_all(fd, &header, sizeof(header))
+			&& write_all(fd, nodes.data(), nodes.size() * sizeof(Flat_AST::Node))
+			&& write_all(fd, offsets.data(), offsets.size() * sizeof(uint32_t))
+			&& write_all(fd, flat.children.data(), flat.children.size() * sizeof(AST_Index))
+			&& write_all(fd, symbol_sizes.data(), symbol_sizes.size() * sizeof(uint32_t))
+			&& write_all(fd, flat.strings.data(), flat.strings.size())
+			&& write_all(fd, symbol_names.data(), symbol_names.size());
+
+		written &= close(fd) == 0;
+		if (!written || rename(temporary.c_str(), entry_path(key).c_str()) != 0) {
+			unlink(temporary.c_str());
+		}
+	}
 
-		switch (token.kind) {
-			case Token_Kind::Symbol_Identifier: {
-				AST_Symbol *identifier = new AST_Symbol;
-				identifier->kind = AST_Kind::Symbol_Identifier;
-				identifier->location = location;
+	void remove(uint64_t key) const {
+		unlink(entry_path(key).c_str());
+	}
 
-				// @TODO:
-				// :HandleStringData
-				//
-				identifier->symbol = token.data.string;
+private:
+	std::string entry_path(uint64_t key) const {
+		char name[32];
+		snprintf(name, sizeof(name), "/%016llx.ast", static_cast<unsigned long long>(key));
+		return directory + name;
+	}
 
-				node = identifier;
-			} break;
-			case Token_Kind::Literal_Null: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_Null;
-				literal->location = location;
+	template<typename T>
+	static const char *read_array(const char *p, size_t count, std::vector<T> &out) {
+		out.resize(count);
+		memcpy(out.data(), p, count * sizeof(T));
+		return p + count * sizeof(T);
+	}
+
+	static bool decode(const char *data, size_t size, uint64_t key, String source, File_ID file, Flat_AST &flat) {
+		Parse_Cache_Header header;
+		memcpy(&header, data, sizeof(header));
+
+		if (memcmp(header.magic, "DSPC", 4) != 0) return false;
+		if (header.version != Parse_Cache_Version) return false;
+		if (header.key != key || header.source_size != source.size) return false;
+
+		uint64_t expected = sizeof(header)
+			+ uint64_t(header.node_count) * (sizeof(Flat_AST::Node) + sizeof(uint32_t))
+			+ uint64_t(header.child_count) * sizeof(AST_Index)
+			+ uint64_t(header.symbol_count) * sizeof(uint32_t)
+			+ header.string_bytes
+			+ header.symbol_bytes;
+		if (expected != size) return false;
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> symbol_sizes;
+
+		const char *p = data + sizeof(header);
+		p = read_array(p, header.node_count, flat.nodes);
+		p = read_array(p, header.node_count, offsets);
+		p = read_array(p, header.child_count, flat.children);
+		p = read_array(p, header.symbol_count, symbol_sizes);
+		p = read_array(p, header.string_bytes, flat.strings);
+		flat.root = header.root;
+
+		std::vector<Symbol_ID> symbols;
+		symbols.reserve(header.symbol_count);
+
+		uint64_t names = 0;
+		for (uint32_t name_size : symbol_sizes) {
+			if (names + name_size > header.symbol_bytes) return false;
+			symbols.push_back(interner.intern(String { name_size, const_cast<char *>(p + names) }));
+			names += name_size;
+		}
+
+		if (!well_formed(flat, header.symbol_count)) return false;
+
+		flat.types.assign(flat.count(), Untyped);
+		flat.locations.resize(flat.count());
+		for (size_t i = 0; i < flat.count(); i++) {
+			flat.locations[i] = Code_Location { offsets[i], file };
+
+			Flat_AST::Node &node = flat.nodes[i];
+			if (node.kind == AST_Kind::Symbol_Identifier) {
+				node.operands[0] = symbols[node.operands[0]];
+			}
+		}
+
+		return true;
+	}
+
+	// Every reference has to point at an earlier node of a kind `unflatten`
+	// can cast it to, which also rules out cycles. The flattener always
+	// lays children down before their parents, so a real entry always passes.
+	//
+	static bool well_formed(const Flat_AST &flat, uint32_t symbol_count) {
+		auto is = [&](AST_Index index, AST_Index before) {
+			return index < before;
+		};
+		auto is_kind = [&](AST_Index index, AST_Index before, AST_Kind kind) {
+			return index < before && flat[index].kind == kind;
+		};
+		auto is_optional = [&](AST_Index index, AST_Index before) {
+			return index == AST_None || index < before;
+		};
+
+		for (AST_Index i = 0; i < flat.count(); i++) {
+			const Flat_AST::Node &node = flat[i];
+			const uint32_t *op = node.operands;
+
+			if (static_cast<size_t>(node.kind) >= AST_Kind_Count) return false;
+
+			switch (node.kind) {
+				case AST_Kind::Symbol_Identifier:
+					if (op[0] >= symbol_count) return false;
+					break;
+
+				case AST_Kind::Literal_String:
+					if (uint64_t(op[0]) + op[1] > flat.strings.size()) return false;
+					break;
+
+				case AST_Kind::Literal_Null:
+				case AST_Kind::Literal_Boolean:
+				case AST_Kind::Literal_Character:
+				case AST_Kind::Literal_Integer:
+				case AST_Kind::Literal_Floating_Point:
+					break;
+
+				case AST_Kind::Unary_Not:
+				case AST_Kind::Unary_Negate:
+					if (!is(op[0], i)) return false;
+					break;
+
+				case AST_Kind::Block:
+				case AST_Kind::Block_Comma: {
+					if (uint64_t(op[0]) + op[1] > flat.children.size()) return false;
+					Array<const AST_Index> children = flat.children_of(i);
+					for (size_t c = 0; c < children.count; c++) {
+						if (!is(children.elems[c], i)) return false;
+					}
+				} break;
+
+				case AST_Kind::Variable_Instantiation:
+				case AST_Kind::Constant_Instantiation:
+					if (!is_kind(op[0], i, AST_Kind::Symbol_Identifier) || op[1] != AST_None || !is(op[2], i)) return false;
+					break;
+
+				case AST_Kind::Function_Declaration:
+					if (!is_kind(op[0], i, AST_Kind::Block_Comma) || !is_optional(op[1], i) || !is_kind(op[2], i, AST_Kind::Block)) return false;
+					break;
+
+				case AST_Kind::If:
+					if (!is(op[0], i) || !is(op[1], i) || !is_optional(op[2], i)) return false;
+					break;
+
+				default: // binary
+					if (!is(op[0], i) || !is(op[1], i)) return false;
+					break;
+			}
+		}
+
+		return flat.root < flat.count() && flat[flat.root].kind == AST_Kind::Block;
+	}
+};
+
+// Parses a generated file, writes it to a scratch cache and loads it back,
+// timing the load against the parse. The loaded tree has to match the
+// parsed one exactly, or the cache would be changing what gets compiled.
+//
+void benchmark_parse_cache(size_t megabytes) {
+	std::string text = generate_benchmark_corpus(megabytes * 1024 * 1024);
+	String source = String { text.size(), text.data() };
+	File_ID file = source_files.add("<cache benchmark>", source);
+
+	char directory[] = "/tmp/dsharp-cache-XXXXXX";
+	internal_verify(mkdtemp(directory), "Could not create a scratch cache directory!");
+
+	Parse_Cache cache;
+	cache.open(directory).unwrap();
+
+	Arena arena;
+	auto start = std::chrono::steady_clock::now();
+	AST_Block *ast = parse(arena, source, file);
+	double parse_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	internal_verify(ast, "Cache benchmark corpus doesn't parse!");
+
+	Flat_AST parsed = flatten(ast);
+	uint64_t key = cache.key(source);
+	cache.store(key, source, parsed);
+
+	Flat_AST loaded;
+	Arena loaded_arena;
+	start = std::chrono::steady_clock::now();
+	bool hit = cache.load(key, source, file, loaded);
+	AST_Block *unflattened = hit ? ast_cast<AST_Block>(unflatten(loaded_arena, loaded, loaded.root)) : nullptr;
+	double load_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cache.remove(key);
+	rmdir(directory);
+
+	internal_verify(hit, "Cache benchmark entry was written but doesn't load!");
+	internal_verify(same_tree(parsed, flatten(unflattened)), "Cached tree doesn't match a fresh parse!");
+
+	printf("parse cache benchmark: %.1f MB corpus, cached tree matches a fresh parse\n", text.size() / (1024.0 * 1024.0));
+	printf("  parse      %9.2f ms\n", 1000 * parse_time);
+	printf("  load       %9.2f ms\n", 1000 * load_time);
+	loaded_arena.release();
+	arena.release();
+}
 
-				node = literal;
-			} break;
-			case Token_Kind::Literal_Boolean: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_Boolean;
-				literal->location = location;
-				literal->as.boolean = token.data.boolean;
+//
+//
+// C Backend
+//
+//
 
-				node = literal;
-			} break;
-			case Token_Kind::Literal_Character: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_Character;
-				literal->location = location;
-				literal->as.character = token.data.character;
+// Support code every emitted program starts with. Integer arithmetic goes
+// through these so it wraps at its width like the other backends instead
+// of being undefined, and integer division reports the same error.
+//
+constexpr const char *C_Prelude = R"(#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct { int64_t size; const char *chars; } ds_string;
+typedef uint8_t ds_null;
+
+static inline void ds_division_by_zero(const char *location) {
+	fprintf(stderr, "\033[31mError @ %s: Division by zero.\033[0m\n", location);
+	exit(1);
+}
 
-				node = literal;
-			} break;
-			case Token_Kind::Literal_Integer: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_Integer;
-				literal->location = location;
-				literal->as.integer = token.data.integer;
+#define DS_INTEGER(name, T, W) \
+	static inline T ds_add_##name(T a, T b) { return (T)(W)((W)a + (W)b); } \
+	static inline T ds_sub_##name(T a, T b) { return (T)(W)((W)a - (W)b); } \
+	static inline T ds_mul_##name(T a, T b) { return (T)(W)((W)a * (W)b); } \
+	static inline T ds_neg_##name(T a) { return (T)(W)(0 - (W)a); } \
+	static inline T ds_div_##name(T a, T b, const char *location) { \
+		if (b == 0) ds_division_by_zero(location); \
+		if (b == -1) return ds_neg_##name(a); \
+		return (T)(a / b); \
+	}
 
-				node = literal;
-			} break;
-			case Token_Kind::Literal_Floating_Point: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_Floating_Point;
-				literal->location = location;
-				literal->as.floating_point = token.data.floating_point;
+DS_INTEGER(i8, int8_t, uint32_t)
+DS_INTEGER(i16, int16_t, uint32_t)
+DS_INTEGER(i32, int32_t, uint32_t)
+DS_INTEGER(i64, int64_t, uint64_t)
 
-				node = literal;
-			} break;
-			case Token_Kind::Literal_String: {
-				AST_Literal *literal = new AST_Literal;
-				literal->kind = AST_Kind::Literal_String;
-				literal->location = location;
+static inline bool ds_string_equal(ds_string a, ds_string b) {
+	return a.size == b.size && memcmp(a.chars, b.chars, (size_t)a.size) == 0;
+}
 
-				// @TODO:
-				// :HandleStringData
-				//
-				literal->as.string = token.data.string;
+static inline void ds_print_char(uint32_t c) {
+	char utf8[5] = { 0 };
+	if (c < 0x80) {
+		utf8[0] = (char)c;
+	} else if (c < 0x800) {
+		utf8[0] = (char)(0xC0 | (c >> 6));
+		utf8[1] = (char)(0x80 | (c & 0x3F));
+	} else if (c < 0x10000) {
+		utf8[0] = (char)(0xE0 | (c >> 12));
+		utf8[1] = (char)(0x80 | ((c >> 6) & 0x3F));
+		utf8[2] = (char)(0x80 | (c & 0x3F));
+	} else {
+		utf8[0] = (char)(0xF0 | (c >> 18));
+		utf8[1] = (char)(0x80 | ((c >> 12) & 0x3F));
+		utf8[2] = (char)(0x80 | ((c >> 6) & 0x3F));
+		utf8[3] = (char)(0x80 | (c & 0x3F));
+	}
+	printf("'%s'", utf8);
+}
+)";
+
+// Lowers a typechecked program to one C translation unit. Functions are
+// hoisted to file scope, the top level becomes `main`, and `main` ends by
+// printing the top-level variables the way `--run` does. Variables are
+// named by their frame slot as well as their name, so shadowing never
+// needs C's scoping rules to line up with ours, and user names can't
+// collide with C keywords or the prelude.
+//
+// C leaves the order operands and arguments are evaluated in open. Nothing
+// here can tell the difference except which of two division-by-zero
+// errors in one expression gets reported.
+//
+struct C_Emitter {
+	std::string out;
+	std::unordered_map<PID, std::string> function_names;
+	size_t indentation = 0;
 
-				node = literal;
-			} break;
-			case Token_Kind::Punctuation_Bang:
-				node = try_(parse_unary(AST_Kind::Unary_Not, location));
-				break;
-			case Token_Kind::Punctuation_Dash:
-				if (check(Token_Kind::Literal_Integer)) {
-					Token literal_token = try_(tokenizer.next());
-					AST_Literal *literal = dynamic_cast<AST_Literal *>(try_(parse_prefix(literal_token)));
-					internal_verify(literal, "Failed to cast to `AST_Literal *`");
+	std::string emit_program(AST_Block *ast) {
+		std::vector<AST_Function_Declaration *> functions;
+		collect_functions(ast, functions);
 
-					literal->as.integer = -literal->as.integer;
-					literal->location = location;
+		std::unordered_map<AST_Function_Declaration *, Symbol_ID> names;
+		collect_function_names(ast, names);
 
-					node = literal;
-				} else if (check(Token_Kind::Literal_Floating_Point)) {
-					Token literal_token = try_(tokenizer.next());
-					AST_Literal *literal = dynamic_cast<AST_Literal *>(try_(parse_prefix(literal_token)));
-					internal_verify(literal, "Failed to cast to `AST_Literal *`");
+		std::unordered_set<AST_Function_Declaration *> top_level;
+		for (AST *node : ast->nodes) {
+			if (AST_Function_Declaration *decl = Typechecker::function_constant(node)) top_level.insert(decl);
+		}
 
-					literal->as.floating_point = -literal->as.floating_point;
-					literal->location = location;
+		for (size_t i = 0; i < functions.size(); i++) {
+			std::string name = interner.get(names[functions[i]]).str();
+			function_names[functions[i]->pid] = top_level.count(functions[i])
+				? "fn_" + name
+				: "fn" + std::to_string(i) + "_" + name;
+		}
 
-					node = literal;
-				} else {
-					node = try_(parse_unary(AST_Kind::Unary_Negate, location));
-				}
-				break;
-			
-			case Token_Kind::Keyword_Fn:
-				node = try_(parse_function(token));
-				break;
+		out += C_Prelude;
+		out += "\n";
 
-			default:
-				error(location, "`%s` is not a prefix operation!", token.display_str().c_str());
+		for (AST_Function_Declaration *decl : functions) {
+			emit_signature(decl);
+			out += ";\n";
 		}
 
-		return node;
-	}
+		for (AST_Function_Declaration *decl : functions) {
+			out += "\n";
+			emit_function(decl);
+		}
 
-	Result<AST *> parse_infix(Token token, AST *previous) {
-		AST *node = nullptr;
-		auto precedence = token.precedence();
-		auto location = token.location;
+		out += "\nint main(void) {\n";
+		indentation = 1;
+		for (AST *node : ast->nodes) {
+			emit_statement(node);
+		}
 
-		switch (token.kind) {
-			case Token_Kind::Punctuation_Colon:
-				node = try_(parse_colon(previous, location));
-				break;
-			case Token_Kind::Punctuation_Bang_Equal:
-				node = try_(parse_binary(AST_Kind::Binary_NE, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Equal_Equal:
-				node = try_(parse_binary(AST_Kind::Binary_EQ, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Equal:
-				node = try_(parse_binary(AST_Kind::Binary_Assignment, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Plus:
-				node = try_(parse_binary(AST_Kind::Binary_Add, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Dash:
-				node = try_(parse_binary(AST_Kind::Binary_Subtract, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Star:
-				node = try_(parse_binary(AST_Kind::Binary_Multiply, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Slash:
-				node = try_(parse_binary(AST_Kind::Binary_Divide, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Ampersand_Ampersand:
-				node = try_(parse_binary(AST_Kind::Binary_And, precedence, previous, location));
-				break;
-			case Token_Kind::Punctuation_Pipe_Pipe:
-				node = try_(parse_binary(AST_Kind::Binary_Or, precedence, previous, location));
-				break;
+		for (AST *node : ast->nodes) {
+			if (node->kind != AST_Kind::Variable_Instantiation) continue;
+			AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+
+			Type_ID type = inst->initializer->type;
+			std::string name = interner.get(inst->symbol->symbol).str();
+			std::string variable = variable_name(inst->symbol);
+
+			line("printf(\"%s: %s = \");", name.c_str(), type_table.display_str(type).c_str());
+			switch (type_table[type].kind) {
+				case Type_Kind::Null:           line("(void)%s; printf(\"null\");", variable.c_str()); break;
+				case Type_Kind::Boolean:        line("printf(\"%%s\", %s ? \"true\" : \"false\");", variable.c_str()); break;
+				case Type_Kind::Character:      line("ds_print_char(%s);", variable.c_str()); break;
+				case Type_Kind::Integer:        line("printf(\"%%lld\", (long long)%s);", variable.c_str()); break;
+				case Type_Kind::Floating_Point: line("printf(\"%%g\", (double)%s);", variable.c_str()); break;
+				case Type_Kind::String:         line("printf(\"\\\"%%.*s\\\"\", (int)%s.size, %s.chars);", variable.c_str(), variable.c_str()); break;
+				default: internal_error("Can't print a value of type `%s`!", type_table.debug_str(type).c_str());
+			}
+			line("printf(\"\\n\");");
+		}
 
-			default:
-				error(location, "`%s` is not an infix operation!", token.display_str().c_str());
+		line("return 0;");
+		out += "}\n";
+		return std::move(out);
+	}
+
+private:
+	static const char *c_type(Type_ID type) {
+		switch (type) {
+			case Type_Table::No_Type:   return "void";
+			case Type_Table::Null:      return "ds_null";
+			case Type_Table::Boolean:   return "bool";
+			case Type_Table::Character: return "uint32_t";
+			case Type_Table::String:    return "ds_string";
+			case Type_Table::Integer8:  return "int8_t";
+			case Type_Table::Integer16: return "int16_t";
+			case Type_Table::Integer32: return "int32_t";
+			case Type_Table::Integer64: return "int64_t";
+			case Type_Table::Float32:   return "float";
+			case Type_Table::Float64:   return "double";
 		}
+		internal_error("No C type for `%s`!", type_table.debug_str(type).c_str());
+	}
 
-		return node;
+	static const char *width_suffix(Type_ID type) {
+		switch (type) {
+			case Type_Table::Integer8:  return "i8";
+			case Type_Table::Integer16: return "i16";
+			case Type_Table::Integer32: return "i32";
+			case Type_Table::Integer64: return "i64";
+		}
+		internal_error("`%s` isn't an integer type!", type_table.debug_str(type).c_str());
 	}
 
-	Result<AST *> parse_unary(AST_Kind kind, Code_Location location) {
-		skip_newlines();
+	static std::string variable_name(AST_Symbol *symbol) {
+		return "v" + std::to_string(symbol->slot) + "_" + interner.get(symbol->symbol).str();
+	}
 
-		auto sub = try_(parse_precedence(Token_Precedence::Unary));
+	void line(const char *format, ...) {
+		out.append(indentation, '\t');
 
-		auto unary = new AST_Unary;
-		unary->kind = kind;
-		unary->location = location;
-		unary->sub = sub;
+		va_list args;
+		va_start(args, format);
+		char buffer[1024];
+		int size = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
 
-		return unary;
+		if (size >= static_cast<int>(sizeof(buffer))) {
+			std::string big(size + 1, '\0');
+			va_start(args, format);
+			vsnprintf(big.data(), big.size(), format, args);
+			va_end(args);
+			big.pop_back();
+			out += big;
+		} else {
+			out += buffer;
+		}
+		out += "\n";
 	}
 
-	Result<AST *> parse_binary(AST_Kind kind, Token_Precedence precedence, AST *lhs, Code_Location location) {
-		skip_newlines();
+	void emit_signature(AST_Function_Declaration *decl) {
+		const Type &type = type_table[decl->type];
 
-		auto rhs = try_(parse_precedence(precedence + 1));
+		out += "static ";
+		out += c_type(type.data.function.return_type);
+		out += " " + function_names[decl->pid] + "(";
 
-		auto binary = new AST_Binary;
-		binary->kind = kind;
-		binary->location = location;
-		binary->lhs = lhs;
-		binary->rhs = rhs;
+		if (decl->parameters->nodes.empty()) out += "void";
+		for (size_t i = 0; i < decl->parameters->nodes.size(); i++) {
+			AST_Symbol *name = ast_cast<AST_Symbol>(ast_cast<AST_Binary>(decl->parameters->nodes[i])->lhs);
+			if (i > 0) out += ", ";
+			out += c_type(name->type);
+			out += " " + variable_name(name);
+		}
 
-		return binary;
+		out += ")";
 	}
 
-	Result<AST_Block *> parse_block() {
-		auto location = try_(skip_expect(Token_Kind::Delimeter_Left_Curly, "Expected `{` to begin block!")).location;
+	void emit_function(AST_Function_Declaration *decl) {
+		emit_signature(decl);
+		out += " {\n";
+		indentation = 1;
 
-		auto block = new AST_Block;
-		block->kind = AST_Kind::Block;
+		const std::vector<AST *> &body = decl->body->nodes;
+		bool returns_value = type_table[decl->type].data.function.return_type != Type_Table::No_Type;
 
-		while (true) {
-			skip_newlines();
-			if (check(Token_Kind::Delimeter_Right_Curly) || check(Token_Kind::Eof)) break;
+		for (size_t i = 0; i < body.size(); i++) {
+			if (returns_value && i + 1 == body.size()) {
+				line("return %s;", expression(body[i]).c_str());
+			} else {
+				emit_statement(body[i]);
+			}
+		}
 
-			auto node = try_(parse_declaration());
-			block->nodes.push_back(node);
+		out += "}\n";
+	}
+
+	void emit_statement(AST *node) {
+		switch (node->kind) {
+			case AST_Kind::Variable_Instantiation: {
+				AST_Variable_Instantiation *inst = ast_cast<AST_Variable_Instantiation>(node);
+				line("%s %s = %s;", c_type(inst->initializer->type), variable_name(inst->symbol).c_str(), expression(inst->initializer).c_str());
+			} break;
+			case AST_Kind::Constant_Instantiation: {
+				// Hoisted to file scope.
+			} break;
+			case AST_Kind::Binary_Assignment: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				AST_Symbol *target = ast_cast<AST_Symbol>(binary->lhs);
+				line("%s = %s;", variable_name(target).c_str(), expression(binary->rhs).c_str());
+			} break;
+			case AST_Kind::Binary_While: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				line("while (%s) {", expression(binary->lhs).c_str());
+				emit_block_contents(binary->rhs);
+				line("}");
+			} break;
+			case AST_Kind::If: {
+				AST_If *if_ = ast_cast<AST_If>(node);
+				line("if (%s) {", expression(if_->condition).c_str());
+				emit_block_contents(if_->then_block);
+				if (if_->else_block) {
+					line("} else {");
+					emit_block_contents(if_->else_block);
+				}
+				line("}");
+			} break;
+			case AST_Kind::Block: {
+				line("{");
+				emit_block_contents(node);
+				line("}");
+			} break;
+			case AST_Kind::Symbol_Identifier: {
+				// A function named on its own does nothing, and a variable
+				// on its own would only make the C compiler complain.
+			} break;
+
+			default:
+				line("(void)%s;", expression(node).c_str());
+				break;
 		}
+	}
 
-		try_(skip_expect(Token_Kind::Delimeter_Right_Curly, "Expected `}` to terminate block!"));
-		block->location = location;
+	void emit_block_contents(AST *node) {
+		indentation++;
+		if (AST_Block *block = ast_cast_if<AST_Block>(node)) {
+			for (AST *child : block->nodes) emit_statement(child);
+		} else {
+			emit_statement(node);
+		}
+		indentation--;
+	}
 
-		return block;
+	static std::string quoted(String text) {
+		std::string s = "\"";
+		for (size_t i = 0; i < text.size; i++) {
+			unsigned char c = static_cast<unsigned char>(text.chars[i]);
+			if (c == '"' || c == '\\' || c == '?' || c < 0x20 || c >= 0x7F) {
+				char escape[5];
+				snprintf(escape, sizeof(escape), "\\%03o", c);
+				s += escape;
+			} else {
+				s += static_cast<char>(c);
+			}
+		}
+		return s + "\"";
 	}
 
-	Result<AST *> parse_colon(AST *previous, Code_Location location) {
-		AST *node = nullptr;
+	static std::string integer_literal(Type_ID type, int64_t value) {
+		if (value == std::numeric_limits<int64_t>::min()) return std::string { "((" } + c_type(type) + ")(-INT64_MAX - 1))";
+		return std::string { "((" } + c_type(type) + ")INT64_C(" + std::to_string(value) + "))";
+	}
 
-		if (match(Token_Kind::Punctuation_Equal)) {
-			auto initializer = try_(parse_expression());
+	std::string expression(AST *node) {
+		switch (node->kind) {
+			case AST_Kind::Symbol_Identifier:
+				return variable_name(ast_cast<AST_Symbol>(node));
+
+			case AST_Kind::Literal_Null:
+				return "((ds_null)0)";
+			case AST_Kind::Literal_Boolean:
+				return ast_cast<AST_Literal>(node)->as.boolean ? "true" : "false";
+			case AST_Kind::Literal_Character:
+				return "((uint32_t)" + std::to_string(static_cast<uint32_t>(ast_cast<AST_Literal>(node)->as.character)) + ")";
+			case AST_Kind::Literal_Integer:
+				return integer_literal(node->type, ast_cast<AST_Literal>(node)->as.integer);
+			case AST_Kind::Literal_Floating_Point: {
+				// Hexadecimal floats round-trip exactly.
+				char buffer[64];
+				snprintf(buffer, sizeof(buffer), "((%s)%a)", c_type(node->type), ast_cast<AST_Literal>(node)->as.floating_point);
+				return buffer;
+			}
+			case AST_Kind::Literal_String: {
+				String text = ast_cast<AST_Literal>(node)->as.string;
+				return "((ds_string){ " + std::to_string(text.size) + ", " + quoted(text) + " })";
+			}
 
-			AST_Variable_Instantiation *inst = new AST_Variable_Instantiation;
-			inst->kind = AST_Kind::Variable_Instantiation;
-			inst->location = location;
+			case AST_Kind::Unary_Not:
+				return "(!" + expression(ast_cast<AST_Unary>(node)->sub) + ")";
+			case AST_Kind::Unary_Negate: {
+				std::string sub = expression(ast_cast<AST_Unary>(node)->sub);
+				if (type_table[node->type].kind == Type_Kind::Floating_Point) return "(-" + sub + ")";
+				return std::string { "ds_neg_" } + width_suffix(node->type) + "(" + sub + ")";
+			}
 
-			AST_Symbol *symbol = dynamic_cast<AST_Symbol *>(previous);
-			verify(symbol, previous->location, "Expected a symbol on the left hand side of variable instantiation.");
-			inst->symbol = symbol;
+			case AST_Kind::Binary_Add:
+			case AST_Kind::Binary_Subtract:
+			case AST_Kind::Binary_Multiply:
+			case AST_Kind::Binary_Divide: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				std::string lhs = expression(binary->lhs);
+				std::string rhs = expression(binary->rhs);
+
+				const char *op = "+";
+				const char *helper = "add";
+				switch (node->kind) {
+					case AST_Kind::Binary_Subtract: op = "-"; helper = "sub"; break;
+					case AST_Kind::Binary_Multiply: op = "*"; helper = "mul"; break;
+					case AST_Kind::Binary_Divide:   op = "/"; helper = "div"; break;
+					default: break;
+				}
 
-			inst->initializer = initializer;
+				if (type_table[node->type].kind == Type_Kind::Floating_Point) {
+					return "(" + lhs + " " + op + " " + rhs + ")";
+				}
 
-			inst->specified_type_signature = nullptr;
+				std::string call = std::string { "ds_" } + helper + "_" + width_suffix(node->type) + "(" + lhs + ", " + rhs;
+				if (node->kind == AST_Kind::Binary_Divide) {
+					std::string location = node->location.debug_str();
+					call += ", " + quoted(String { location.size(), location.data() });
+				}
+				return call + ")";
+			}
 
-			node = inst;
-		} else if (match(Token_Kind::Punctuation_Colon)) {
-			auto initializer = try_(parse_expression());
+			case AST_Kind::Binary_EQ:
+			case AST_Kind::Binary_NE: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				bool equal = node->kind == AST_Kind::Binary_EQ;
+				std::string lhs = expression(binary->lhs);
+				std::string rhs = expression(binary->rhs);
 
-			AST_Variable_Instantiation *inst = new AST_Variable_Instantiation;
-			inst->kind = AST_Kind::Constant_Instantiation;
-			inst->location = location;
+				if (binary->lhs->type == Type_Table::String) {
+					return std::string { equal ? "" : "!" } + "ds_string_equal(" + lhs + ", " + rhs + ")";
+				}
+				return "(" + lhs + (equal ? " == " : " != ") + rhs + ")";
+			}
 
-			AST_Symbol *symbol = dynamic_cast<AST_Symbol *>(previous);
-			verify(symbol, previous->location, "Expected a symbol on the left hand side of constant declaration.");
-			inst->symbol = symbol;
+			case AST_Kind::Binary_And:
+			case AST_Kind::Binary_Or: {
+				AST_Binary *binary = ast_cast<AST_Binary>(node);
+				const char *op = node->kind == AST_Kind::Binary_And ? " && " : " || ";
+				return "(" + expression(binary->lhs) + op + expression(binary->rhs) + ")";
+			}
 
-			inst->initializer = initializer;
+			case AST_Kind::Binary_Call: {
+				AST_Binary *call = ast_cast<AST_Binary>(node);
+				AST_Symbol *callee = ast_cast<AST_Symbol>(call->lhs);
 
-			inst->specified_type_signature = nullptr;
+				std::string s = function_names[callee->pid] + "(";
+				const std::vector<AST *> &arguments = ast_cast<AST_Block>(call->rhs)->nodes;
+				for (size_t i = 0; i < arguments.size(); i++) {
+					if (i > 0) s += ", ";
+					s += expression(arguments[i]);
+				}
+				return s + ")";
+			}
 
-			node = inst;
-		} else {
-			todo("Variable declarations not yet implemented. previous.location = %s", tokenizer.current_location().debug_str().c_str());
+			default:
+				internal_error("Unhandled AST_Kind in a C expression: %s!", debug_str(node->kind).c_str());
 		}
+	}
+};
 
-		return node;
+// Compiles `c_path` into the executable `output` with the system C
+// compiler (`$CC`, or `cc`).
+//
+Result<void> compile_c(const std::string &c_path, const char *output) {
+	const char *cc = getenv("CC");
+	if (!cc || !*cc) cc = "cc";
+
+	pid_t child = fork();
+	verify(child >= 0, "Couldn't start `%s`: %s.", cc, strerror(errno));
+
+	if (child == 0) {
+		execlp(cc, cc, "-O2", "-o", output, c_path.c_str(), static_cast<char *>(nullptr));
+		fprintf(stderr, "Couldn't run `%s`: %s.\n", cc, strerror(errno));
+		_exit(127);
 	}
 
-	Result<AST *> parse_function(Token fn_token) {
-		try_(skip_expect(Token_Kind::Delimeter_Left_Parenthesis, "Expected `(` after `fn` keyword."));
+	int status = 0;
+	while (waitpid(child, &status, 0) < 0) {
+		verify(errno == EINTR, "Couldn't wait for `%s`: %s.", cc, strerror(errno));
+	}
+	verify(WIFEXITED(status) && WEXITSTATUS(status) == 0, "`%s` failed to compile '%s'.", cc, c_path.c_str());
+	return {};
+}
 
-		// @NOTE:
-		// @TODO:
-		// Should this be factored out into some sort of `parse_comma_separated_expressions()`?
-		//
-		AST_Block *parameters = new AST_Block;
-		parameters->kind = AST_Kind::Block_Comma;
-		parameters->location = tokenizer.current_location();
+// Writes the program as C to `out`, or with `output` set, to `output`.c
+// and then builds that into the executable `output`.
+//
+Result<void> emit_c(AST_Block *ast, FILE *out, const char *output) {
+	C_Emitter emitter;
+	std::string source = emitter.emit_program(ast);
 
-		do {
-			if (skip_check(Token_Kind::Delimeter_Right_Parenthesis)) break;
-			Token param_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected either `)` or parameter name."));
-			
-			Code_Location param_location = try_(skip_expect(Token_Kind::Punctuation_Colon, "Expected `:` after parameter name.")).location;
+	if (!output) {
+		fwrite(source.data(), 1, source.size(), out);
+		return {};
+	}
 
-			// @TODO:
-			// :ImplementParseTypeSignature
-			//
-			Token type_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected type name for parameter."));
+	std::string c_path = std::string { output } + ".c";
+	int fd = open(c_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	verify(fd >= 0, "Couldn't create '%s': %s.", c_path.c_str(), strerror(errno));
 
-			AST_Symbol *param_ident = new AST_Symbol;
-			param_ident->kind = AST_Kind::Symbol_Identifier;
-			param_ident->location = param_token.location;
-			// @TODO:
-			// :HandleStringData
-			//
-			param_ident->symbol = param_token.data.string;
+	bool written = write_all(fd, source.data(), source.size());
+	close(fd);
+	verify(written, "Couldn't write '%s': %s.", c_path.c_str(), strerror(errno));
 
-			AST_Symbol *type_ident = new AST_Symbol;
-			type_ident->kind = AST_Kind::Symbol_Identifier;
-			type_ident->location = type_token.location;
-			// @TODO:
-			// :HandleStringData
-			//
-			type_ident->symbol = type_token.data.string;
+	return compile_c(c_path, output);
+}
 
-			AST_Binary *param_node = new AST_Binary;
-			param_node->kind = AST_Kind::Binary_Variable_Declaration;
-			param_node->location = param_location;
-			param_node->lhs = param_ident;
-			param_node->rhs = type_ident;
+//
+//
+// Object Files
+//
+//
 
-			parameters->nodes.push_back(param_node);
-		} while (skip_match(Token_Kind::Delimeter_Comma) || check(Token_Kind::Eof));
+// Lays out `compiler`'s code as a relocatable x86-64 ELF object. Calls
+// between functions are already resolved, so the only relocations are the
+// references from `.text` into `.rodata`, against its section symbol.
+//
+std::string elf_object(const X64_Compiler &compiler, const std::string &source_name) {
+	enum : uint16_t { Null_Section, Text, Rodata, Rela_Text, Symtab, Strtab, Shstrtab, Note_Stack, Section_Count };
+
+	auto add_name = [](std::string &table, const std::string &name) {
+		uint32_t at = static_cast<uint32_t>(table.size());
+		table += name;
+		table += '\0';
+		return at;
+	};
 
-		try_(expect(Token_Kind::Delimeter_Right_Parenthesis, "Expected `)` to terminate parameter list."));
+	std::string strtab(1, '\0');
+	std::vector<Elf64_Sym> symbols(1);
 
-		AST *return_type = nullptr;
-		if (skip_match(Token_Kind::Punctuation_Right_Thin_Arrow)) {
-			// @TODO:
-			// :ImplementParseTypeSignature
-			//
-			Token type_token = try_(skip_expect(Token_Kind::Symbol_Identifier, "Expected type name for parameter."));
-			AST_Symbol *type_ident = new AST_Symbol;
-			type_ident->kind = AST_Kind::Symbol_Identifier;
-			type_ident->location = type_token.location;
-			// @TODO:
-			// :HandleStringData
-			//
-			type_ident->symbol = type_token.data.string;
+	Elf64_Sym file = {};
+	file.st_name = add_name(strtab, source_name);
+	file.st_info = ELF64_ST_INFO(STB_LOCAL, STT_FILE);
+	file.st_shndx = SHN_ABS;
+	symbols.push_back(file);
 
-			return_type = type_ident;
+	for (uint16_t section : { Text, Rodata }) {
+		Elf64_Sym symbol = {};
+		symbol.st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+		symbol.st_shndx = section;
+		symbols.push_back(symbol);
+	}
+	uint32_t rodata_symbol = static_cast<uint32_t>(symbols.size() - 1);
+
+	// Every local has to come before the first global.
+	uint32_t first_global = 0;
+	for (bool global : { false, true }) {
+		if (global) first_global = static_cast<uint32_t>(symbols.size());
+
+		for (const Native_Symbol &native : compiler.symbols) {
+			if (native.global != global) continue;
+
+			Elf64_Sym symbol = {};
+			symbol.st_name = add_name(strtab, native.name);
+			symbol.st_info = ELF64_ST_INFO(global ? STB_GLOBAL : STB_LOCAL, STT_FUNC);
+			symbol.st_shndx = Text;
+			symbol.st_value = native.offset;
+			symbol.st_size = native.size;
+			symbols.push_back(symbol);
 		}
+	}
 
-		AST_Block *body = try_(parse_block());
+	std::vector<Elf64_Rela> relocations;
+	for (auto [at, offset] : compiler.rodata_references) {
+		relocations.push_back({ at, ELF64_R_INFO(rodata_symbol, R_X86_64_PC32), static_cast<Elf64_Sxword>(offset) - 4 });
+	}
 
-		AST_Function_Declaration *decl = new AST_Function_Declaration;
-		decl->kind = AST_Kind::Function_Declaration;
-		decl->location = fn_token.location;
-		decl->parameters = parameters;
-		decl->return_type_signature = return_type;
-		decl->body = body;
+	std::string shstrtab(1, '\0');
+	Elf64_Shdr sections[Section_Count] = {};
 
-		return decl;
-	}
-};
+	std::string out(sizeof(Elf64_Ehdr), '\0');
+	auto add_section = [&](uint16_t index, const char *name, uint32_t type, uint64_t flags, const void *data, size_t size, uint64_t alignment, uint64_t entry_size = 0) {
+		out.resize((out.size() + alignment - 1) & ~(alignment - 1));
 
-AST_Block *parse(String source, const char *filename) {
-	Parser p;
-	p.error = false;
-	p.tokenizer.source = source;
-	p.tokenizer.filename = filename;
+		Elf64_Shdr &section = sections[index];
+		section.sh_name = add_name(shstrtab, name);
+		section.sh_type = type;
+		section.sh_flags = flags;
+		section.sh_offset = out.size();
+		section.sh_size = size;
+		section.sh_addralign = alignment;
+		section.sh_entsize = entry_size;
 
-	AST_Block *ast = new AST_Block;
-	ast->kind = AST_Kind::Block;
-	ast->location = p.tokenizer.current_location();
+		out.append(static_cast<const char *>(data), size);
+	};
 
-	while (true) {
-		p.skip_newlines();
-		if (p.check(Token_Kind::Eof)) break;
+	const std::vector<uint8_t> &code = compiler.x.code;
+	add_section(Text, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, code.data(), code.size(), 16);
+	add_section(Rodata, ".rodata", SHT_PROGBITS, SHF_ALLOC, compiler.rodata.data(), compiler.rodata.size(), 8);
+	add_section(Rela_Text, ".rela.text", SHT_RELA, SHF_INFO_LINK, relocations.data(), relocations.size() * sizeof(Elf64_Rela), 8, sizeof(Elf64_Rela));
+	add_section(Symtab, ".symtab", SHT_SYMTAB, 0, symbols.data(), symbols.size() * sizeof(Elf64_Sym), 8, sizeof(Elf64_Sym));
+	add_section(Strtab, ".strtab", SHT_STRTAB, 0, strtab.data(), strtab.size(), 1);
+	add_section(Note_Stack, ".note.GNU-stack", SHT_PROGBITS, 0, nullptr, 0, 1);
+
+	// Named last, since its own contents include every section's name.
+	uint32_t shstrtab_name = add_name(shstrtab, ".shstrtab");
+	add_section(Shstrtab, ".shstrtab", SHT_STRTAB, 0, shstrtab.data(), shstrtab.size(), 1);
+	sections[Shstrtab].sh_name = shstrtab_name;
+
+	sections[Rela_Text].sh_link = Symtab;
+	sections[Rela_Text].sh_info = Text;
+	sections[Symtab].sh_link = Strtab;
+	sections[Symtab].sh_info = first_global;
+
+	out.resize((out.size() + 7) & ~size_t { 7 });
+	size_t section_headers = out.size();
+	out.append(reinterpret_cast<const char *>(sections), sizeof(sections));
+
+	Elf64_Ehdr header = {};
+	memcpy(header.e_ident, ELFMAG, SELFMAG);
+	header.e_ident[EI_CLASS] = ELFCLASS64;
+	header.e_ident[EI_DATA] = ELFDATA2LSB;
+	header.e_ident[EI_VERSION] = EV_CURRENT;
+	header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+	header.e_type = ET_REL;
+	header.e_machine = EM_X86_64;
+	header.e_version = EV_CURRENT;
+	header.e_shoff = section_headers;
+	header.e_ehsize = sizeof(Elf64_Ehdr);
+	header.e_shentsize = sizeof(Elf64_Shdr);
+	header.e_shnum = Section_Count;
+	header.e_shstrndx = Shstrtab;
+	memcpy(&out[0], &header, sizeof(header));
+
+	return out;
+}
 
-		auto result = p.parse_declaration();
-		if (result.is_err()) {
-			p.error = true;
-			std::cerr << result.err();
-			continue;
-		}
+// Compiles the program at `path` to an x86-64 object file at `output`, or
+// next to it with a `.o` extension. Each top-level function gets a global
+// symbol and follows the System V ABI, so C can link against it; if the
+// top level runs anything, `_start` runs it, so the object also links on
+// its own with `ld`. With no libc to print with, that executable doesn't
+// print its variables, but a runtime error still prints and exits with 1.
+//
+Result<void> emit_object(AST_Block *ast, const char *path, const char *output) {
+	X64_Compiler compiler { nullptr, Native_Target::Object };
+	try_(compiler.compile_object(ast));
 
-		ast->nodes.push_back(result.ok());
+	std::string object_path;
+	if (output) {
+		object_path = output;
+	} else {
+		std::string_view source = path;
+		if (source.size() > 3 && source.substr(source.size() - 3) == ".ds") source.remove_suffix(3);
+		object_path = std::string { source } + ".o";
 	}
 
-	return p.error ? nullptr : ast;
+	const char *slash = strrchr(path, '/');
+	std::string object = elf_object(compiler, slash ? slash + 1 : path);
+
+	int fd = open(object_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	verify(fd >= 0, "Couldn't create '%s': %s.", object_path.c_str(), strerror(errno));
+
+	bool written = write_all(fd, object.data(), object.size());
+	close(fd);
+	verify(written, "Couldn't write '%s': %s.", object_path.c_str(), strerror(errno));
+	return {};
 }
 
 //
 //
-// Typechecking
+// Driver
 //
 //
 
-struct Typechecker {
-	//
-	// Child Data Structures
-	//
-	struct Binding {
-		enum {
-			Variable,
-			Type,
-			Function,
-			Module,
-		} kind;
+struct Compile_Options {
+	bool print_stats = false;
+	bool pretokenize = true;
+	bool flat_ast = false;
+	bool run = false;
+	bool evaluate = false;
+	bool jit = false;
+	bool emit_c = false;
+	bool emit_object = false;
+	const char *output = nullptr; // where `emit_c` builds an executable, or `emit_object` writes
+	size_t stream_capacity = Source_Stream::Default_Capacity;
+	Thread_Pool *pool = nullptr;
+	const Parse_Cache *cache = nullptr;
+};
 
-		struct Function_Binding {
-			PID pid;
-			::Type type;
-		};
+// Parses and typechecks `path`, writing the AST dumps to `out` and any
+// diagnostics or stats to `errors`. With `run`, `evaluate` or `jit` set,
+// the program is run instead (as bytecode, as a closure tree, or as a
+// closure tree calling native code) and `out` gets its top-level
+// variables. With `emit_c` set, `out` gets the program as C instead,
+// unless `output` says where to build it. With `emit_object` set, it's
+// compiled to an object file. Returns whether it compiled (and ran).
+//
+bool compile_file(const char *path, const Compile_Options &options, FILE *out, FILE *errors) {
+	auto opened = open_source_file(path, options.stream_capacity);
+	if (opened.is_err()) {
+		opened.err()->print(errors);
+		return false;
+	}
+	Source_Buffer source = opened.take();
 
-		union {
-			::Type ty;
-			Function_Binding fn;
-			// ::Module *mod;
-		};
+	Arena ast_arena;
+	AST_Block *ast = nullptr;
 
-		static Binding variable(::Type type) {
-			Binding b;
-			b.kind = Variable;
-			b.ty = type;
-			return b;
+	// Holds the string literals of a tree loaded from the cache.
+	Flat_AST cached;
+
+	if (options.cache && !source.is_stream) {
+		uint64_t key = options.cache->key(source.text);
+		bool hit = options.cache->load(key, source.text, source.file, cached);
+
+		if (hit) {
+			ast = ast_cast<AST_Block>(unflatten(ast_arena, cached, cached.root));
+		} else {
+			ast = parse(ast_arena, source.text, source.file, options.pretokenize, errors);
+			if (ast) options.cache->store(key, source.text, flatten(ast));
 		}
 
-		static Binding type(::Type type) {
-			Binding b;
-			b.kind = Type;
-			b.ty = type;
-			return b;
+		if (options.print_stats) {
+			fprintf(errors, "parse cache: %s\n", hit ? "hit" : "miss");
 		}
+	} else {
+		ast = source.is_stream
+			? parse(ast_arena, source.stream, errors)
+			: parse(ast_arena, source.text, source.file, options.pretokenize, errors);
+	}
 
-		static Binding function(PID pid, ::Type fn_type) {
-			Binding b;
-			b.kind = Function;
-			b.fn.pid = pid;
-			b.fn.type = fn_type;
-			return b;
+	bool compiled = ast != nullptr;
+	if (ast && options.emit_c) {
+		auto typed = typecheck(ast, options.pool);
+		auto emitted = typed.is_err() ? Result<void> { Failure { typed.err() } } : emit_c(typed.take(), out, options.output);
+		if (emitted.is_err()) {
+			emitted.err()->print(errors, path);
+			compiled = false;
+		}
+	} else if (ast && options.emit_object) {
+		auto typed = typecheck(ast, options.pool);
+		auto emitted = typed.is_err() ? Result<void> { Failure { typed.err() } } : emit_object(typed.take(), path, options.output);
+		if (emitted.is_err()) {
+			emitted.err()->print(errors, path);
+			compiled = false;
+		}
+	} else if (ast && (options.run || options.evaluate || options.jit)) {
+		auto typed = typecheck(ast, options.pool);
+		auto ran = typed.is_err() ? Result<void> { Failure { typed.err() } }
+			: options.evaluate || options.jit ? evaluate_program(typed.take(), out, options.jit)
+			: run_program(typed.take(), out);
+		if (ran.is_err()) {
+			ran.err()->print(errors, path);
+			compiled = false;
+		}
+	} else if (ast && options.flat_ast) {
+		// Round-trip through the flat form so both directions get exercised.
+		Flat_AST flat = flatten(ast);
+		flat.debug_print(out);
+
+		ast = ast_cast<AST_Block>(unflatten(ast_arena, flat, flat.root));
+		auto typed = typecheck(ast, options.pool);
+		if (typed.is_ok()) {
+			flat = flatten(typed.take());
+			flat.debug_print(out);
+		} else {
+			typed.err()->print(errors, path);
+			compiled = false;
 		}
 
-		/* @TODO:
-			for when we implement modules
-		static Binding module(::Module *module) {
-			return Binding {
-				.kind = Module,
-				.mod = module
-			};
+		if (options.print_stats) {
+			flat.print_stats(errors, "flat ast");
 		}
-		*/
-	};
+	} else if (ast) {
+		ast->debug_print(out);
 
-	struct Scope {
-		std::unordered_map<std::string, Binding> bindings;
-	};
+		auto typed = typecheck(ast, options.pool);
+		if (typed.is_ok()) {
+			typed.take()->debug_print(out);
+		} else {
+			typed.err()->print(errors, path);
+			compiled = false;
+		}
+	}
 
-	//
-	// Fields
-	//
-	// Interpreter *interp;
-	// Module *module;
-	Scope *global_scope;
-	// Function_Definition *function;
-	Typechecker *parent;
-	// bool has_return;
-	std::forward_list<Scope> scopes;
+	if (options.print_stats) {
+		ast_arena.print_stats(errors, "ast arena");
+	}
 
-	//
-	// Constructor B.S
-	//
-	Typechecker() = default;
+	ast_arena.release();
+	source.free();
+	return compiled;
+}
 
-	/*
-	Typechecker(Interpreter *interp, Module *module) {
-		this->interp = interp;
-		this->module = module;
-		this->function = nullptr;
-		this->parent = nullptr;
-		this->has_return = false;
-		begin_scope(); // global scope
-		global_scope = &current_scope();
-	}
-	*/
+// One input of a batch. Its output is buffered and only written once every
+// input before it has been, so what a build prints never depends on how
+// the jobs were scheduled. Each stream it writes to starts with a header
+// naming the input, so output and errors can be told apart by file.
+//
+struct Compile_Job {
+	std::string path;
+	Task_Group done;
+	bool compiled = false;
+	bool unbuffered = false; // a lone input can write straight out
+
+	char *output = nullptr;
+	size_t output_size = 0;
+	char *errors = nullptr;
+	size_t errors_size = 0;
+
+	void run(const Compile_Options &options) {
+		if (unbuffered) {
+			compiled = compile_file(path.c_str(), options, stdout, stderr);
+			return;
+		}
 
-	/*
-	Typechecker(Typer &t, Function_Definition *function) {
-		this->interp = t.interp;
-		this->module = t.module;
-		this->global_scope = t.global_scope;
-		this->function = function;
-		this->parent = &t;
-		this->has_return = false;
-	}
-	*/
+		FILE *out = open_memstream(&output, &output_size);
+		FILE *err = open_memstream(&errors, &errors_size);
+		internal_verify(out && err, "Could not buffer output for '%s'!", path.c_str());
+
+		compiled = compile_file(path.c_str(), options, out, err);
 
-	Scope &current_scope() {
-		internal_verify(!scopes.empty(), "No scopes in `scopes` field of Typechecker!");
-		return scopes.front();
+		fclose(out);
+		fclose(err);
 	}
 
-	void begin_scope() {
-		scopes.push_front(Scope{});
+	void flush() {
+		if (unbuffered) return;
+
+		if (output_size > 0) {
+			fprintf(stdout, "==> %s <==\n", path.c_str());
+			fwrite(output, 1, output_size, stdout);
+			fflush(stdout);
+		}
+		if (errors_size > 0) {
+			fprintf(stderr, "==> %s <==\n", path.c_str());
+			fwrite(errors, 1, errors_size, stderr);
+		}
+
+		::free(output);
+		::free(errors);
+		output = nullptr;
+		errors = nullptr;
 	}
+};
 
-	void end_scope() {
-		internal_verify(!scopes.empty(), "No sopes in `scopes` field of Typechecker to pop!");
-		scopes.pop_front();
+bool has_extension(const std::string &path, const char *extension) {
+	size_t size = strlen(extension);
+	return path.size() > size && path.compare(path.size() - size, size, extension) == 0;
+}
+
+// Every `.ds` file under `directory`, recursively, in a stable order.
+//
+Result<void> collect_directory(const std::string &directory, std::vector<std::string> &inputs) {
+	DIR *dir = opendir(directory.c_str());
+	verify(dir, "Could not read directory '%s'.", directory.c_str());
+
+	std::vector<std::string> entries;
+	while (struct dirent *entry = readdir(dir)) {
+		if (entry->d_name[0] == '.') continue;
+		entries.push_back(directory + "/" + entry->d_name);
 	}
+	closedir(dir);
 
-	std::optional<Binding> find_binding_by_id(const std::string &id, bool checking_through_parent = false) {
-		for (Scope &scope : scopes) {
-			auto it = scope.bindings.find(id);
-			if (it == scope.bindings.end()) continue;
-			if (checking_through_parent && it->second.kind == Binding::Variable) continue;
-			return it->second;
-		}
+	std::sort(entries.begin(), entries.end());
 
-		if (parent) {
-			auto optional_binding = parent->find_binding_by_id(id, true);
-			if (optional_binding.has_value()) {
-				return *optional_binding;
-			}
-		}
+	for (const std::string &entry : entries) {
+		struct stat info;
+		if (stat(entry.c_str(), &info) != 0) continue;
 
-		if (!checking_through_parent) {
-			auto it = global_scope->bindings.find(id);
-			if (it != global_scope->bindings.end()) {
-				return it->second;
-			}
+		if (S_ISDIR(info.st_mode)) {
+			try_(collect_directory(entry, inputs));
+		} else if (S_ISREG(info.st_mode) && has_extension(entry, ".ds")) {
+			inputs.push_back(entry);
 		}
-
-		return {};
 	}
 
-	Result<void> put_binding(Code_Location location, const std::string &id, Binding binding) {
-		Scope &scope = current_scope();
+	return {};
+}
 
-		auto it = scope.bindings.find(id);
-		verify(it == scope.bindings.end(), location, "Redefinition of `%s`", id.c_str());
+// Expands one command line input: `@file` reads further inputs from `file`,
+// one per line (blank lines and lines starting with `#` are skipped), and a
+// directory contributes every `.ds` file beneath it.
+//
+Result<void> collect_inputs(const char *arg, std::vector<std::string> &inputs, size_t depth = 0) {
+	if (arg[0] == '@') {
+		verify(depth < 16, "Response files nested too deeply at '%s'.", arg + 1);
 
-		scope.bindings[id] = binding;
+		FILE *file = fopen(arg + 1, "r");
+		verify(file, "Response file '%s' could not be opened.", arg + 1);
 
-		return {};
+		char *line = nullptr;
+		size_t capacity = 0;
+		ssize_t length;
+		Result<void> result;
+		while (result.is_ok() && (length = getline(&line, &capacity, file)) >= 0) {
+			while (length > 0 && isspace(static_cast<unsigned char>(line[length - 1]))) line[--length] = '\0';
+
+			char *start = line;
+			while (isspace(static_cast<unsigned char>(*start))) start++;
+			if (*start == '\0' || *start == '#') continue;
+
+			result = collect_inputs(start, inputs, depth + 1);
+		}
+
+		::free(line);
+		fclose(file);
+		return result;
 	}
 
-	Result<void> bind_variable(Code_Location location, const std::string &id, Type type) {
-		return put_binding(location, id, Binding::variable(type));
+	struct stat info;
+	if (strcmp(arg, "-") != 0 && stat(arg, &info) == 0 && S_ISDIR(info.st_mode)) {
+		std::string directory = arg;
+		while (directory.size() > 1 && directory.back() == '/') directory.pop_back();
+		return collect_directory(directory, inputs);
 	}
 
-	// Result<void> bind_type(Code_Location location, const std::string &id, Type type) {
-	// 	internal_verify(type.kind == Type_Kind::Type, "Attempted to bind a type name to something other than a type! `%s` to `%s`", id.c_str(), type.debug_str().c_str());
-	// 	return put_binding(location, id, Binding::type(type));
-	// }
+	inputs.push_back(arg);
+	return {};
+}
 
-	// Result<void> bind_function(Code_Location location, const std::string &id, PID pid, Type type) {
-	// 	internal_verify(type.kind == Type_Kind::Function, "Attempted to bind a function name to something other than a function-type! `%s` to `%s`", id.c_str(), type.debug_str().c_str());
-	// 	return put_binding(location, id, Binding::function(pid, type));
-	// }
+//
+//
+// Compile Server
+//
+//
 
-	/*
-	Result<void> bind_module(Code_Location location, const std::string &id, Module *module) {
-		return put_binding(location, id, Binding::module(module));
+// Everything the server keeps about one input between requests. The file is
+// only read again once its identity on disk changes, and then only the span
+// that differs from the last version is reparsed.
+//
+struct Server_File {
+	std::string path;
+	File_ID file;
+	struct stat identity = {};
+	bool loaded = false;
+	uint64_t last_request = 0; // which request last asked for it
+
+	std::vector<char> text;
+	Arena parse_arena;
+	Incremental_Parse parse;
+	size_t parsed_bytes = 0; // `parse_arena` use after the last full parse
+
+	// Typechecking rewrites the tree it's given, so it gets a copy and the
+	// incremental tree stays as the parser left it.
+	//
+	Arena typed_arena;
+	Flat_AST snapshot;
+	AST_Block *typed = nullptr;
+
+	bool compiled = false;
+	std::string diagnostics;
+
+	bool unchanged(const struct stat &info) const {
+		return loaded
+			&& info.st_dev == identity.st_dev
+			&& info.st_ino == identity.st_ino
+			&& info.st_size == identity.st_size
+			&& info.st_mtim.tv_sec == identity.st_mtim.tv_sec
+			&& info.st_mtim.tv_nsec == identity.st_mtim.tv_nsec;
 	}
-	*/
 
-	Result<AST *> typecheck(AST *node) {
-		AST *typechecked_node = nullptr;
+	// Brings the file up to date. Returns false when nothing had to be done.
+	//
+	bool check(Thread_Pool *pool) {
+		struct stat info;
+		std::vector<char> next;
+
+		auto read = read_text(info, next);
+		if (read.is_err()) {
+			loaded = false;
+			compiled = false;
+			diagnostics = describe(read.err());
+			return true;
+		}
 
-		switch (node->kind) {
-			case AST_Kind::Symbol_Identifier: {
-				AST_Symbol *symbol = dynamic_cast<AST_Symbol *>(node);
-				internal_verify(symbol, "Failed to cast to `AST_Symbol *`");
+		if (!read.take()) return false;
 
-				auto opt_binding = find_binding_by_id(symbol->symbol.str());
-				verify(opt_binding.has_value(), "Unresolved identifier `%.*s`!", symbol->symbol.size, symbol->symbol.chars);
-				Binding binding = *opt_binding;
+		identity = info;
+		if (loaded && next == text) return false;
 
-				if (binding.kind != Binding::Variable) {
-					todo("Implement non-variable binding typechecking!");
-				}
+		char *buffer = nullptr;
+		size_t size = 0;
+		FILE *errors = open_memstream(&buffer, &size);
+		internal_verify(errors, "Could not buffer diagnostics for '%s'!", path.c_str());
 
-				symbol->type = binding.ty;
-				typechecked_node = symbol;
-			} break;
+		// Replaced declarations pile up in `parse_arena`, so every so often
+		// it's started afresh with a full parse.
+		//
+		String source = String { next.size(), next.data() };
+		if (loaded && parse.ast && parse_arena.bytes_used <= 4 * parsed_bytes) {
+			std::vector<Text_Edit> edits { difference(source) };
+			compiled = parse.reparse(source, edits, errors);
+		} else {
+			parse_arena.release();
+			compiled = parse.parse(source, errors);
+			parsed_bytes = parse_arena.bytes_used;
+		}
 
-			case AST_Kind::Literal_Null: {
-				node->type = Type { Type_Kind::Null };
-				typechecked_node = node;
-			} break;
-			case AST_Kind::Literal_Boolean: {
-				node->type = Type::Boolean();
-				typechecked_node = node;
-			} break;
-			case AST_Kind::Literal_Character: {
-				node->type = Type::Character();
-				typechecked_node = node;
-			} break;
-			case AST_Kind::Literal_Integer: {
-				AST_Literal *literal = dynamic_cast<AST_Literal *>(node);
-				internal_verify(literal, "Failed to cast to `AST_Literal *`");
+		text.swap(next);
+		loaded = true;
 
-				Size literal_size = minimum_required_size_for_literal(literal->as.integer);
-				node->type = Type::Integer(literal_size);
-				typechecked_node = node;
-			} break;
-			case AST_Kind::Literal_Floating_Point: {
-				AST_Literal *literal = dynamic_cast<AST_Literal *>(node);
-				internal_verify(literal, "Failed to cast to `AST_Literal *`");
+		typed_arena.release();
+		typed = nullptr;
 
-				Size literal_size = minimum_required_size_for_literal(literal->as.floating_point);
-				node->type = Type::Floating_Point(literal_size);
-				typechecked_node = node;
-			} break;
-			case AST_Kind::Literal_String: {
-				node->type = Type::String();
-				typechecked_node = node;
-			} break;
+		if (compiled) {
+			snapshot = parse.flatten();
+			typed = ast_cast<AST_Block>(unflatten(typed_arena, snapshot, snapshot.root));
 
-			case AST_Kind::Unary_Not: {
-				AST_Unary *unary = dynamic_cast<AST_Unary *>(node);
-				internal_verify(unary, "Failed to cast to `AST_Unary *`");
+			auto result = typecheck(typed, pool);
+			if (result.is_err()) {
+				result.err()->print(errors);
+				typed = nullptr;
+				compiled = false;
+			}
+		}
 
-				unary->sub = try_(typecheck(unary->sub));
-				verify(unary->sub->type->kind == Type_Kind::Boolean, unary->sub->location, "Type mismatch! `!` expects `%s` but was given `%s`", Type::Boolean().display_str().c_str(), unary->sub->type->display_str().c_str());
+		fclose(errors);
+		diagnostics.assign(buffer, size);
+		::free(buffer);
+		return true;
+	}
 
-				unary->type = Type::Boolean();
-				typechecked_node = unary;
-			} break;
-			case AST_Kind::Unary_Negate: {
-				AST_Unary *unary = dynamic_cast<AST_Unary *>(node);
-				internal_verify(unary, "Failed to cast to `AST_Unary *`");
+	// A diagnostic as the command line compiler would print it.
+	//
+	static std::string describe(Diagnostic *diagnostic) {
+		char *buffer = nullptr;
+		size_t size = 0;
+		FILE *out = open_memstream(&buffer, &size);
+		internal_verify(out, "Could not buffer a diagnostic!");
 
-				unary->sub = try_(typecheck(unary->sub));
-				verify(
-					unary->sub->type->kind == Type_Kind::Integer || unary->sub->type->kind == Type_Kind::Floating_Point,
-					unary->sub->location,
-					"Type mismatch! `-` expects its argument to be a numeric value but was given `%s`",
-					unary->sub->type->display_str().c_str()
-				);
+		diagnostic->print(out);
+		fclose(out);
 
-				unary->type = unary->sub->type;
-				typechecked_node = unary;
-			} break;
+		std::string text(buffer, size);
+		::free(buffer);
+		return text;
+	}
 
-			case AST_Kind::Binary_Variable_Declaration: {
-				todo("Not yet implemented!");
-			} break;
-			case AST_Kind::Binary_Assignment: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+private:
+	// Reads the file unless it's the same one as last time, in which case
+	// the result is false.
+	//
+	Result<bool> read_text(struct stat &info, std::vector<char> &out) {
+		int fd = open(path.c_str(), O_RDONLY);
+		verify(fd >= 0, "'%s' could not be opened.", path.c_str());
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+			close(fd);
+			error("'%s' is not a regular file.", path.c_str());
+		}
 
-				// @TODO:
-				// :TypeEquality
-				//
-				verify(binary->lhs->type->kind == binary->rhs->type->kind, binary->rhs->location, "Type mismatch! Cannot assign `%s` to `%s`", binary->rhs->type->display_str().c_str(), binary->lhs->type->display_str().c_str());
+		if (unchanged(info)) {
+			close(fd);
+			return false;
+		}
 
-				binary->type = Type { Type_Kind::No_Type };
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_While: {
-				AST_Binary *binary = dynamic_cast<AST_Binary *>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		if (static_cast<uint64_t>(info.st_size) > std::numeric_limits<uint32_t>::max()) {
+			close(fd);
+			error("'%s' is larger than 4GB.", path.c_str());
+		}
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				verify(binary->lhs->type->kind == Type_Kind::Boolean, binary->lhs->location, "Type mismatch! Expected boolean expression as condition to `while` statement but found `%s`.", binary->lhs->type->display_str().c_str());
+		out.resize(info.st_size);
+		size_t done = 0;
+		while (done < out.size()) {
+			ssize_t n = ::read(fd, out.data() + done, out.size() - done);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) break;
+			done += n;
+		}
+		close(fd);
 
-				binary->rhs = try_(typecheck(binary->rhs));
+		out.resize(done);
+		return true;
+	}
 
-				binary->type = Type { Type_Kind::No_Type };
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_Add: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+	// The single edit turning `text` into `source`: whatever lies between
+	// their common prefix and common suffix.
+	//
+	Text_Edit difference(String source) const {
+		size_t limit = std::min(text.size(), source.size);
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+		size_t prefix = 0;
+		while (prefix < limit && text[prefix] == source.chars[prefix]) prefix++;
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Integer || binary->lhs->type->kind ==Type_Kind::Floating_Point,
-					binary->lhs->location,
-					"Type mismatch! `+` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Integer || binary->rhs->type->kind ==Type_Kind::Floating_Point,
-					binary->rhs->location,
-					"Type mismatch! `+` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `+` expects its arguments to be the same type. `%s` vs. `%s`",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+		size_t suffix = 0;
+		while (suffix < limit - prefix && text[text.size() - 1 - suffix] == source.chars[source.size - 1 - suffix]) suffix++;
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_Subtract: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		return Text_Edit {
+			static_cast<uint32_t>(prefix),
+			static_cast<uint32_t>(text.size() - prefix - suffix),
+			String { source.size - prefix - suffix, source.chars + prefix },
+		};
+	}
+};
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+// Answers "check these files" over a Unix socket, keeping every file's
+// trees resident (along with the interned symbols and types, which live for
+// the whole process anyway) so unchanged files cost a `stat`.
+//
+// A request is one path per line, ended by an empty line or by the client
+// shutting down its side. The reply has a line per path, `ok <path>` or
+// `failed <path>`, each followed by that file's diagnostics exactly as the
+// command line compiler would print them. The server closes the connection
+// once it has answered. Clients are answered one at a time, so one that
+// stalls for longer than `Client_Timeout` is dropped instead of waited on.
+//
+// Paths that can't be opened are answered without being kept. Once more
+// than `Max_Resident_Files` are kept, the ones asked for least recently
+// are dropped and their file IDs go to the next new paths.
+//
+struct Compile_Server {
+	static constexpr int Client_Timeout = 5; // seconds
+	static constexpr size_t Max_Resident_Files = 4096;
+
+	Thread_Pool *pool = nullptr;
+	bool print_stats = false;
+	std::unordered_map<std::string, std::unique_ptr<Server_File>> files;
+	std::vector<File_ID> free_ids;
+	uint64_t requests = 0;
+
+	Result<void> serve(const char *socket_path) {
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		verify(strlen(socket_path) < sizeof(address.sun_path), "Socket path '%s' is too long.", socket_path);
+		strcpy(address.sun_path, socket_path);
+
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		verify(listener >= 0, "Could not create a socket.");
+
+		unlink(socket_path);
+		if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+			close(listener);
+			error("Could not listen on '%s'.", socket_path);
+		}
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Integer || binary->lhs->type->kind ==Type_Kind::Floating_Point,
-					binary->lhs->location,
-					"Type mismatch! `-` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Integer || binary->rhs->type->kind ==Type_Kind::Floating_Point,
-					binary->rhs->location,
-					"Type mismatch! `-` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `-` expects its arguments to be the same type. `%s` vs. `%s`",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+		// A client hanging up early mustn't take the server with it.
+		signal(SIGPIPE, SIG_IGN);
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_Multiply: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		while (true) {
+			int client = accept(listener, nullptr, nullptr);
+			if (client < 0) {
+				if (errno == EINTR || errno == ECONNABORTED) continue;
+				close(listener);
+				error("Could not accept connections on '%s'.", socket_path);
+			}
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+			timeval timeout = { Client_Timeout, 0 };
+			setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Integer || binary->lhs->type->kind ==Type_Kind::Floating_Point,
-					binary->lhs->location,
-					"Type mismatch! `*` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Integer || binary->rhs->type->kind ==Type_Kind::Floating_Point,
-					binary->rhs->location,
-					"Type mismatch! `*` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `*` expects its arguments to be the same type. `%s` vs. `%s`",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+			answer(client);
+			close(client);
+		}
+	}
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_Divide: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+	void answer(int client) {
+		auto start = std::chrono::steady_clock::now();
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+		std::vector<std::string> paths;
+		if (!read_request(client, paths)) {
+			if (print_stats) fprintf(stderr, "dropped a client that stalled or failed mid-request\n");
+			return;
+		}
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Integer || binary->lhs->type->kind ==Type_Kind::Floating_Point,
-					binary->lhs->location,
-					"Type mismatch! `/` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Integer || binary->rhs->type->kind ==Type_Kind::Floating_Point,
-					binary->rhs->location,
-					"Type mismatch! `/` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `/` expects its arguments to be the same type. `%s` vs. `%s`",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+		requests++;
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_And: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		// A null entry is a path that couldn't be opened; `unopened` has
+		// what to say about it.
+		std::vector<Server_File *> requested;
+		std::vector<std::string> unopened(paths.size());
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+		for (size_t i = 0; i < paths.size(); i++) {
+			const std::string &path = paths[i];
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Boolean,
-					binary->lhs->location,
-					"Type mismatch! `&&` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Boolean,
-					binary->rhs->location,
-					"Type mismatch! `&&` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `&&` expects its arguments to be `%s`",
-					Type::Boolean().display_str().c_str()
-				);
+			auto found = files.find(path);
+			if (found == files.end()) {
+				struct stat info;
+				if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+					unopened[i] = Server_File::describe(error_impl("'%s' could not be opened.", path.c_str()));
+					requested.push_back(nullptr);
+					continue;
+				}
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_Or: {
-				AST_Binary *binary = dynamic_cast<AST_Binary*>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+				found = files.emplace(path, open_file(path)).first;
+			}
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+			found->second->last_request = requests;
+			requested.push_back(found->second.get());
+		}
 
-				verify(
-					binary->lhs->type->kind == Type_Kind::Boolean,
-					binary->lhs->location,
-					"Type mismatch! `||` expects its arguments to be numeric values but was given `%s`",
-					binary->lhs->type->display_str().c_str()
-				);
-				verify(
-					binary->rhs->type->kind == Type_Kind::Boolean,
-					binary->rhs->location,
-					"Type mismatch! `||` expects its arguments to be numeric values but was given `%s`",
-					binary->rhs->type->display_str().c_str()
-				);
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `||` expects its arguments to be `%s`",
-					Type::Boolean().display_str().c_str()
-				);
+		// Each file is checked once however often it was asked for.
+		//
+		std::vector<Task_Group> checks(requested.size());
+		std::vector<char> changed(requested.size(), false);
 
-				binary->type = binary->lhs->type;
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_EQ: {
-				AST_Binary *binary = dynamic_cast<AST_Binary *>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		std::unordered_map<Server_File *, size_t> first;
+		for (size_t i = 0; i < requested.size(); i++) {
+			if (!requested[i] || !first.emplace(requested[i], i).second) continue;
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+			Server_File *file = requested[i];
+			char *result = &changed[i];
+			pool->submit(checks[i], [this, file, result]() { *result = file->check(pool); });
+		}
 
-				// @TODO:
-				// :TypeEquality
-				//
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `==` expects its arguments to be the same type! `%s` vs. `%s`.",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+		std::string reply;
+		size_t rechecked = 0;
 
-				binary->type = Type::Boolean();
-				typechecked_node = binary;
-			} break;
-			case AST_Kind::Binary_NE: {
-				AST_Binary *binary = dynamic_cast<AST_Binary *>(node);
-				internal_verify(binary, "Failed to cast to `AST_Binary *`");
+		for (size_t i = 0; i < requested.size(); i++) {
+			Server_File *file = requested[i];
+			if (!file) {
+				reply += "failed " + paths[i] + '\n' + unopened[i];
+				continue;
+			}
 
-				binary->lhs = try_(typecheck(binary->lhs));
-				binary->rhs = try_(typecheck(binary->rhs));
+			pool->wait(checks[i]);
+			rechecked += changed[i];
 
-				// @TODO:
-				// :TypeEquality
-				//
-				verify(
-					binary->lhs->type->kind == binary->rhs->type->kind,
-					binary->location,
-					"Type mismatch! `!=` expects its arguments to be the same type! `%s` vs. `%s`.",
-					binary->lhs->type->display_str().c_str(),
-					binary->rhs->type->display_str().c_str()
-				);
+			reply += file->compiled ? "ok " : "failed ";
+			reply += file->path;
+			reply += '\n';
+			reply += file->diagnostics;
+		}
 
-				binary->type = Type::Boolean();
-				typechecked_node = binary;
-			} break;
+		write_all(client, reply.data(), reply.size());
 
-			case AST_Kind::Block: {
-				AST_Block *block = dynamic_cast<AST_Block *>(node);
-				internal_verify(block, "Failed to cast to `AST_Block *`");
+		// Every check is done and kept its diagnostics as text, so nothing
+		// points into the diagnostic arenas until the next request.
+		//
+		release_diagnostics();
+		evict();
 
-				begin_scope();
-				for (size_t i = 0; i < block->nodes.size(); i++) {
-					block->nodes[i] = try_(typecheck(block->nodes[i]));
-				}
-				end_scope();
+		if (print_stats) {
+			auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+			fprintf(stderr, "answered %zu file(s), %zu rechecked, %zu resident, in %.3f ms\n", requested.size(), rechecked, files.size(), elapsed.count());
+		}
+	}
 
-				block->type = Type { Type_Kind::No_Type };
-				typechecked_node = block;
-			} break;
+private:
+	std::unique_ptr<Server_File> open_file(const std::string &path) {
+		auto entry = std::make_unique<Server_File>();
+		entry->path = path;
 
-			case AST_Kind::Variable_Instantiation: {
-				AST_Variable_Instantiation *inst = dynamic_cast<AST_Variable_Instantiation *>(node);
-				internal_verify(inst, "Failed to cast to `AST_Variable_Instantiation *`");
+		if (free_ids.empty()) {
+			entry->file = source_files.add(path.c_str(), String { 0, nullptr });
+		} else {
+			entry->file = free_ids.back();
+			free_ids.pop_back();
+			source_files.reuse(entry->file, path.c_str());
+		}
 
-				AST_Symbol *symbol = inst->symbol;
-				symbol->type = Type { Type_Kind::No_Type };
+		entry->parse.arena = &entry->parse_arena;
+		entry->parse.file = entry->file;
+		return entry;
+	}
 
-				Type inst_type;
-				if (inst->specified_type_signature) {
-					todo("Implement typechecking for var-insts with specified_type_signature.");
-				} else {
-					inst->initializer = try_(typecheck(inst->initializer));
-					inst_type = inst->initializer->type.value();
-				}
+	void drop(std::unordered_map<std::string, std::unique_ptr<Server_File>>::iterator it) {
+		File_ID id = it->second->file;
+		files.erase(it);
 
-				bind_variable(inst->location, symbol->symbol.str(), inst_type);
+		source_files.reuse(id, "");
+		free_ids.push_back(id);
+	}
 
-				inst->type = Type { Type_Kind::No_Type };
-				typechecked_node = inst;
-			} break;
-			case AST_Kind::Constant_Instantiation: {
-				todo("Implement typechecking constant declaration!");
-			} break;
+	// Drops files that have gone away, then, if too many are still kept,
+	// the ones asked for least recently. Files from the request just
+	// answered are only dropped if they've gone away.
+	//
+	void evict() {
+		for (auto it = files.begin(); it != files.end();) {
+			auto next = std::next(it);
+			if (!it->second->loaded) drop(it);
+			it = next;
+		}
 
-			case AST_Kind::If: {
-				AST_If *if_ = dynamic_cast<AST_If *>(node);
-				internal_verify(if_, "Failed to cast to `AST_If *`");
+		if (files.size() <= Max_Resident_Files) return;
 
-				if_->condition = try_(typecheck(if_->condition));
-				verify(
-					if_->condition->type->kind == Type_Kind::Boolean, 
-					if_->condition->location, 
-					"Type mismatch! Expected boolean expression as conditional of `if` statement but expression evaluates to `%s`", 
-					if_->condition->type->display_str().c_str()
-				);
+		std::vector<std::pair<uint64_t, std::string>> by_age;
+		by_age.reserve(files.size());
+		for (auto &[path, file] : files) {
+			if (file->last_request != requests) by_age.emplace_back(file->last_request, path);
+		}
+		std::sort(by_age.begin(), by_age.end());
 
-				if_->then_block = try_(typecheck(if_->then_block));
-				if (if_->else_block) if_->else_block = try_(typecheck(if_->else_block));
+		// Down to three quarters, so the sort isn't paid for every request.
+		size_t excess = files.size() - Max_Resident_Files * 3 / 4;
+		for (size_t i = 0; i < by_age.size() && i < excess; i++) {
+			drop(files.find(by_age[i].second));
+		}
+	}
 
-				if_->type = Type { Type_Kind::No_Type };
-				typechecked_node = if_;
-			} break;
+	// Reads a request into `paths`. Fails if the client times out or the
+	// connection breaks before the request is complete.
+	//
+	static bool read_request(int client, std::vector<std::string> &paths) {
+		std::string line;
+		char buffer[4096];
 
-			default:
-				internal_error("Unhandled AST_Kind: %s!", debug_str(node->kind).c_str());
+		while (true) {
+			ssize_t n = read(client, buffer, sizeof(buffer));
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0) return false;
+			if (n == 0) break;
+
+			for (ssize_t i = 0; i < n; i++) {
+				if (buffer[i] != '\n') {
+					line += buffer[i];
+				} else if (line.empty()) {
+					return true;
+				} else {
+					paths.push_back(std::move(line));
+					line.clear();
+				}
+			}
 		}
 
-		return typechecked_node;
+		if (!line.empty()) paths.push_back(std::move(line));
+		return true;
 	}
 };
 
-Result<AST_Block *> typecheck(AST_Block *ast) {
-	auto t = Typechecker {};
+// Sends `inputs` to the server at `socket_path` and copies its reply to
+// stdout. Paths are made absolute first since the server has its own working
+// directory. Returns whether every file compiled.
+//
+Result<bool> request_check(const char *socket_path, const std::vector<std::string> &inputs) {
+	sockaddr_un address = {};
+	address.sun_family = AF_UNIX;
+	verify(strlen(socket_path) < sizeof(address.sun_path), "Socket path '%s' is too long.", socket_path);
+	strcpy(address.sun_path, socket_path);
+
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	verify(server >= 0, "Could not create a socket.");
+
+	if (connect(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+		close(server);
+		error("Could not connect to a server at '%s'.", socket_path);
+	}
 
-	// @HACK:
-	// This won't be needed when we pass an `Interpreter` or something.
-	//
-	t.parent = nullptr;
-	t.begin_scope();
-	t.global_scope = &t.current_scope();
-	
-	for (size_t i = 0; i < ast->nodes.size(); i++) {
-		ast->nodes[i] = try_(t.typecheck(ast->nodes[i]));
+	std::string request;
+	for (const std::string &input : inputs) {
+		char *absolute = realpath(input.c_str(), nullptr);
+		request += absolute ? absolute : input;
+		request += '\n';
+		::free(absolute);
 	}
+	request += '\n';
 
-	return ast;
-}
+	if (!write_all(server, request.data(), request.size())) {
+		close(server);
+		error("Could not send the request to '%s'.", socket_path);
+	}
 
-//
-//
-// Entry Point
-//
-//
+	// Only the start of each line matters, and a line can be split across
+	// reads, so `line` holds as much of the current one's start as has
+	// arrived.
+	//
+	const std::string Failed = "failed ";
+	bool compiled = true;
+	std::string line;
+	char buffer[4096];
 
-Result<String> read_entire_file(const char *path) {
-	std::ifstream file(path, std::ios::binary | std::ios::ate);
-	verify(file.is_open(), "'%s' could not be opened.", path);
-	
-	std::streamsize size = file.tellg();
-	file.seekg(0, std::ios::beg);
-	
-	auto source = String { static_cast<size_t>(size), reinterpret_cast<char *>(malloc(size)) };
-	file.read(source.chars, size);
-	verify(file.good(), "Could not read from '%s'.", path);
-	
-	return source;
+	while (true) {
+		ssize_t n = read(server, buffer, sizeof(buffer));
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+
+		for (ssize_t i = 0; i < n; i++) {
+			if (buffer[i] == '\n') {
+				line.clear();
+			} else if (line.size() < Failed.size()) {
+				line += buffer[i];
+				if (line == Failed) compiled = false;
+			}
+		}
+		fwrite(buffer, 1, n, stdout);
+	}
+
+	close(server);
+	return compiled;
 }
 
 int main(int argc, const char **argv) {
-	if (argc <= 1) {
+	Compile_Options options;
+	Parse_Cache cache;
+	const char *server_socket = nullptr;
+	const char *connect_socket = nullptr;
+	std::vector<std::string> inputs;
+	size_t jobs = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (strcmp(arg, "--stats") == 0) {
+			options.print_stats = true;
+		} else if (strcmp(arg, "--bench-tokenizer") == 0) {
+			size_t megabytes = 64;
+			if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+				megabytes = strtoull(argv[++i], nullptr, 10);
+			}
+			benchmark_tokenizer(megabytes, false);
+			benchmark_tokenizer(megabytes, true);
+			return 0;
+		} else if (strcmp(arg, "--bench-reparse") == 0) {
+			size_t megabytes = 4;
+			if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+				megabytes = strtoull(argv[++i], nullptr, 10);
+			}
+			benchmark_reparse(megabytes);
+			return 0;
+		} else if (strcmp(arg, "--bench-cache") == 0) {
+			size_t megabytes = 4;
+			if (i + 1 < argc && isdigit(argv[i + 1][0])) {
+				megabytes = strtoull(argv[++i], nullptr, 10);
+			}
+			benchmark_parse_cache(megabytes);
+			return 0;
+		} else if (strcmp(arg, "--bench-jit") == 0) {
+			benchmark_jit();
+			return 0;
+		} else if (strcmp(arg, "--flat-ast") == 0) {
+			options.flat_ast = true;
+		} else if (strcmp(arg, "--run") == 0) {
+			options.run = true;
+		} else if (strcmp(arg, "--eval") == 0) {
+			options.evaluate = true;
+		} else if (strcmp(arg, "--jit") == 0) {
+			options.jit = true;
+		} else if (strcmp(arg, "--emit-c") == 0) {
+			options.emit_c = true;
+		} else if (strcmp(arg, "--emit-obj") == 0) {
+			options.emit_object = true;
+		} else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+			options.output = argv[++i];
+		} else if (strcmp(arg, "--lazy-tokenize") == 0) {
+			options.pretokenize = false;
+		} else if (strcmp(arg, "--stream-buffer") == 0 && i + 1 < argc) {
+			options.stream_capacity = std::max<size_t>(strtoull(argv[++i], nullptr, 10), 1);
+		} else if (strcmp(arg, "--cache-dir") == 0 && i + 1 < argc) {
+			cache.open(argv[++i]).unwrap();
+			options.cache = &cache;
+		} else if (strcmp(arg, "--server") == 0 && i + 1 < argc) {
+			server_socket = argv[++i];
+		} else if (strcmp(arg, "--connect") == 0 && i + 1 < argc) {
+			connect_socket = argv[++i];
+		} else if (strcmp(arg, "--jobs") == 0 && i + 1 < argc) {
+			jobs = std::max<size_t>(strtoull(argv[++i], nullptr, 10), 1);
+		} else if (arg[0] == '-' && arg[1] == '-') {
+			std::cerr << "Unknown option `" << arg << "`." << std::endl;
+			return EXIT_FAILURE;
+		} else {
+			collect_inputs(arg, inputs).unwrap();
+		}
+	}
+
+	if (server_socket) {
+		Thread_Pool pool;
+		pool.start(jobs);
+
+		Compile_Server server;
+		server.pool = &pool;
+		server.print_stats = options.print_stats;
+		server.serve(server_socket).unwrap();
+		return 0;
+	}
+
+	if (inputs.empty()) {
 		std::cerr << "Please provide source file to compile." << std::endl;
 		return EXIT_FAILURE;
 	}
 
-	const char *filename = argv[1];
+	if (connect_socket) {
+		return request_check(connect_socket, inputs).unwrap() ? 0 : EXIT_FAILURE;
+	}
 
-	String source = read_entire_file(filename).unwrap();
-	AST_Block *ast = parse(source, filename);
-	if (!ast) return EXIT_FAILURE;
+	if (options.output && (!(options.emit_c || options.emit_object) || inputs.size() != 1)) {
+		std::cerr << "`-o` builds a single input with `--emit-c` or `--emit-obj`." << std::endl;
+		return EXIT_FAILURE;
+	}
 
-	ast->debug_print();
+	Thread_Pool pool;
+	pool.start(jobs);
+	options.pool = &pool;
 
-	ast = dynamic_cast<AST_Block *>(typecheck(ast).unwrap());
-	internal_verify(ast, "`typecheck()` didn't return an `AST_Block`");
+	std::vector<Compile_Job> batch(inputs.size());
+	for (size_t i = 0; i < inputs.size(); i++) {
+		Compile_Job &job = batch[i];
+		job.path = std::move(inputs[i]);
+		job.unbuffered = inputs.size() == 1;
+		pool.submit(job.done, [&job, &options]() { job.run(options); });
+	}
 
-	ast->debug_print();
+	bool compiled = true;
+	for (Compile_Job &job : batch) {
+		pool.wait(job.done);
+		job.flush();
+		compiled &= job.compiled;
+	}
 
-	source.free();
-	return 0;
+	return compiled ? 0 : EXIT_FAILURE;
 }